@@ -43,6 +43,10 @@ struct ClientChannel::Impl : public pva::ChannelRequester,
     listeners_t listeners;
     bool listeners_inprogress;
     epicsEvent listeners_done;
+    // set by ClientProvider::connect().  NULL for Inline
+    std::tr1::shared_ptr<detail::Executor> executor;
+    // connection events, and operations when Serial
+    std::tr1::shared_ptr<detail::Strand> strand;
 
     static size_t num_instances;
 
@@ -67,6 +71,22 @@ struct ClientChannel::Impl : public pva::ChannelRequester,
     virtual void channelCreated(const pvd::Status& status, pva::Channel::shared_pointer const & channel) OVERRIDE FINAL {}
 
     virtual void channelStateChange(pva::Channel::shared_pointer const & channel, pva::Channel::ConnectionState connectionState) OVERRIDE FINAL
+    {
+        std::tr1::shared_ptr<detail::Strand> S;
+        {
+            Guard G(mutex);
+            S = strand;
+        }
+        ConnectEvent evt;
+        evt.connected = connectionState==pva::Channel::CONNECTED;
+        if(evt.connected)
+            evt.peerName = channel->getRemoteAddress();
+
+        if(!detail::defer(S, *this, evt))
+            deliver(evt);
+    }
+
+    void deliver(const ConnectEvent& evt)
     {
         listeners_t notify;
         {
@@ -75,10 +95,6 @@ struct ClientChannel::Impl : public pva::ChannelRequester,
             listeners_inprogress = true;
         }
         try {
-            ConnectEvent evt;
-            evt.connected = connectionState==pva::Channel::CONNECTED;
-            if(evt.connected)
-                evt.peerName = channel->getRemoteAddress();
             for(listeners_t::const_iterator it=notify.begin(), end=notify.end(); it!=end; ++it)
             {
                 try {
@@ -226,23 +242,41 @@ void register_reftrack()
     pvac::detail::registerRefTrackMonitor();
     pvac::detail::registerRefTrackRPC();
     pvac::detail::registerRefTrackInfo();
+    pvac::detail::registerRefTrackExecutor();
+    pvac::detail::registerRefTrackMany();
 }
 
 std::tr1::shared_ptr<epics::pvAccess::Channel>
 ClientChannel::getChannel()
 { return impl->channel; }
 
+std::tr1::shared_ptr<detail::Strand>
+ClientChannel::operationStrand()
+{
+    Guard G(impl->mutex);
+    if(impl->executor && impl->executor->mode==ClientProvider::Pool)
+        return std::tr1::shared_ptr<detail::Strand>(new detail::Strand(impl->executor));
+    return impl->strand;
+}
+
 struct ClientProvider::Impl
 {
     static size_t num_instances;
     Impl() {register_reftrack(); REFTRACE_INCREMENT(num_instances);}
-    ~Impl() {REFTRACE_DECREMENT(num_instances);}
+    ~Impl() {
+        // callbacks of channels still in use are now made Inline
+        if(executor)
+            executor->close();
+        REFTRACE_DECREMENT(num_instances);
+    }
 
     pva::ChannelProvider::shared_pointer provider;
 
     epicsMutex mutex;
     typedef std::map<std::pair<std::string, ClientChannel::Options>, std::tr1::weak_ptr<ClientChannel::Impl> > channels_t;
     channels_t channels;
+    // NULL for Inline
+    std::tr1::shared_ptr<detail::Executor> executor;
 };
 
 size_t ClientProvider::Impl::num_instances;
@@ -264,13 +298,17 @@ ClientProvider::ClientProvider(const std::string& providerName,
         name = providerName;
         reg = pva::ChannelProviderRegistry::clients();
     }
-    impl->provider = reg->createProvider(name,
-                                         conf ? conf : pva::ConfigurationBuilder()
-                                                .push_env()
-                                                .build());
+    pva::Configuration::shared_pointer C(conf ? conf : pva::ConfigurationBuilder()
+                                                       .push_env()
+                                                       .build());
+    impl->provider = reg->createProvider(name, C);
 
     if(!impl->provider)
         THROW_EXCEPTION2(std::invalid_argument, providerName);
+
+    const int nthreads = C->getPropertyAsInteger("EPICS_PVA_CALLBACK_THREADS", 0);
+    if(nthreads>0)
+        setExecutor(C->getPropertyAsBoolean("EPICS_PVA_CALLBACK_SERIAL", true) ? Serial : Pool, nthreads);
 }
 
 ClientProvider::ClientProvider(const std::tr1::shared_ptr<epics::pvAccess::ChannelProvider>& provider)
@@ -310,6 +348,11 @@ ClientProvider::connect(const std::string& name,
     // cache miss
     ClientChannel ret(impl->provider, name, conf);
     impl->channels[K] = ret.impl;
+    if(impl->executor) {
+        Guard G2(ret.impl->mutex);
+        ret.impl->executor = impl->executor;
+        ret.impl->strand.reset(new detail::Strand(impl->executor));
+    }
     return ret;
 }
 
@@ -333,6 +376,38 @@ void ClientProvider::disconnect()
     impl->channels.clear();
 }
 
+void ClientProvider::setExecutor(Dispatch mode, unsigned nthreads)
+{
+    if(!impl) throw std::logic_error("Dead Provider");
+
+    std::tr1::shared_ptr<detail::Executor> E;
+    if(mode!=Inline) {
+        E.reset(new detail::Executor(mode, nthreads));
+        E->start();
+    }
+    {
+        Guard G(impl->mutex);
+        impl->executor.swap(E);
+    }
+    if(E)
+        E->close(); // previous
+}
+
+bool ClientProvider::executorStats(ExecutorStats& stats) const
+{
+    if(!impl) throw std::logic_error("Dead Provider");
+    std::tr1::shared_ptr<detail::Executor> E;
+    {
+        Guard G(impl->mutex);
+        E = impl->executor;
+    }
+    if(E)
+        E->stats(stats);
+    else
+        stats = ExecutorStats();
+    return !!E;
+}
+
 ::std::ostream& operator<<(::std::ostream& strm, const Operation& op)
 {
     if(op.impl) {
@@ -0,0 +1,278 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <sstream>
+#include <algorithm>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsAtomic.h>
+
+#include <pv/thread.h>
+#include <pv/reftrack.h>
+
+#define epicsExportSharedSymbols
+#include "pv/logger.h"
+#include "clientpvt.h"
+
+namespace pvac {
+
+ClientProvider::ExecutorStats::ExecutorStats()
+    :nthreads(0u)
+    ,nqueued(0u)
+    ,maxQueued(0u)
+    ,ncompleted(0u)
+    ,nstolen(0u)
+    ,waitTotal(0.0)
+    ,waitMax(0.0)
+{}
+
+namespace detail {
+
+namespace {
+// max. tasks of one Strand run before giving others a turn
+const size_t strandBatch = 8u;
+
+size_t num_executors;
+}
+
+struct Executor::Worker {
+    Executor * const owner;
+    // transferred to run(), which keeps owner alive until the worker exits
+    std::tr1::shared_ptr<Executor> keepalive;
+
+    // guards ready
+    epicsMutex mutex;
+    // Strands waiting.  Pop from the front, steal from the back.
+    std::deque<std::tr1::shared_ptr<Strand> > ready;
+
+    epics::auto_ptr<epics::pvData::Thread> thread;
+
+    explicit Worker(Executor *owner) :owner(owner) {}
+    void run() { owner->run(*this); }
+};
+
+Strand::~Strand()
+{
+    // normally empty as each Task holds a reference to an operation which holds us
+    for(size_t i=0; i<tasks.size(); i++)
+        delete tasks[i];
+}
+
+bool Strand::post(Task *task)
+{
+    epicsTimeGetCurrent(&task->queued);
+    bool wasScheduled = false, rejected;
+    {
+        Guard G(mutex);
+        {
+            Guard G2(executor->mutex);
+            // a Strand already scheduled will still be drained by its worker
+            rejected = executor->closing && !scheduled;
+            if(!rejected) {
+                ClientProvider::ExecutorStats& C = executor->counters;
+                C.nqueued++;
+                C.maxQueued = std::max(C.maxQueued, C.nqueued);
+            }
+        }
+        if(!rejected) {
+            tasks.push_back(task);
+            wasScheduled = scheduled;
+            scheduled = true;
+        }
+    }
+    if(rejected) {
+        delete task;
+        return false;
+    } else if(!wasScheduled)
+        executor->schedule(shared_from_this(), 0);
+    return true;
+}
+
+Executor::Executor(ClientProvider::Dispatch mode, unsigned nthreads)
+    :mode(mode)
+    ,nextWorker(0u)
+    ,closing(false)
+{
+    if(nthreads==0u)
+        nthreads = std::max(1, epicsThreadGetCPUs());
+    workers.reserve(nthreads);
+    for(unsigned i=0; i<nthreads; i++)
+        workers.push_back(new Worker(this));
+    counters.nthreads = nthreads;
+    REFTRACE_INCREMENT(num_executors);
+}
+
+Executor::~Executor()
+{
+    close();
+    // join, except when the last reference was released by a worker
+    for(size_t i=0; i<workers.size(); i++)
+        delete workers[i];
+    REFTRACE_DECREMENT(num_executors);
+}
+
+void Executor::start()
+{
+    for(size_t i=0; i<workers.size(); i++) {
+        std::ostringstream name;
+        name<<"pvac-cb-"<<i;
+        Worker *W = workers[i];
+        W->keepalive = shared_from_this();
+        W->thread.reset(new epics::pvData::Thread(
+                            epics::pvData::Thread::Config(W, &Worker::run)
+                            .prio(epicsThreadPriorityMedium)
+                            .name(name.str())
+                            .stack(epicsThreadStackBig)));
+    }
+}
+
+void Executor::close()
+{
+    {
+        Guard G(mutex);
+        if(closing)
+            return;
+        closing = true;
+    }
+    wakeup.signal();
+
+    for(size_t i=0; i<workers.size(); i++) {
+        epics::pvData::Thread *T = workers[i]->thread.get();
+        // when called from a callback, our own worker exits after it returns
+        if(T && !T->isCurrentThread())
+            T->exitWait();
+    }
+}
+
+void Executor::stats(ClientProvider::ExecutorStats& ret) const
+{
+    Guard G(mutex);
+    ret = counters;
+}
+
+void Executor::schedule(const std::tr1::shared_ptr<Strand>& strand, Worker *self)
+{
+    Worker *W = self;
+    if(!W) {
+        Guard G(mutex);
+        W = workers[nextWorker++ % workers.size()];
+    }
+    {
+        Guard G(W->mutex);
+        W->ready.push_back(strand);
+    }
+    // any idle worker may take it
+    wakeup.signal();
+}
+
+std::tr1::shared_ptr<Strand> Executor::next(Worker& self)
+{
+    std::tr1::shared_ptr<Strand> ret;
+    bool more = false;
+    {
+        Guard G(self.mutex);
+        if(!self.ready.empty()) {
+            ret.swap(self.ready.front());
+            self.ready.pop_front();
+            more = !self.ready.empty();
+        }
+    }
+
+    for(size_t i=0; !ret && i<workers.size(); i++) {
+        Worker *W = workers[i];
+        if(W==&self)
+            continue;
+        Guard G(W->mutex);
+        if(!W->ready.empty()) {
+            ret.swap(W->ready.back());
+            W->ready.pop_back();
+            more = !W->ready.empty();
+
+            Guard G2(mutex);
+            counters.nstolen++;
+        }
+    }
+
+    if(more)
+        wakeup.signal(); // maybe work for another idle worker
+    return ret;
+}
+
+void Executor::run(Worker& self)
+{
+    // may be the last reference
+    std::tr1::shared_ptr<Executor> keep;
+    keep.swap(self.keepalive);
+
+    while(true) {
+        std::tr1::shared_ptr<Strand> strand(next(self));
+        if(!strand) {
+            {
+                Guard G(mutex);
+                if(closing)
+                    break;
+            }
+            wakeup.wait();
+            continue;
+        }
+
+        bool resched = false;
+        for(size_t n=0u; true; n++) {
+            Task *task;
+            {
+                Guard G(strand->mutex);
+                if(strand->tasks.empty()) {
+                    strand->scheduled = false;
+                    break;
+                } else if(n==strandBatch) {
+                    resched = true;
+                    break;
+                }
+                task = strand->tasks.front();
+                strand->tasks.pop_front();
+            }
+
+            epicsTimeStamp now;
+            epicsTimeGetCurrent(&now);
+            const double wait = epicsTimeDiffInSeconds(&now, &task->queued);
+            {
+                Guard G(mutex);
+                counters.nqueued--;
+                counters.waitTotal += wait;
+                counters.waitMax = std::max(counters.waitMax, wait);
+            }
+
+            try {
+                task->run();
+            }catch(std::exception& e){
+                LOG(pva::logLevelError, "Unhandled exception from client callback: %s", e.what());
+            }
+            delete task;
+
+            {
+                Guard G(mutex);
+                counters.ncompleted++;
+            }
+        }
+
+        if(resched)
+            schedule(strand, &self);
+    }
+
+    // pass on to the next worker
+    wakeup.signal();
+}
+
+void registerRefTrackExecutor()
+{
+    epics::registerRefCounter("pvac::detail::Executor", &num_executors);
+}
+
+} // namespace detail
+} // namespace pvac
@@ -31,6 +31,8 @@ struct Getter : public pvac::detail::CallbackStorage,
 
     pvac::ClientChannel::GetCallback *cb;
     pvac::GetEvent event;
+    // NULL to call cb from the receiving thread
+    std::tr1::shared_ptr<pvac::detail::Strand> strand;
 
     static size_t num_instances;
 
@@ -58,6 +60,24 @@ struct Getter : public pvac::detail::CallbackStorage,
         }
     }
 
+    // callEvent() now, or later from strand
+    void postEvent(CallbackGuard& G, pvac::GetEvent::event_t evt = pvac::GetEvent::Fail)
+    {
+        if(!cb) return;
+
+        event.event = evt;
+        if(!pvac::detail::defer(strand, *this, event))
+            callEvent(G, evt);
+    }
+
+    void deliver(const pvac::GetEvent& evt)
+    {
+        CallbackGuard G(*this);
+        if(!cb) return; // cancelled while queued
+        event = evt;
+        callEvent(G, evt.event);
+    }
+
     virtual std::string name() const OVERRIDE FINAL
     {
         Guard G(mutex);
@@ -96,7 +116,7 @@ struct Getter : public pvac::detail::CallbackStorage,
             event.message.clear();
         }
         if(!status.isSuccess()) {
-            callEvent(G);
+            postEvent(G);
 
         } else {
             channelGet->get();
@@ -106,10 +126,12 @@ struct Getter : public pvac::detail::CallbackStorage,
 
     virtual void channelDisconnect(bool destroy) OVERRIDE FINAL
     {
+        std::tr1::shared_ptr<Getter> keepalive(internal_shared_from_this());
         CallbackGuard G(*this);
+        if(!cb) return;
         event.message = "Disconnect";
 
-        callEvent(G);
+        postEvent(G);
     }
 
     virtual void getDone(
@@ -130,7 +152,7 @@ struct Getter : public pvac::detail::CallbackStorage,
         event.value = pvStructure;
         event.valid = bitSet;
 
-        callEvent(G, status.isSuccess()? pvac::GetEvent::Success : pvac::GetEvent::Fail);
+        postEvent(G, status.isSuccess()? pvac::GetEvent::Success : pvac::GetEvent::Fail);
     }
 
     virtual void show(std::ostream &strm) const OVERRIDE FINAL
@@ -156,6 +178,7 @@ ClientChannel::get(ClientChannel::GetCallback* cb,
         pvRequest = pvd::createRequest("field()");
 
     std::tr1::shared_ptr<Getter> ret(Getter::build(cb));
+    ret->strand = operationStrand();
 
     {
         Guard G(ret->mutex);
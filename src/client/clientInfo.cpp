@@ -29,6 +29,8 @@ struct Infoer : public pvac::detail::CallbackStorage,
 {
     pvac::ClientChannel::InfoCallback *cb;
     const pva::Channel::shared_pointer channel;
+    // NULL to call cb from the receiving thread
+    std::tr1::shared_ptr<pvac::detail::Strand> strand;
 
     static size_t num_instances;
 
@@ -52,19 +54,31 @@ struct Infoer : public pvac::detail::CallbackStorage,
     virtual void getDone(
         const pvd::Status& status,
         pvd::FieldConstPtr const & field) OVERRIDE FINAL
+    {
+        pvac::InfoEvent evt;
+        evt.event = status.isSuccess() ? pvac::InfoEvent::Success : pvac::InfoEvent::Fail;
+        evt.message = status.getMessage();
+        evt.type = field;
+
+        std::tr1::shared_ptr<pvac::detail::Strand> S;
+        {
+            Guard G(mutex);
+            if(!cb) return;
+            S = strand;
+        }
+        if(!pvac::detail::defer(S, *this, evt))
+            deliver(evt);
+    }
+
+    void deliver(const pvac::InfoEvent& evt)
     {
         CallbackGuard G(*this);
         pvac::ClientChannel::InfoCallback *C(cb);
         cb = 0;
         if(C) {
-            pvac::InfoEvent evt;
-            evt.event = status.isSuccess() ? pvac::InfoEvent::Success : pvac::InfoEvent::Fail;
-            evt.message = status.getMessage();
-            evt.type = field;
             CallbackUse U(G);
             C->infoDone(evt);
         }
-        pvac::InfoEvent evt;
     }
 
     virtual std::string name() const OVERRIDE FINAL { return channel->getChannelName(); }
@@ -101,6 +115,7 @@ Operation ClientChannel::info(InfoCallback *cb, const std::string& subfld)
     if(!impl) throw std::logic_error("Dead Channel");
 
     std::tr1::shared_ptr<Infoer> ret(Infoer::build(cb, getChannel()));
+    ret->strand = operationStrand();
 
     {
         Guard G(ret->mutex);
@@ -0,0 +1,322 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <sstream>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include <pv/current_function.h>
+#include <pv/pvData.h>
+#include <pv/bitSet.h>
+#include <pv/reftrack.h>
+
+#define epicsExportSharedSymbols
+#include "pv/logger.h"
+#include "clientpvt.h"
+#include "pv/pvAccess.h"
+
+namespace {
+using pvac::detail::CallbackGuard;
+using pvac::detail::CallbackUse;
+
+/* Common to getMany() and putMany().
+ *
+ * One Entry for each PV, which is the callback of one ClientChannel Operation.
+ * The aggregate callback is made once, by whichever Entry completes last.
+ * cancel() cancels all Operations, whose Cancel events complete the rest.
+ */
+template<typename Derived, typename Event, typename Entry>
+struct Many : public pvac::detail::CallbackStorage,
+              public pvac::Operation::Impl,
+              public pvac::detail::wrapped_shared_from_this<Derived>
+{
+    // guarded by mutex
+    std::vector<pvac::Operation> ops;
+    std::vector<Event> results;
+    size_t npending;
+
+    // const after construction.  Not resized, as each is the callback of an Operation
+    std::vector<Entry> entries;
+
+    explicit Many(size_t count)
+        :ops(count)
+        ,results(count)
+        ,npending(count)
+    {}
+    virtual ~Many() {}
+
+    // call from Derived ctor
+    void setup(Derived *self)
+    {
+        entries.reserve(npending);
+        for(size_t i=0, N=npending; i<N; i++)
+            entries.push_back(Entry(self, i));
+    }
+
+    void done(size_t index, const Event& evt)
+    {
+        CallbackGuard G(*this);
+        if(!npending) return; // paranoia
+
+        results[index] = evt;
+        if(--npending==0u)
+            static_cast<Derived*>(this)->callDone(G);
+    }
+
+    // called with the Operation of the i'th Entry, or an exception which prevented its creation.
+    void issued(size_t index, const pvac::Operation& op)
+    {
+        Guard G(mutex);
+        ops[index] = op;
+    }
+    void failed(size_t index, const std::exception& e)
+    {
+        Event evt;
+        evt.event = Event::Fail;
+        evt.message = e.what();
+        done(index, evt);
+    }
+
+    // called automatically via wrapped_shared_from_this
+    virtual void cancel() OVERRIDE FINAL
+    {
+        // keepalive for safety in case callback wants to destroy us
+        std::tr1::shared_ptr<Derived> keepalive(this->internal_shared_from_this());
+        std::vector<pvac::Operation> cancelling;
+        {
+            Guard G(mutex);
+            cancelling.swap(ops);
+        }
+        // unlocked, as each delivers Cancel to its Entry unless already complete
+        for(size_t i=0; i<cancelling.size(); i++)
+            cancelling[i].cancel();
+
+        CallbackGuard G(*this);
+        G.wait(); // for aggregate callback in progress
+    }
+
+    virtual std::string name() const OVERRIDE FINAL
+    {
+        std::ostringstream strm;
+        strm<<entries.size()<<" PVs";
+        return strm.str();
+    }
+
+    virtual void show(std::ostream &strm) const OVERRIDE FINAL
+    {
+        Guard G(mutex);
+        strm << "Operation(" << Derived::opname() << " " << entries.size() << " PVs, "
+             << npending << " pending)";
+    }
+};
+
+struct GetMany;
+struct GetEntry : public pvac::ClientChannel::GetCallback
+{
+    GetMany *owner;
+    size_t index;
+    GetEntry(GetMany *owner, size_t index) :owner(owner), index(index) {}
+    virtual ~GetEntry() {}
+    virtual void getDone(const pvac::GetEvent& evt) OVERRIDE FINAL;
+};
+
+struct GetMany : public Many<GetMany, pvac::GetEvent, GetEntry>
+{
+    pvac::ClientProvider::GetManyCallback *cb;
+
+    static size_t num_instances;
+
+    GetMany(pvac::ClientProvider::GetManyCallback *cb, size_t count)
+        :Many<GetMany, pvac::GetEvent, GetEntry>(count)
+        ,cb(cb)
+    {
+        setup(this);
+        REFTRACE_INCREMENT(num_instances);
+    }
+    virtual ~GetMany() {
+        CallbackGuard G(*this);
+        cb = 0;
+        G.wait(); // paranoia
+        REFTRACE_DECREMENT(num_instances);
+    }
+
+    static const char* opname() { return "GetMany"; }
+
+    void callDone(CallbackGuard& G)
+    {
+        if(!cb) return;
+
+        pvac::ClientProvider::GetManyCallback *C=cb;
+        cb = 0;
+        CallbackUse U(G);
+        try {
+            C->getManyDone(results);
+        } catch(std::exception& e) {
+            LOG(pva::logLevelInfo, "Lost exception during getManyDone(): %s", e.what());
+        }
+    }
+};
+
+size_t GetMany::num_instances;
+
+void GetEntry::getDone(const pvac::GetEvent& evt) { owner->done(index, evt); }
+
+struct PutMany;
+struct PutEntry : public pvac::ClientChannel::PutCallback
+{
+    PutMany *owner;
+    size_t index;
+    PutEntry(PutMany *owner, size_t index) :owner(owner), index(index) {}
+    virtual ~PutEntry() {}
+    virtual void putBuild(const epics::pvData::StructureConstPtr& build, Args& args) OVERRIDE FINAL;
+    virtual void putDone(const pvac::PutEvent& evt) OVERRIDE FINAL;
+};
+
+struct PutMany : public Many<PutMany, pvac::PutEvent, PutEntry>
+{
+    pvac::ClientProvider::PutManyCallback *cb;
+    const std::vector<pvd::AnyScalar> values;
+
+    static size_t num_instances;
+
+    PutMany(pvac::ClientProvider::PutManyCallback *cb, const std::vector<pvd::AnyScalar>& values)
+        :Many<PutMany, pvac::PutEvent, PutEntry>(values.size())
+        ,cb(cb)
+        ,values(values)
+    {
+        setup(this);
+        REFTRACE_INCREMENT(num_instances);
+    }
+    virtual ~PutMany() {
+        CallbackGuard G(*this);
+        cb = 0;
+        G.wait(); // paranoia
+        REFTRACE_DECREMENT(num_instances);
+    }
+
+    static const char* opname() { return "PutMany"; }
+
+    void callDone(CallbackGuard& G)
+    {
+        if(!cb) return;
+
+        pvac::ClientProvider::PutManyCallback *C=cb;
+        cb = 0;
+        CallbackUse U(G);
+        try {
+            C->putManyDone(results);
+        } catch(std::exception& e) {
+            LOG(pva::logLevelInfo, "Lost exception during putManyDone(): %s", e.what());
+        }
+    }
+};
+
+size_t PutMany::num_instances;
+
+void PutEntry::putBuild(const epics::pvData::StructureConstPtr& build, Args& args)
+{
+    pvd::PVStructurePtr root(pvd::getPVDataCreate()->createPVStructure(build));
+    pvac::detail::putScalar(*root, "value", owner->values[index], true, args.tosend);
+    args.root = root;
+}
+
+void PutEntry::putDone(const pvac::PutEvent& evt) { owner->done(index, evt); }
+
+} //namespace
+
+namespace pvac {
+
+Operation
+ClientProvider::getMany(GetManyCallback* cb,
+                        const std::vector<std::string>& names,
+                        epics::pvData::PVStructure::const_shared_pointer pvRequest)
+{
+    if(!impl) throw std::logic_error("Dead Provider");
+    if(!pvRequest)
+        pvRequest = pvd::createRequest("field()");
+
+    std::tr1::shared_ptr<GetMany> ret(GetMany::build(cb, names.size()));
+
+    // connect all before issuing any request, so that searches, and then requests, go out together
+    std::vector<ClientChannel> channels(names.size());
+    for(size_t i=0; i<names.size(); i++) {
+        try {
+            channels[i] = connect(names[i]);
+        } catch(std::exception& e) {
+            ret->failed(i, e);
+        }
+    }
+
+    for(size_t i=0; i<names.size(); i++) {
+        if(!channels[i])
+            continue;
+        try {
+            ret->issued(i, channels[i].get(&ret->entries[i], pvRequest));
+        } catch(std::exception& e) {
+            ret->failed(i, e);
+        }
+    }
+
+    if(names.empty()) {
+        CallbackGuard G(*ret);
+        ret->callDone(G);
+    }
+
+    return Operation(ret);
+}
+
+Operation
+ClientProvider::putMany(PutManyCallback* cb,
+                        const std::vector<std::string>& names,
+                        const std::vector<epics::pvData::AnyScalar>& values,
+                        epics::pvData::PVStructure::const_shared_pointer pvRequest)
+{
+    if(!impl) throw std::logic_error("Dead Provider");
+    if(names.size()!=values.size())
+        throw std::invalid_argument("putMany() names and values must have the same length");
+    if(!pvRequest)
+        pvRequest = pvd::createRequest("field()");
+
+    std::tr1::shared_ptr<PutMany> ret(PutMany::build(cb, values));
+
+    std::vector<ClientChannel> channels(names.size());
+    for(size_t i=0; i<names.size(); i++) {
+        try {
+            channels[i] = connect(names[i]);
+        } catch(std::exception& e) {
+            ret->failed(i, e);
+        }
+    }
+
+    for(size_t i=0; i<names.size(); i++) {
+        if(!channels[i])
+            continue;
+        try {
+            ret->issued(i, channels[i].put(&ret->entries[i], pvRequest));
+        } catch(std::exception& e) {
+            ret->failed(i, e);
+        }
+    }
+
+    if(names.empty()) {
+        CallbackGuard G(*ret);
+        ret->callDone(G);
+    }
+
+    return Operation(ret);
+}
+
+namespace detail {
+
+void registerRefTrackMany()
+{
+    epics::registerRefCounter("pvac::GetMany", &GetMany::num_instances);
+    epics::registerRefCounter("pvac::PutMany", &PutMany::num_instances);
+}
+
+}
+
+} //namespace pvac
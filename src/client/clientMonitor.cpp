@@ -29,9 +29,13 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
     pva::Channel::shared_pointer chan;
     operation_type::shared_pointer op;
     bool started, done, seenEmpty;
+    // a Data event is waiting on strand
+    bool dataQueued;
 
     ClientChannel::MonitorCallback *cb;
     MonitorEvent event;
+    // NULL to call cb from the receiving thread
+    std::tr1::shared_ptr<detail::Strand> strand;
 
     pva::MonitorElement::Ref last;
 
@@ -41,6 +45,7 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
         :started(false)
         ,done(false)
         ,seenEmpty(false)
+        ,dataQueued(false)
         ,cb(cb)
     {REFTRACE_INCREMENT(num_instances);}
     virtual ~Impl() {
@@ -83,6 +88,33 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
         }
     }
 
+    // callEvent() now, or later from strand
+    void postEvent(CallbackGuard& G, MonitorEvent::event_t evt = MonitorEvent::Fail)
+    {
+        if(!cb) return;
+
+        if(evt==MonitorEvent::Data && dataQueued)
+            return; // already waiting, and poll() will find this update as well
+
+        event.event = evt;
+        if(pvac::detail::defer(strand, *this, event)) {
+            // following a Disconnect, a new Data event must be queued
+            dataQueued = evt==MonitorEvent::Data;
+        } else {
+            callEvent(G, evt);
+        }
+    }
+
+    void deliver(const MonitorEvent& evt)
+    {
+        CallbackGuard G(*this);
+        if(evt.event==MonitorEvent::Data)
+            dataQueued = false;
+        if(!cb) return; // cancelled while queued
+        event = evt;
+        callEvent(G, evt.event);
+    }
+
     // called automatically via wrapped_shared_from_this
     void cancel()
     {
@@ -129,7 +161,7 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
             event.message.clear();
         }
         if(!status.isSuccess()) {
-            callEvent(G);
+            postEvent(G);
 
         } else {
             pvd::Status sts(operation->start());
@@ -141,7 +173,7 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
                 last.attach(operation);
             } else {
                 event.message = sts.getMessage();
-                callEvent(G);
+                postEvent(G);
             }
         }
     }
@@ -154,7 +186,7 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
         if(!cb || done) return;
         event.message = "Disconnect";
         started = false;
-        callEvent(G, MonitorEvent::Disconnect);
+        postEvent(G, MonitorEvent::Disconnect);
     }
 
     virtual void monitorEvent(pva::MonitorPtr const & monitor) OVERRIDE FINAL
@@ -164,7 +196,7 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
         if(!cb || done) return;
         event.message.clear();
 
-        callEvent(G, MonitorEvent::Data);
+        postEvent(G, MonitorEvent::Data);
     }
 
     virtual void unlisten(pva::MonitorPtr const & monitor) OVERRIDE FINAL
@@ -175,7 +207,7 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
         done = true;
 
         if(seenEmpty)
-            callEvent(G, MonitorEvent::Data);
+            postEvent(G, MonitorEvent::Data);
         // else // wait until final poll()
     }
 };
@@ -247,6 +279,7 @@ ClientChannel::monitor(MonitorCallback *cb,
 
     std::tr1::shared_ptr<Monitor::Impl> ret(Monitor::Impl::build(cb));
     ret->chan = getChannel();
+    ret->strand = operationStrand();
 
     {
         Guard G(ret->mutex);
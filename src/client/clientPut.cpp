@@ -35,6 +35,16 @@ struct Putter : public pvac::detail::CallbackStorage,
 
     pvac::ClientChannel::PutCallback *cb;
     pvac::GetEvent event;
+    // NULL to call cb from the receiving thread
+    std::tr1::shared_ptr<pvac::detail::Strand> strand;
+
+    // a putBuild() (when channelPut!=NULL) or putDone() waiting on strand
+    struct Deferred {
+        pvac::GetEvent event;
+        pva::ChannelPut::shared_pointer channelPut;
+        pvd::PVStructure::shared_pointer previous;
+        pvd::BitSet::shared_pointer previousmask;
+    };
 
     static size_t num_instances;
 
@@ -62,6 +72,53 @@ struct Putter : public pvac::detail::CallbackStorage,
         }
     }
 
+    // callEvent() now, or later from strand
+    void postEvent(CallbackGuard& G, pvac::GetEvent::event_t evt = pvac::GetEvent::Fail)
+    {
+        if(!cb) return;
+
+        event.event = evt;
+        Deferred D;
+        D.event = event;
+        if(!pvac::detail::defer(strand, *this, D))
+            callEvent(G, evt);
+    }
+
+    // doPut() now, or later from strand
+    void postPut(CallbackGuard& G,
+                 pva::ChannelPut::shared_pointer const & channelPut,
+                 const pvd::PVStructure::shared_pointer& previous = pvd::PVStructure::shared_pointer(),
+                 const pvd::BitSet::shared_pointer& previousmask = pvd::BitSet::shared_pointer())
+    {
+        Deferred D;
+        D.channelPut = channelPut;
+        D.previous = previous;
+        D.previousmask = previousmask;
+        if(!pvac::detail::defer(strand, *this, D))
+            buildPut(G, D);
+    }
+
+    void buildPut(CallbackGuard& G, const Deferred& D)
+    {
+        pvd::BitSet empty;
+        pvd::BitSet::shared_pointer tosend(new pvd::BitSet);
+        pvac::ClientChannel::PutCallback::Args args(*tosend, D.previousmask ? *D.previousmask : empty);
+        args.previous = D.previous;
+        doPut(G, args, D.channelPut, tosend);
+    }
+
+    void deliver(const Deferred& D)
+    {
+        CallbackGuard G(*this);
+        if(!cb) return; // cancelled while queued
+        if(D.channelPut) {
+            buildPut(G, D);
+        } else {
+            event = D.event;
+            callEvent(G, D.event.event);
+        }
+    }
+
     virtual std::string name() const OVERRIDE FINAL
     {
         Guard G(mutex);
@@ -102,27 +159,25 @@ struct Putter : public pvac::detail::CallbackStorage,
             event.message.clear();
         }
         if(!status.isSuccess()) {
-            callEvent(G);
+            postEvent(G);
 
         } else if(getcurrent) {
             // fetch a previous value first
             op->get();
         } else {
             // build Put value immediately
-            pvd::BitSet empty;
-            pvd::BitSet::shared_pointer tosend(new pvd::BitSet);
-            pvac::ClientChannel::PutCallback::Args args(*tosend, empty);
-            // args.previous = 0; // implied
-            doPut(G, args, channelPut, tosend);
+            postPut(G, channelPut);
         }
     }
 
     virtual void channelDisconnect(bool destroy) OVERRIDE FINAL
     {
+        std::tr1::shared_ptr<Putter> keepalive(internal_shared_from_this());
         CallbackGuard G(*this);
+        if(!cb) return;
         event.message = "Disconnect";
 
-        callEvent(G);
+        postEvent(G);
     }
 
     void doPut(CallbackGuard& G,
@@ -166,13 +221,10 @@ struct Putter : public pvac::detail::CallbackStorage,
         if(!status.isOK()) {
             event.message = status.getMessage();
 
-            callEvent(G, pvac::GetEvent::Fail);
+            postEvent(G, pvac::GetEvent::Fail);
 
         } else {
-            pvd::BitSet::shared_pointer tosend(new pvd::BitSet);
-            pvac::ClientChannel::PutCallback::Args args(*tosend, *bitSet);
-            args.previous = pvStructure;
-            doPut(G, args, channelPut, tosend);
+            postPut(G, channelPut, pvStructure, bitSet);
         }
     }
 
@@ -190,7 +242,7 @@ struct Putter : public pvac::detail::CallbackStorage,
             event.message.clear();
         }
 
-        callEvent(G, status.isSuccess()? pvac::GetEvent::Success : pvac::GetEvent::Fail);
+        postEvent(G, status.isSuccess()? pvac::GetEvent::Success : pvac::GetEvent::Fail);
     }
 
     virtual void show(std::ostream &strm) const OVERRIDE FINAL
@@ -217,6 +269,7 @@ ClientChannel::put(PutCallback* cb,
         pvRequest = pvd::createRequest("field()");
 
     std::tr1::shared_ptr<Putter> ret(Putter::build(cb, getprevious));
+    ret->strand = operationStrand();
 
     {
         Guard G(ret->mutex);
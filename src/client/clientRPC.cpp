@@ -32,6 +32,8 @@ struct RPCer : public pvac::detail::CallbackStorage,
     pvac::ClientChannel::GetCallback *cb;
     // 'event' may be modified as long as cb!=NULL
     pvac::GetEvent event;
+    // NULL to call cb from the receiving thread
+    std::tr1::shared_ptr<pvac::detail::Strand> strand;
 
     pvd::PVStructure::const_shared_pointer args;
 
@@ -65,6 +67,24 @@ struct RPCer : public pvac::detail::CallbackStorage,
         }
     }
 
+    // callEvent() now, or later from strand
+    void postEvent(CallbackGuard& G, pvac::GetEvent::event_t evt = pvac::GetEvent::Fail)
+    {
+        if(!cb) return;
+
+        event.event = evt;
+        if(!pvac::detail::defer(strand, *this, event))
+            callEvent(G, evt);
+    }
+
+    void deliver(const pvac::GetEvent& evt)
+    {
+        CallbackGuard G(*this);
+        if(!cb) return; // cancelled while queued
+        event = evt;
+        callEvent(G, evt.event);
+    }
+
     virtual std::string name() const OVERRIDE FINAL
     {
         Guard G(mutex);
@@ -100,7 +120,7 @@ struct RPCer : public pvac::detail::CallbackStorage,
             event.message.clear();
         }
         if(!status.isSuccess()) {
-            callEvent(G);
+            postEvent(G);
 
         } else {
             operation->request(std::tr1::const_pointer_cast<pvd::PVStructure>(args));
@@ -115,7 +135,7 @@ struct RPCer : public pvac::detail::CallbackStorage,
         if(!cb) return;
         event.message = "Disconnect";
 
-        callEvent(G);
+        postEvent(G);
     }
 
     virtual void requestDone(
@@ -137,7 +157,7 @@ struct RPCer : public pvac::detail::CallbackStorage,
         valid->set(0);
         event.valid = valid;
 
-        callEvent(G, status.isSuccess()? pvac::GetEvent::Success : pvac::GetEvent::Fail);
+        postEvent(G, status.isSuccess()? pvac::GetEvent::Success : pvac::GetEvent::Fail);
     }
 
     virtual void show(std::ostream &strm) const OVERRIDE FINAL
@@ -164,6 +184,7 @@ ClientChannel::rpc(GetCallback* cb,
         pvRequest = pvd::createRequest("field()");
 
     std::tr1::shared_ptr<RPCer> ret(RPCer::build(cb, arguments));
+    ret->strand = operationStrand();
 
     {
         Guard G(ret->mutex);
@@ -14,14 +14,9 @@
 
 #define epicsExportSharedSymbols
 #include "pv/logger.h"
-#include "pva/client.h"
+#include "clientpvt.h"
 #include "pv/pvAccess.h"
 
-namespace pvd = epics::pvData;
-namespace pva = epics::pvAccess;
-typedef epicsGuard<epicsMutex> Guard;
-typedef epicsGuardRelease<epicsMutex> UnGuard;
-
 namespace {
 struct WaitCommon
 {
@@ -138,6 +133,50 @@ struct PutValCommon : public pvac::ClientChannel::PutCallback,
 
 namespace detail {
 
+void putScalar(pvd::PVStructure& root, const std::string& name, const pvd::AnyScalar& value,
+               bool required, pvd::BitSet& tosend)
+{
+    if(value.empty())
+        return;
+
+    pvd::PVFieldPtr fld(root.getSubField(name));
+    if(!fld && required)
+        throw std::runtime_error(std::string("Server does not have required field ")+name);
+    else if(!fld)
+        return; // !required
+
+    const pvd::FieldConstPtr& ftype(fld->getField());
+    if(ftype->getType()==pvd::union_) {
+        const pvd::Union *utype = static_cast<const pvd::Union*>(ftype.get());
+        pvd::PVUnion *ufld = static_cast<pvd::PVUnion*>(fld.get());
+
+        if(utype->isVariant()) {
+            pvd::PVScalarPtr scalar(pvd::getPVDataCreate()->createPVScalar(value.type()));
+
+            scalar->putFrom(value);
+            ufld->set(scalar);
+
+        } else {
+            // attempt automagic assignment to descriminating union
+            pvd::int32 idx = utype->guess(pvd::scalar, value.type());
+
+            if(idx==-1)
+                throw std::runtime_error(std::string("Unable to descriminate union field ")+name);
+
+            ufld->select<pvd::PVScalar>(idx)->putFrom(value);
+        }
+
+    } else if(ftype->getType()==pvd::scalar) {
+        static_cast<pvd::PVScalar*>(fld.get())->putFrom(value);
+
+    } else {
+        throw std::runtime_error(std::string("Type mis-match assigning scalar to field ")+name);
+
+    }
+
+    tosend.set(fld->getFieldOffset());
+}
+
 struct PutBuilder::Exec : public pvac::ClientChannel::PutCallback,
                           public WaitCommon
 {
@@ -157,45 +196,7 @@ struct PutBuilder::Exec : public pvac::ClientChannel::PutCallback,
         for(PutBuilder::scalars_t::const_iterator it = builder.scalars.begin(), end = builder.scalars.end();
             it!=end; ++it)
         {
-            if(it->value.empty())
-                continue;
-
-            pvd::PVFieldPtr fld(root->getSubField(it->name));
-            if(!fld && it->required)
-                throw std::runtime_error(std::string("Server does not have required field ")+it->name);
-            else if(!fld)
-                continue; // !it->required
-
-            const pvd::FieldConstPtr& ftype(fld->getField());
-            if(ftype->getType()==pvd::union_) {
-                const pvd::Union *utype = static_cast<const pvd::Union*>(ftype.get());
-                pvd::PVUnion *ufld = static_cast<pvd::PVUnion*>(fld.get());
-
-                if(utype->isVariant()) {
-                    pvd::PVScalarPtr scalar(create->createPVScalar(it->value.type()));
-
-                    scalar->putFrom(it->value);
-                    ufld->set(scalar);
-
-                } else {
-                    // attempt automagic assignment to descriminating union
-                    pvd::int32 idx = utype->guess(pvd::scalar, it->value.type());
-
-                    if(idx==-1)
-                        throw std::runtime_error(std::string("Unable to descriminate union field ")+it->name);
-
-                    ufld->select<pvd::PVScalar>(idx)->putFrom(it->value);
-                }
-
-            } else if(ftype->getType()==pvd::scalar) {
-                static_cast<pvd::PVScalar*>(fld.get())->putFrom(it->value);
-
-            } else {
-                throw std::runtime_error(std::string("Type mis-match assigning scalar to field ")+it->name);
-
-            }
-
-            args.tosend.set(fld->getFieldOffset());
+            putScalar(*root, it->name, it->value, it->required, args.tosend);
         }
 
         for(PutBuilder::arrays_t::const_iterator it = builder.arrays.begin(), end = builder.arrays.end();
@@ -422,5 +423,88 @@ ClientChannel::info(double timeout, const std::string& subfld)
     }
 }
 
+namespace {
+
+template<typename Event, typename Base>
+struct ManyWait : public Base,
+                  public WaitCommon
+{
+    std::vector<Event> results;
+
+    ManyWait() {}
+    virtual ~ManyWait() {}
+
+    void complete(const std::vector<Event>& evts)
+    {
+        {
+            Guard G(mutex);
+            if(done) {
+                LOG(pva::logLevelWarn, "oops, double event to ManyCallback");
+            } else {
+                results = evts;
+                done = true;
+            }
+        }
+        event.signal();
+    }
+
+    // @returns number of successes
+    size_t finish(pvac::Operation& op, double timeout, std::vector<Event>& ret)
+    {
+        try {
+            wait(timeout);
+        } catch(pvac::Timeout&) {
+            // remaining requests complete with Cancel
+            op.cancel();
+        }
+        Guard G(mutex);
+        if(!done)
+            THROW_EXCEPTION2(std::logic_error, "Cancelled w/o completion!?!?");
+        ret.swap(results);
+        size_t nok = 0u;
+        for(size_t i=0; i<ret.size(); i++) {
+            if(ret[i].event==Event::Success)
+                nok++;
+        }
+        return nok;
+    }
+};
+
+struct GetManyWait : public ManyWait<pvac::GetEvent, pvac::ClientProvider::GetManyCallback>
+{
+    virtual ~GetManyWait() {}
+    virtual void getManyDone(const std::vector<pvac::GetEvent>& evts) OVERRIDE FINAL { complete(evts); }
+};
+
+struct PutManyWait : public ManyWait<pvac::PutEvent, pvac::ClientProvider::PutManyCallback>
+{
+    virtual ~PutManyWait() {}
+    virtual void putManyDone(const std::vector<pvac::PutEvent>& evts) OVERRIDE FINAL { complete(evts); }
+};
+
+} // namespace
+
+size_t
+ClientProvider::getMany(const std::vector<std::string>& names,
+                        std::vector<GetEvent>& results,
+                        double timeout,
+                        epics::pvData::PVStructure::const_shared_pointer pvRequest)
+{
+    GetManyWait waiter;
+    Operation op(getMany(&waiter, names, pvRequest));
+    return waiter.finish(op, timeout, results);
+}
+
+size_t
+ClientProvider::putMany(const std::vector<std::string>& names,
+                        const std::vector<epics::pvData::AnyScalar>& values,
+                        std::vector<PutEvent>& results,
+                        double timeout,
+                        epics::pvData::PVStructure::const_shared_pointer pvRequest)
+{
+    PutManyWait waiter;
+    Operation op(putMany(&waiter, names, values, pvRequest));
+    return waiter.finish(op, timeout, results);
+}
 
 }//namespace pvac
@@ -2,9 +2,12 @@
 #define CLIENTPVT_H
 
 #include <utility>
+#include <deque>
+#include <vector>
 
 #include <epicsEvent.h>
 #include <epicsThread.h>
+#include <epicsTime.h>
 
 #include <pv/sharedPtr.h>
 
@@ -169,12 +172,106 @@ struct CallbackUse {
 };
 
 
+struct Executor;
+
+//! A callback waiting to be made by an Executor worker
+struct Task {
+    epicsTimeStamp queued;
+    virtual ~Task() {}
+    virtual void run() =0;
+};
+
+/* Tasks queued to one Strand run in order, and one at a time,
+ * on some worker of its Executor.
+ * One Strand per ClientChannel (Serial) or per operation (Pool).
+ */
+struct Strand : public std::tr1::enable_shared_from_this<Strand> {
+    const std::tr1::shared_ptr<Executor> executor;
+
+    // guarded by mutex
+    epicsMutex mutex;
+    std::deque<Task*> tasks;
+    bool scheduled; // queued to, or running on, a worker
+
+    explicit Strand(const std::tr1::shared_ptr<Executor>& executor) :executor(executor), scheduled(false) {}
+    ~Strand();
+
+    /** Queue for later execution.  Takes ownership of task.
+     * @returns false, and deletes task, if the Executor has been closed.
+     *          Caller should then run the task itself.
+     */
+    bool post(Task *task);
+};
+
+struct Executor : public std::tr1::enable_shared_from_this<Executor> {
+    struct Worker;
+
+    const ClientProvider::Dispatch mode;
+
+    Executor(ClientProvider::Dispatch mode, unsigned nthreads);
+    ~Executor();
+
+    //! start workers.  Call once after construction
+    void start();
+    //! Refuse further tasks for idle Strands.  Workers finish queued tasks then exit.
+    //! Waits for workers, except when called from a worker.
+    void close();
+
+    void stats(ClientProvider::ExecutorStats& ret) const;
+
+private:
+    friend struct Strand;
+    friend struct Worker;
+
+    void schedule(const std::tr1::shared_ptr<Strand>& strand, Worker *self);
+    void run(Worker& self);
+    std::tr1::shared_ptr<Strand> next(Worker& self);
+
+    std::vector<Worker*> workers;
+    epicsEvent wakeup;
+
+    // guards nextWorker, closing, and counters
+    mutable epicsMutex mutex;
+    size_t nextWorker;
+    bool closing;
+    ClientProvider::ExecutorStats counters;
+
+    Executor(const Executor&);
+    Executor& operator=(const Executor&);
+};
+
+//! Calls op->deliver(evt) from a worker
+template<class Op, class Evt>
+struct DeferredEvent : public Task {
+    const std::tr1::shared_ptr<Op> op;
+    const Evt evt;
+    DeferredEvent(const std::tr1::shared_ptr<Op>& op, const Evt& evt) :op(op), evt(evt) {}
+    virtual ~DeferredEvent() {}
+    virtual void run() { op->deliver(evt); }
+};
+
+//! Queue op.deliver(evt).  @returns false if the caller should deliver immediately.
+template<class Op, class Evt>
+bool defer(const std::tr1::shared_ptr<Strand>& strand, Op& op, const Evt& evt)
+{
+    return strand && strand->post(new DeferredEvent<Op, Evt>(op.internal_shared_from_this(), evt));
+}
+
+/** Assign value to the scalar, or union, field 'name' of root as ClientChannel::put().set() does,
+ *  and mark it in tosend.  Skipped if value.empty().
+ * @throws std::runtime_error if the field is missing (and required), or can't be assigned.
+ */
+void putScalar(pvd::PVStructure& root, const std::string& name, const pvd::AnyScalar& value,
+               bool required, pvd::BitSet& tosend);
+
 void registerRefTrack();
 void registerRefTrackGet();
 void registerRefTrackPut();
 void registerRefTrackMonitor();
 void registerRefTrackRPC();
 void registerRefTrackInfo();
+void registerRefTrackExecutor();
+void registerRefTrackMany();
 
 }} // namespace pvac::detail
 
@@ -5,10 +5,14 @@
 
 #include <sstream>
 #include <stdexcept>
+#include <cmath>
 
 #include <epicsGuard.h>
 #include <epicsMath.h>
+#include <epicsThread.h>
+#include <epicsExit.h>
 #include <pv/reftrack.h>
+#include <pv/timer.h>
 
 #define epicsExportSharedSymbols
 #include <pv/monitor.h>
@@ -20,8 +24,65 @@ namespace pvd = epics::pvData;
 typedef epicsGuard<epicsMutex> Guard;
 typedef epicsGuardRelease<epicsMutex> UnGuard;
 
+namespace {
+// shared by all rate limited MonitorFIFOs.  Created on first use, and stopped at exit.
+epicsThreadOnceId rateTimerOnce = EPICS_THREAD_ONCE_INIT;
+epicsMutex* rateTimerLock;
+std::tr1::shared_ptr<pvd::Timer>* rateTimerQueue;
+bool rateTimerStopped;
+
+void rateTimerStop(void*)
+{
+    std::tr1::shared_ptr<pvd::Timer> timer;
+    {
+        Guard G(*rateTimerLock);
+        rateTimerStopped = true;
+        timer.swap(*rateTimerQueue);
+    }
+    // joins the timer thread.  Any other reference remaining is to a stopped Timer.
+    if(timer)
+        timer->close();
+}
+
+void rateTimerInit(void*)
+{
+    rateTimerLock = new epicsMutex;
+    rateTimerQueue = new std::tr1::shared_ptr<pvd::Timer>;
+    epicsAtExit(&rateTimerStop, 0);
+}
+
+// NULL after exit, or if !create and not yet used
+std::tr1::shared_ptr<pvd::Timer> getRateTimer(bool create)
+{
+    epicsThreadOnce(&rateTimerOnce, &rateTimerInit, 0);
+    Guard G(*rateTimerLock);
+    if(!*rateTimerQueue && create && !rateTimerStopped)
+        rateTimerQueue->reset(new pvd::Timer("pvaMonRate", pvd::lowPriority));
+    return *rateTimerQueue;
+}
+} // namespace
+
 namespace epics {namespace pvAccess {
 
+struct MonitorFIFO::RateTimer : public pvd::TimerCallback
+{
+    epicsMutex mutex;
+    // set by open(), before first scheduling
+    std::tr1::weak_ptr<MonitorFIFO> owner;
+    virtual ~RateTimer() {}
+    virtual void callback() OVERRIDE FINAL
+    {
+        MonitorFIFO::shared_pointer O;
+        {
+            Guard G(mutex);
+            O = owner.lock();
+        }
+        if(O)
+            O->rateExpired();
+    }
+    virtual void timerStopped() OVERRIDE FINAL {}
+};
+
 MonitorFIFO::Config::Config()
     :maxCount(4)
     ,defCount(4)
@@ -45,15 +106,19 @@ MonitorFIFO::MonitorFIFO(const std::tr1::shared_ptr<MonitorRequester> &requester
     ,pipeline(false)
     ,running(false)
     ,finished(false)
+    ,fullRequest(false)
     ,needConnected(false)
     ,needEvent(false)
     ,needUnlisten(false)
     ,needClosed(false)
     ,freeHighLevel(0u)
     ,flowCount(0)
+    ,rateLimit(0.0)
 {
     REFTRACE_INCREMENT(num_instances);
 
+    lastPoll.secPastEpoch = lastPoll.nsec = 0u;
+
     if(conf.maxCount==0)
         conf.maxCount = 1;
 
@@ -88,6 +153,70 @@ MonitorFIFO::MonitorFIFO(const std::tr1::shared_ptr<MonitorRequester> &requester
         }
     }
 
+    O = pvRequest->getSubField<pvd::PVScalar>("record._options.rateLimit");
+    if(O) {
+        try {
+            rateLimit = std::max(0.0, O->getAs<double>());
+        } catch(std::exception& e) {
+            std::ostringstream strm;
+            strm<<"invalid rateLimit : "<<e.what();
+            requester->message(strm.str());
+        }
+    }
+    if(rateLimit>0.0)
+        rateTimer.reset(new RateTimer);
+
+    {
+        // look for field(...)[deadband=...]
+        typedef std::vector<std::pair<const pvd::PVStructure*, std::string> > todo_t;
+        todo_t todo;
+        pvd::PVStructure::const_shared_pointer F(pvRequest->getSubField<pvd::PVStructure>("field"));
+        if(F)
+            todo.push_back(std::make_pair(F.get(), std::string()));
+
+        while(!todo.empty()) {
+            const pvd::PVStructure *S = todo.back().first;
+            const std::string prefix(todo.back().second);
+            todo.pop_back();
+
+            const pvd::PVFieldPtrArray& children = S->getPVFields();
+            for(size_t i=0; i<children.size(); i++) {
+                const pvd::PVStructure *C = dynamic_cast<const pvd::PVStructure*>(children[i].get());
+                if(!C || children[i]->getFieldName()=="_options")
+                    continue;
+                const std::string name(prefix.empty() ? children[i]->getFieldName()
+                                                      : prefix+"."+children[i]->getFieldName());
+                todo.push_back(std::make_pair(C, name));
+
+                pvd::PVScalar::const_shared_pointer D(C->getSubField<pvd::PVScalar>("_options.deadband"));
+                if(!D)
+                    continue;
+
+                Deadband db;
+                db.name = name;
+                db.relative = false;
+                db.offset = 0u;
+                db.haveLast = false;
+                db.last = 0.0;
+                try {
+                    std::string spec(D->getAs<std::string>());
+                    if(spec.compare(0, 4, "abs:")==0) {
+                        spec = spec.substr(4);
+                    } else if(spec.compare(0, 4, "rel:")==0) {
+                        spec = spec.substr(4);
+                        db.relative = true;
+                    }
+                    db.amount = pvd::castUnsafe<double>(spec);
+                    deadbands.push_back(db);
+                } catch(std::exception& e) {
+                    std::ostringstream strm;
+                    strm<<"invalid deadband for "<<name<<" : "<<e.what();
+                    requester->message(strm.str());
+                }
+            }
+        }
+    }
+
     setFreeHighMark(0.00);
 
     if(inconf)
@@ -95,9 +224,57 @@ MonitorFIFO::MonitorFIFO(const std::tr1::shared_ptr<MonitorRequester> &requester
 }
 
 MonitorFIFO::~MonitorFIFO() {
+    if(rateTimer) {
+        std::tr1::shared_ptr<pvd::Timer> timer(getRateTimer(false));
+        if(timer)
+            timer->cancel(rateTimer);
+    }
     REFTRACE_DECREMENT(num_instances);
 }
 
+void MonitorFIFO::buffer_t::reset(size_t capacity)
+{
+    std::vector<MonitorElementPtr> temp(std::max(capacity, size_t(1u)));
+    slots.swap(temp);
+    head = count = 0u;
+}
+
+void MonitorFIFO::buffer_t::grow()
+{
+    std::vector<MonitorElementPtr> temp(std::max(slots.size()*2u, size_t(1u)));
+    for(size_t i=0; i<count; i++)
+        temp[i].swap(slots[(head+i)%slots.size()]);
+    slots.swap(temp);
+    head = 0u;
+}
+
+void MonitorFIFO::buffer_t::push_back(MonitorElementPtr& elem)
+{
+    if(count==slots.size())
+        grow();
+    slots[(head+count)%slots.size()].swap(elem);
+    count++;
+}
+
+void MonitorFIFO::buffer_t::push_front(MonitorElementPtr& elem)
+{
+    if(count==slots.size())
+        grow();
+    head = (head==0u ? slots.size() : head) - 1u;
+    slots[head].swap(elem);
+    count++;
+}
+
+void MonitorFIFO::buffer_t::pop_front(MonitorElementPtr& elem)
+{
+    assert(count>0u);
+    elem.reset();
+    elem.swap(slots[head]);
+    if(++head==slots.size())
+        head = 0u;
+    count--;
+}
+
 void MonitorFIFO::destroy()
 {}
 
@@ -107,6 +284,8 @@ void MonitorFIFO::show(std::ostream& strm) const
     strm<<"MonitorFIFO"
           " pipeline="<<pipeline
         <<" size="<<conf.actualCount
+        <<" rateLimit="<<rateLimit
+        <<" #deadband="<<deadbands.size()
         <<" freeHighLevel="<<freeHighLevel
         <<"\n";
 
@@ -147,19 +326,46 @@ void MonitorFIFO::open(const pvd::StructureConstPtr& type)
         else if(finished)
             throw std::logic_error("Monitor finished.  re-open() not possible");
 
+        if(rateTimer) {
+            // once.  read by RateTimer::callback() from the timer thread
+            Guard G2(rateTimer->mutex);
+            if(rateTimer->owner.expired())
+                rateTimer->owner = shared_from_this();
+        }
+
         // keep the code simpler.
         // never try to re-use elements, even on re-open w/o type change.
-        empty.clear();
-        inuse.clear();
-        returned.clear();
+        empty.reset(conf.actualCount+1);
+        inuse.reset(conf.actualCount+1);
+        returned.reset(conf.actualCount+1);
 
         // fill up empty.
         pvd::PVDataCreatePtr create(pvd::getPVDataCreate());
 
         try {
-            mapper.compute(*create->createPVStructure(type), *pvRequest, conf.mapperMode);
+            pvd::PVStructurePtr base(create->createPVStructure(type));
+            mapper.compute(*base, *pvRequest, conf.mapperMode);
             message = mapper.warnings();
 
+            for(size_t i=0; i<deadbands.size(); i++) {
+                Deadband& db = deadbands[i];
+                pvd::PVScalarPtr fld(base->getSubField<pvd::PVScalar>(db.name));
+                db.offset = 0u;
+                db.haveLast = false;
+                if(fld && pvd::ScalarTypeFunc::isNumeric(fld->getScalar()->getScalarType())) {
+                    db.offset = fld->getFieldOffset();
+                } else {
+                    if(!message.empty())
+                        message += "\n";
+                    message += "deadband ignored for non-numeric field "+db.name;
+                }
+            }
+
+            // complete structure requested, so elements may reference a snapshot of the base.
+            fullRequest = mapper.requested()==type;
+            for(size_t i=1, N=base->getNumberFields(); fullRequest && i<N; i++)
+                fullRequest = mapper.requestedMask().get(i);
+
             while(empty.size() < conf.actualCount+1) {
                 MonitorElementPtr elem(new MonitorElement(mapper.buildRequested()));
                 empty.push_back(elem);
@@ -219,13 +425,35 @@ bool MonitorFIFO::tryPost(const pvData::PVStructure& value,
 
     const bool havefree = _freeCount()>0u;
 
+    const pvd::BitSet& fchanged(applyDeadband(value, changed));
+
+    if(rateLimit>0.0 && !inuse.empty()) {
+        // when rate limited, squash into the one queued element, as post() does
+        if(conf.dropEmptyUpdates && !fchanged.logical_and(mapper.requestedMask()))
+            return havefree; // drop empty update
+
+        MonitorElementPtr& slot = inuse.back();
+        ensureUnique(slot);
+        MonitorElement *last = slot.get();
+        scratch.clear();
+        mapper.copyBaseToRequested(value, fchanged, *last->pvStructurePtr, scratch);
+        saveDeadband(value, fchanged);
+
+        last->overrunBitSet->or_and(*last->changedBitSet, scratch);
+        *last->changedBitSet |= scratch;
+        oscratch.clear();
+        mapper.maskBaseToRequested(overrun, oscratch);
+        last->overrunBitSet->or_and(oscratch, scratch);
+
+        return havefree;
+    }
+
     MonitorElementPtr elem;
-    if(conf.dropEmptyUpdates && !changed.logical_and(mapper.requestedMask())) {
+    if(conf.dropEmptyUpdates && !fchanged.logical_and(mapper.requestedMask())) {
         // drop empty update
     } else if(havefree) {
         // take an empty element
-        elem = empty.front();
-        empty.pop_front();
+        empty.pop_front(elem);
     } else if(force) {
         // allocate an extra element
         elem.reset(new MonitorElement(mapper.buildRequested()));
@@ -233,8 +461,9 @@ bool MonitorFIFO::tryPost(const pvData::PVStructure& value,
 
     if(elem) {
         try {
+            ensureUnique(elem);
             elem->changedBitSet->clear();
-            mapper.copyBaseToRequested(value, changed,
+            mapper.copyBaseToRequested(value, fchanged,
                                        *elem->pvStructurePtr, *elem->changedBitSet);
             elem->overrunBitSet->clear();
             mapper.maskBaseToRequested(overrun, *elem->overrunBitSet);
@@ -242,8 +471,9 @@ bool MonitorFIFO::tryPost(const pvData::PVStructure& value,
             if(inuse.empty() && running)
                 needEvent = true;
             inuse.push_back(elem);
+            saveDeadband(value, fchanged);
         }catch(...){
-            if(havefree) {
+            if(havefree && elem) {
                 empty.push_front(elem);
             }
             throw;
@@ -265,29 +495,35 @@ void MonitorFIFO::post(const pvData::PVStructure& value,
     if(state!=Opened || finished) return;
     assert(!empty.empty() || !inuse.empty());
 
-    const bool use_empty = !empty.empty();
+    // when rate limited, squash into the one queued element
+    const bool use_empty = !empty.empty() && (rateLimit<=0.0 || inuse.empty());
 
-    MonitorElementPtr elem;
+    MonitorElementPtr *slot;
 
     if(use_empty) {
         // space in window, or entering overflow, fill an empty element
 
         assert(!empty.empty());
 
-        elem = empty.front();
+        slot = &empty.front();
 
     } else {
         // window full and already in overflow
         // squash with last element
         assert(!inuse.empty());
-        elem = inuse.back();
+        slot = &inuse.back();
     }
 
-    if(conf.dropEmptyUpdates && !changed.logical_and(mapper.requestedMask()))
+    const pvd::BitSet& fchanged(applyDeadband(value, changed));
+
+    if(conf.dropEmptyUpdates && !fchanged.logical_and(mapper.requestedMask()))
         return; // drop empty update
 
+    ensureUnique(*slot);
+    MonitorElement *elem = slot->get();
     scratch.clear();
-    mapper.copyBaseToRequested(value, changed, *elem->pvStructurePtr, scratch);
+    mapper.copyBaseToRequested(value, fchanged, *elem->pvStructurePtr, scratch);
+    saveDeadband(value, fchanged);
 
     if(use_empty) {
         *elem->changedBitSet = scratch;
@@ -297,8 +533,9 @@ void MonitorFIFO::post(const pvData::PVStructure& value,
         if(inuse.empty() && running)
             needEvent = true;
 
-        inuse.push_back(elem);
-        empty.pop_front();
+        MonitorElementPtr temp;
+        empty.pop_front(temp);
+        inuse.push_back(temp);
         if(pipeline)
             flowCount--;
 
@@ -315,6 +552,120 @@ void MonitorFIFO::post(const pvData::PVStructure& value,
     }
 }
 
+void MonitorFIFO::post(const pvData::PVStructure::const_shared_pointer& snapshot,
+                       const pvd::BitSet& changed,
+                       const pvd::BitSet& overrun)
+{
+    Guard G(mutex);
+
+    if(state!=Opened || finished) return;
+
+    // deadband filtered fields are not copied, so can't be shared.
+    if(!fullRequest || !deadbands.empty() || snapshot->getStructure()!=mapper.requested()) {
+        post(*snapshot, changed, overrun);
+        return;
+    }
+
+    assert(!empty.empty() || !inuse.empty());
+
+    if(conf.dropEmptyUpdates && !changed.logical_and(mapper.requestedMask()))
+        return; // drop empty update
+
+    const bool use_empty = !empty.empty() && (rateLimit<=0.0 || inuse.empty());
+
+    MonitorElementPtr& slot = use_empty ? empty.front() : inuse.back();
+
+    // a snapshot is complete, so squashing is also replacement.
+    // pvStructurePtr is const, so replace the element, keeping its BitSets.
+    slot.reset(new MonitorElement(std::tr1::const_pointer_cast<pvd::PVStructure>(snapshot),
+                                  slot->changedBitSet, slot->overrunBitSet));
+    MonitorElement *elem = slot.get();
+
+    scratch.clear();
+    mapper.maskBaseToRequested(changed, scratch);
+
+    if(use_empty) {
+        *elem->changedBitSet = scratch;
+        elem->overrunBitSet->clear();
+        mapper.maskBaseToRequested(overrun, *elem->overrunBitSet);
+
+        if(inuse.empty() && running)
+            needEvent = true;
+
+        MonitorElementPtr temp;
+        empty.pop_front(temp);
+        inuse.push_back(temp);
+        if(pipeline)
+            flowCount--;
+
+    } else {
+        elem->overrunBitSet->or_and(*elem->changedBitSet, scratch);
+        *elem->changedBitSet |= scratch;
+        oscratch.clear();
+        mapper.maskBaseToRequested(overrun, oscratch);
+        elem->overrunBitSet->or_and(oscratch, scratch);
+    }
+}
+
+const pvd::BitSet& MonitorFIFO::applyDeadband(const pvData::PVStructure& value,
+                                              const pvd::BitSet& changed)
+{
+    const pvd::BitSet *ret = &changed;
+
+    for(size_t i=0; i<deadbands.size(); i++) {
+        const Deadband& db = deadbands[i];
+        if(!db.offset || !changed.get(db.offset))
+            continue;
+
+        const double val = value.getSubFieldT<pvd::PVScalar>(db.offset)->getAs<double>();
+
+        if(db.haveLast) {
+            const double limit = db.relative ? std::fabs(db.last)*db.amount/100.0 : db.amount;
+            if(std::fabs(val - db.last) < limit) {
+                if(ret==&changed) {
+                    dbscratch = changed;
+                    ret = &dbscratch;
+                }
+                dbscratch.clear(db.offset);
+            }
+        }
+    }
+
+    return *ret;
+}
+
+void MonitorFIFO::saveDeadband(const pvData::PVStructure& value,
+                               const pvd::BitSet& fchanged)
+{
+    for(size_t i=0; i<deadbands.size(); i++) {
+        Deadband& db = deadbands[i];
+        if(!db.offset || !fchanged.get(db.offset))
+            continue;
+
+        db.haveLast = true;
+        db.last = value.getSubFieldT<pvd::PVScalar>(db.offset)->getAs<double>();
+    }
+}
+
+void MonitorFIFO::rateExpired()
+{
+    {
+        Guard G(mutex);
+        if(state!=Opened || !running || inuse.empty())
+            return;
+        needEvent = true;
+    }
+    notify();
+}
+
+void MonitorFIFO::ensureUnique(MonitorElementPtr& elem)
+{
+    // still referenced by a snapshot shared with other FIFOs (or its owner)
+    if(!elem->pvStructurePtr.unique())
+        elem.reset(new MonitorElement(pvd::getPVDataCreate()->createPVStructure(elem->pvStructurePtr),
+                                      elem->changedBitSet, elem->overrunBitSet));
+}
+
 void MonitorFIFO::notify()
 {
     Monitor::shared_pointer self;
@@ -404,11 +755,27 @@ MonitorElementPtr MonitorFIFO::poll()
         Guard G(mutex);
 
         if(!inuse.empty() && inuse.size() + empty.size() > 1) {
-            ret = inuse.front();
-            inuse.pop_front();
-            if(inuse.empty() && finished) {
-                self = shared_from_this();
-                req = requester.lock();
+            epicsTimeStamp now(lastPoll);
+            double remaining = 0.0;
+            if(rateLimit>0.0) {
+                epicsTimeGetCurrent(&now);
+                remaining = rateLimit - epicsTimeDiffInSeconds(&now, &lastPoll);
+            }
+
+            if(remaining>0.0) {
+                // too soon.  wakeup downstream when allowed.
+                std::tr1::shared_ptr<pvd::Timer> timer(getRateTimer(true));
+                if(timer && !timer->isScheduled(rateTimer))
+                    timer->scheduleAfterDelay(rateTimer, remaining);
+
+            } else {
+                if(rateLimit>0.0)
+                    lastPoll = now;
+                inuse.pop_front(ret);
+                if(inuse.empty() && finished) {
+                    self = shared_from_this();
+                    req = requester.lock();
+                }
             }
         }
 
@@ -436,15 +803,17 @@ void MonitorFIFO::release(MonitorElementPtr const & elem)
                 || empty.size()+returned.size()>=conf.actualCount+1) // return of force'd
             return; // ignore it
 
+        MonitorElementPtr temp(elem);
+
         if(pipeline) {
             // work done during reportRemoteQueueStatus()
-            returned.push_back(elem);
+            returned.push_back(temp);
             return;
         }
 
         bool below = _freeCount() <= freeHighLevel;
 
-        empty.push_front(elem);
+        empty.push_front(temp);
 
         bool above = _freeCount() > freeHighLevel;
 
@@ -480,11 +849,12 @@ void MonitorFIFO::reportRemoteQueueStatus(pvd::int32 nfree)
         size_t nack = std::min(size_t(nfree), returned.size());
         flowCount += nfree;
 
-        buffer_t::iterator end(returned.begin());
-        std::advance(end, nack);
-
         // remove[0, nack) from returned and append to empty
-        empty.splice(empty.end(), returned, returned.begin(), end);
+        MonitorElementPtr temp;
+        for(size_t i=0; i<nack; i++) {
+            returned.pop_front(temp);
+            empty.push_back(temp);
+        }
 
         bool above = _freeCount() > freeHighLevel;
 
@@ -10,6 +10,8 @@
 #define MONITOR_H
 
 #include <list>
+#include <vector>
+#include <string>
 #include <ostream>
 
 #ifdef epicsExportSharedSymbols
@@ -18,6 +20,7 @@
 #endif
 
 #include <epicsMutex.h>
+#include <epicsTime.h>
 #include <pv/status.h>
 #include <pv/pvData.h>
 #include <pv/sharedPtr.h>
@@ -55,6 +58,12 @@ class epicsShareClass MonitorElement {
 public:
     POINTER_DEFINITIONS(MonitorElement);
     MonitorElement(epics::pvData::PVStructurePtr const & pvStructurePtr);
+    //! Reference an existing value, and BitSets (eg. those of an element being replaced)
+    MonitorElement(epics::pvData::PVStructurePtr const & pvStructurePtr,
+                   epics::pvData::BitSet::shared_pointer const & changedBitSet,
+                   epics::pvData::BitSet::shared_pointer const & overrunBitSet);
+    //! May reference a snapshot shared with other subscribers (see MonitorFIFO::post()),
+    //! so consumers must not modify the data it references.
     const epics::pvData::PVStructurePtr pvStructurePtr;
     const epics::pvData::BitSet::shared_pointer changedBitSet;
     const epics::pvData::BitSet::shared_pointer overrunBitSet;
@@ -87,6 +96,10 @@ class epicsShareClass Monitor : public virtual Destroyable{
      * @return monitorElement for modified data.
      * Must call get to determine if data is available.
      *
+     * The structure of a returned element must be treated as read-only.
+     * After release() it may be re-used for a later update, in which only
+     * fields changed since it was last filled are overwritten.
+     *
      * May recursively call MonitorRequester::unlisten()
      */
     virtual MonitorElementPtr poll() = 0;
@@ -242,6 +255,15 @@ inline MonitorElement::Ref end(Monitor& mon) { return MonitorElement::Ref(); }
  *
  * In either case, tryPost()==false indicates the the FIFO is full.
  *
+ * Downstream may also select filters through pvRequest options,
+ * which are applied before an update is queued.
+ *
+ * # record[rateLimit=0.1] - poll() returns data at most once per 0.1 seconds.
+ *   Meanwhile post() and tryPost() squash later updates into the one queued.
+ * # field(value[deadband=abs:0.5]) - A change of the numeric scalar field 'value' is ignored
+ *   if it differs by less than 0.5 from the last value queued.  With 'rel:2' the
+ *   threshold is 2 percent of the magnitude of the last value queued.
+ *
  * eg. simple usage in a sub-class for Channel named MyChannel.
  @code
     pva::Monitor::shared_pointer
@@ -326,6 +348,15 @@ public:
     void post(const pvData::PVStructure& value,
               const epics::pvData::BitSet& changed,
               const epics::pvData::BitSet& overrun = epics::pvData::BitSet());
+    /** Like post(value, changed, overrun), but given a complete value which the caller
+     *  promises not to modify.  When the downstream requested the complete structure,
+     *  the queued element is replaced by one referencing this snapshot instead of copying from it,
+     *  so that one snapshot may be shared by many subscribers.
+     *  Otherwise changed fields are copied as with post().
+     */
+    void post(const pvData::PVStructure::const_shared_pointer& snapshot,
+              const epics::pvData::BitSet& changed,
+              const epics::pvData::BitSet& overrun = epics::pvData::BitSet());
     //! Call after calling any other upstream interface methods (open()/close()/finish()/post()/...)
     //! when no upstream mutexes are locked.
     //! Do not call from Source::freeHighMark().  This is done automatically.
@@ -344,6 +375,16 @@ public:
     size_t freeCount() const;
 private:
     size_t _freeCount() const;
+    // replace an element referencing a shared snapshot with one referencing a private copy, before modifying
+    static void ensureUnique(MonitorElementPtr& elem);
+    // returns changed, or a copy with fields filtered by deadband cleared
+    const epics::pvData::BitSet& applyDeadband(const pvData::PVStructure& value,
+                                               const epics::pvData::BitSet& changed);
+    // remember the values of fields which passed applyDeadband().  call only once queued.
+    void saveDeadband(const pvData::PVStructure& value,
+                      const epics::pvData::BitSet& fchanged);
+    // called from rateTimer
+    void rateExpired();
 
     friend void providerRegInit(void*);
     static size_t num_instances;
@@ -388,7 +429,8 @@ private:
     bool pipeline; // const after ctor
     bool running; // start() vs. stop()
     bool finished; // finish() called
-    epics::pvData::BitSet scratch, oscratch; // using during post to avoid re-alloc
+    bool fullRequest; // downstream requested all fields.  Set by open()
+    epics::pvData::BitSet scratch, oscratch, dbscratch; // using during post to avoid re-alloc
 
     bool needConnected;
     bool needEvent;
@@ -402,7 +444,45 @@ private:
 
     epics::pvData::PVRequestMapper mapper;
 
-    typedef std::list<MonitorElementPtr> buffer_t;
+    // record[rateLimit=] minimum interval in seconds between poll()s returning data.  0 to disable.
+    double rateLimit; // const after ctor
+    epicsTimeStamp lastPoll;
+    struct RateTimer;
+    std::tr1::shared_ptr<RateTimer> rateTimer; // allocated by ctor when rateLimit>0
+
+    // field(...)[deadband=]
+    struct Deadband {
+        std::string name; // path in base structure
+        bool relative;
+        double amount;
+        size_t offset; // in base structure, set by open().  0 if not a numeric scalar
+        bool haveLast;
+        double last;   // value of last update which passed
+    };
+    std::vector<Deadband> deadbands;
+
+    //! Ring buffer of elements.  Capacity is set by open(), and only
+    //! grows if tryPost(..., force=true) overflows.
+    //! Elements are moved in and out by swap() to avoid reference counting.
+    class buffer_t {
+        std::vector<MonitorElementPtr> slots;
+        size_t head, count;
+        void grow();
+    public:
+        buffer_t() :head(0u), count(0u) {}
+        //! remove all elements, and allocate capacity
+        void reset(size_t capacity);
+        size_t size() const { return count; }
+        bool empty() const { return count==0u; }
+        MonitorElementPtr& front() { return slots[head]; }
+        MonitorElementPtr& back() { return slots[(head+count-1u)%slots.size()]; }
+        //! Move elem to the back.  elem is left NULL.
+        void push_back(MonitorElementPtr& elem);
+        //! Move elem to the front.  elem is left NULL.
+        void push_front(MonitorElementPtr& elem);
+        //! Move front element into elem
+        void pop_front(MonitorElementPtr& elem);
+    };
     // we allocate one extra buffer element to hold data when post()
     // while all elements poll()'d.  So there will always be one
     // element on either the empty or inuse lists
@@ -453,6 +453,14 @@ MonitorElement::MonitorElement(epics::pvData::PVStructurePtr const & pvStructure
     ,overrunBitSet(epics::pvData::BitSet::create(static_cast<epics::pvData::uint32>(pvStructurePtr->getNumberFields())))
 {}
 
+MonitorElement::MonitorElement(epics::pvData::PVStructurePtr const & pvStructurePtr,
+                               epics::pvData::BitSet::shared_pointer const & changedBitSet,
+                               epics::pvData::BitSet::shared_pointer const & overrunBitSet)
+    : pvStructurePtr(pvStructurePtr)
+    ,changedBitSet(changedBitSet)
+    ,overrunBitSet(overrunBitSet)
+{}
+
 }} // namespace epics::pvAccess
 
 namespace {
@@ -8,6 +8,7 @@
 #include <ostream>
 #include <stdexcept>
 #include <list>
+#include <vector>
 
 #include <epicsMutex.h>
 
@@ -251,6 +252,7 @@ struct Timeout : public std::runtime_error
 
 namespace detail {
 class PutBuilder;
+struct Strand;
 void registerRefTrack();
 }
 
@@ -458,6 +460,8 @@ public:
     void show(std::ostream& strm) const;
 private:
     std::tr1::shared_ptr<epics::pvAccess::Channel> getChannel();
+    // where callbacks of a new operation are queued.  NULL to call from the receiving thread.
+    std::tr1::shared_ptr<detail::Strand> operationStrand();
 };
 
 namespace detail {
@@ -554,6 +558,121 @@ public:
     //! Clear channel cache
     void disconnect();
 
+    //! From which thread(s) the callbacks of ClientChannel operations are made.
+    enum Dispatch {
+        //! From the thread which receives the event, usually a connection receive thread (default)
+        Inline,
+        //! From a worker pool.  In order, and one at a time, for each ClientChannel.
+        Serial,
+        //! From a worker pool.  In order, and one at a time, for each Operation or Monitor.
+        //! Callbacks of different operations on the same ClientChannel may run concurrently.
+        Pool,
+    };
+
+    //! Callback executor statistics.  See executorStats()
+    struct epicsShareClass ExecutorStats {
+        size_t nthreads;   //!< number of worker threads.  0 when Inline
+        size_t nqueued;    //!< callbacks currently waiting for a worker
+        size_t maxQueued;  //!< largest value of nqueued
+        size_t ncompleted; //!< callbacks made by workers
+        size_t nstolen;    //!< callbacks taken from the queue of another worker
+        double waitTotal,  //!< total seconds between queueing and the start of a callback
+               waitMax;
+        ExecutorStats();
+    };
+
+    /** Make callbacks of operations on ClientChannels connect()ed after this call
+     *  from a pool of worker threads, so that a slow callback doesn't delay reception
+     *  for other channels.  Channels already connected continue to use the previous setting.
+     *
+     *  The default is taken from $EPICS_PVA_CALLBACK_THREADS (0 is Inline)
+     *  and $EPICS_PVA_CALLBACK_SERIAL (default YES, otherwise Pool).
+     *
+     * @param mode Inline to make callbacks from the receiving thread.
+     * @param nthreads Worker pool size.  0 picks one per CPU core.
+     *
+     * @note A callback must not block waiting for another callback of the same ClientChannel (Serial),
+     *       or Operation (Pool).  eg. ClientChannel::get() with a timeout from a ClientChannel::GetCallback
+     *       of the same channel will time out.
+     */
+    void setExecutor(Dispatch mode, unsigned nthreads = 0u);
+
+    //! Fetch statistics of the current executor.  @returns false if Inline
+    bool executorStats(ExecutorStats& stats) const;
+
+    //! Completion notification for getMany()
+    struct GetManyCallback {
+        virtual ~GetManyCallback() {}
+        //! All requests have completed, failed, or been cancelled.  results[i] is for names[i]
+        virtual void getManyDone(const std::vector<GetEvent>& results)=0;
+    };
+
+    /** Issue requests to retrieve the current values of many PVs.
+     *
+     * All channels are connect()ed, then all requests issued, before any reply is awaited.
+     * Requests to the same server are queued together, and so share TCP messages.
+     *
+     * Operation::cancel() cancels requests not yet complete, which then have GetEvent::Cancel.
+     *
+     * @param cb Completion notification callback, made once.  Must outlive Operation (call Operation::cancel() to force release)
+     * @param names PV names.  May contain duplicates.
+     * @param pvRequest if NULL defaults to "field()".  Used for all PVs.
+     */
+    Operation getMany(GetManyCallback* cb,
+                      const std::vector<std::string>& names,
+                      epics::pvData::PVStructure::const_shared_pointer pvRequest = epics::pvData::PVStructure::const_shared_pointer());
+
+    /** Block and retrieve the current values of many PVs.
+     *
+     * @param names PV names
+     * @param results Set to one GetEvent for each of names.  Those not complete within timeout have GetEvent::Cancel.
+     * @param timeout in seconds, for all PVs together
+     * @param pvRequest if NULL defaults to "field()".  Used for all PVs.
+     * @returns the number of results with GetEvent::Success
+     */
+    size_t getMany(const std::vector<std::string>& names,
+                   std::vector<GetEvent>& results,
+                   double timeout = 3.0,
+                   epics::pvData::PVStructure::const_shared_pointer pvRequest = epics::pvData::PVStructure::const_shared_pointer());
+
+    //! Completion notification for putMany()
+    struct PutManyCallback {
+        virtual ~PutManyCallback() {}
+        //! All requests have completed, failed, or been cancelled.  results[i] is for names[i]
+        virtual void putManyDone(const std::vector<PutEvent>& results)=0;
+    };
+
+    /** Issue requests to change the 'value' field of many PVs.
+     *
+     * As with getMany(), all requests are issued before any reply is awaited.
+     * Each value is assigned as with ClientChannel::put().set("value", values[i]).exec()
+     *
+     * @param cb Completion notification callback, made once.  Must outlive Operation (call Operation::cancel() to force release)
+     * @param names PV names
+     * @param values New values.  Same length as names.
+     * @param pvRequest if NULL defaults to "field()".  Used for all PVs.
+     * @throws std::invalid_argument if names and values are of different length.
+     */
+    Operation putMany(PutManyCallback* cb,
+                      const std::vector<std::string>& names,
+                      const std::vector<epics::pvData::AnyScalar>& values,
+                      epics::pvData::PVStructure::const_shared_pointer pvRequest = epics::pvData::PVStructure::const_shared_pointer());
+
+    /** Block while changing the 'value' field of many PVs.
+     *
+     * @param names PV names
+     * @param values New values.  Same length as names.
+     * @param results Set to one PutEvent for each of names.  Those not complete within timeout have PutEvent::Cancel.
+     * @param timeout in seconds, for all PVs together
+     * @param pvRequest if NULL defaults to "field()".  Used for all PVs.
+     * @returns the number of results with PutEvent::Success
+     */
+    size_t putMany(const std::vector<std::string>& names,
+                   const std::vector<epics::pvData::AnyScalar>& values,
+                   std::vector<PutEvent>& results,
+                   double timeout = 3.0,
+                   epics::pvData::PVStructure::const_shared_pointer pvRequest = epics::pvData::PVStructure::const_shared_pointer());
+
     bool valid() const { return !!impl; }
 
 #if __cplusplus>=201103L
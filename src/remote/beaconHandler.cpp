@@ -60,11 +60,15 @@ bool BeaconHandler::updateBeacon(int8 /*remoteTransportRevision*/, TimeStamp* /*
     bool networkChange = (memcmp(_serverGUID.value, guid.value, sizeof(guid.value)) != 0);
     if (networkChange)
     {
+        const ServerGUID previous(_serverGUID);
+
         // update startup time and change count
         _serverGUID = guid;
         _serverChangeCount = changeCount;
 
-        _context.lock()->newServerDetected();
+        Context::shared_pointer context(_context.lock());
+        context->serverRestarted(previous);
+        context->newServerDetected();
 
         return true;
     }
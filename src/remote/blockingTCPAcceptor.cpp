@@ -5,6 +5,8 @@
  */
 
 #include <sstream>
+#include <algorithm>
+#include <string.h>
 
 #include <epicsThread.h>
 #include <osiSock.h>
@@ -17,6 +19,10 @@
 #include <pv/remote.h>
 #include <pv/logger.h>
 
+#ifdef PVA_UNIX_SOCKET
+#  include <unistd.h>
+#endif
+
 using std::ostringstream;
 using namespace epics::pvData;
 
@@ -25,28 +31,50 @@ namespace pvAccess {
 
 BlockingTCPAcceptor::BlockingTCPAcceptor(Context::shared_pointer const & context,
         ResponseHandler::shared_pointer const & responseHandler,
-        const osiSockAddr& addr, int receiveBufferSize) :
+        const osiSockAddr& addr, int receiveBufferSize,
+        const Config& config) :
     _context(context),
     _responseHandler(responseHandler),
     _bindAddress(),
+    _path(),
     _serverSocketChannel(INVALID_SOCKET),
     _receiveBufferSize(receiveBufferSize),
+    _config(config),
     _destroyed(false),
-    _thread(*this, "TCP-acceptor",
-            epicsThreadGetStackSize(
-                epicsThreadStackBig),
-            epicsThreadPriorityMedium)
+    _tokens(config.burst)
 {
     _bindAddress = addr;
+    epicsTimeGetCurrent(&_lastRefill);
     initialize();
 }
 
+BlockingTCPAcceptor::BlockingTCPAcceptor(Context::shared_pointer const & context,
+        ResponseHandler::shared_pointer const & responseHandler,
+        const std::string& path, int receiveBufferSize,
+        const Config& config) :
+    _context(context),
+    _responseHandler(responseHandler),
+    _bindAddress(),
+    _path(path),
+    _name("unix:"+path),
+    _serverSocketChannel(INVALID_SOCKET),
+    _receiveBufferSize(receiveBufferSize),
+    _config(config),
+    _destroyed(false),
+    _tokens(config.burst)
+{
+    memset(&_bindAddress, 0, sizeof(_bindAddress));
+    epicsTimeGetCurrent(&_lastRefill);
+    initializeLocal();
+}
+
 BlockingTCPAcceptor::~BlockingTCPAcceptor() {
     destroy();
 }
 
 int BlockingTCPAcceptor::initialize() {
 
+    SOCKET serverSocket;
     char ipAddrStr[24];
     ipAddrToDottedIP(&_bindAddress.ia, ipAddrStr, sizeof(ipAddrStr));
 
@@ -56,8 +84,8 @@ int BlockingTCPAcceptor::initialize() {
 
         LOG(logLevelDebug, "Creating acceptor to %s.", ipAddrStr);
 
-        _serverSocketChannel = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-        if(_serverSocketChannel==INVALID_SOCKET) {
+        serverSocket = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if(serverSocket==INVALID_SOCKET) {
             epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
             ostringstream temp;
             temp<<"Socket create error: "<<strBuffer;
@@ -66,10 +94,10 @@ int BlockingTCPAcceptor::initialize() {
         }
         else {
 
-            //epicsSocketEnableAddressReuseDuringTimeWaitState(_serverSocketChannel);
+            //epicsSocketEnableAddressReuseDuringTimeWaitState(serverSocket);
 
             // try to bind
-            int retval = ::bind(_serverSocketChannel, &_bindAddress.sa, sizeof(sockaddr));
+            int retval = ::bind(serverSocket, &_bindAddress.sa, sizeof(sockaddr));
             if(retval<0) {
                 epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
                 LOG(logLevelDebug, "Socket bind error: %s.", strBuffer);
@@ -83,7 +111,7 @@ int BlockingTCPAcceptor::initialize() {
                     _bindAddress.ia.sin_port = htons(0);
                 }
                 else {
-                    epicsSocketDestroy(_serverSocketChannel);
+                    epicsSocketDestroy(serverSocket);
                     break; // exit while loop
                 }
             }
@@ -94,7 +122,7 @@ int BlockingTCPAcceptor::initialize() {
                 if(ntohs(_bindAddress.ia.sin_port)==0) {
                     osiSocklen_t sockLen = sizeof(sockaddr);
                     // read the actual socket info
-                    retval = ::getsockname(_serverSocketChannel, &_bindAddress.sa, &sockLen);
+                    retval = ::getsockname(serverSocket, &_bindAddress.sa, &sockLen);
                     if(retval<0) {
                         // error obtaining port number
                         epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
@@ -108,16 +136,22 @@ int BlockingTCPAcceptor::initialize() {
                     }
                 }
 
-                retval = ::listen(_serverSocketChannel, 4);
+                retval = ::listen(serverSocket, _config.backlog);
                 if(retval<0) {
                     epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
                     ostringstream temp;
                     temp<<"Socket listen error: "<<strBuffer;
                     LOG(logLevelError, "%s", temp.str().c_str());
+                    epicsSocketDestroy(serverSocket);
                     THROW_BASE_EXCEPTION(temp.str().c_str());
                 }
 
-                _thread.start();
+                // all threads accept() from this one socket.  (no SO_REUSEPORT, which
+                // would allow another server to bind, and steal connections to, our port)
+                _serverSocketChannel = serverSocket;
+
+                _name = inetAddressToString(_bindAddress);
+                startWorkers("TCP-acceptor", std::max(1u, _config.threads));
 
                 // all OK, return
                 return ntohs(_bindAddress.ia.sin_port);
@@ -131,17 +165,124 @@ int BlockingTCPAcceptor::initialize() {
     THROW_BASE_EXCEPTION(temp.str().c_str());
 }
 
+void BlockingTCPAcceptor::initializeLocal() {
+#ifdef PVA_UNIX_SOCKET
+    char strBuffer[64];
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(_path.empty() || _path.size()>=sizeof(addr.sun_path))
+        THROW_BASE_EXCEPTION(("Invalid local socket path: "+_path).c_str());
+    strcpy(addr.sun_path, _path.c_str());
+
+    LOG(logLevelDebug, "Creating acceptor to %s.", _name.c_str());
+
+    SOCKET serverSocket = epicsSocketCreate(AF_UNIX, SOCK_STREAM, 0);
+    if(serverSocket==INVALID_SOCKET) {
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        ostringstream temp;
+        temp<<"Socket create error: "<<strBuffer;
+        THROW_BASE_EXCEPTION(temp.str().c_str());
+    }
+
+    int retval = ::bind(serverSocket, (sockaddr*)&addr, sizeof(addr));
+    if(retval<0 && SOCKERRNO==SOCK_EADDRINUSE) {
+        // left behind by a server which did not exit cleanly?  Or in use?
+        SOCKET probe = epicsSocketCreate(AF_UNIX, SOCK_STREAM, 0);
+        bool inuse = probe!=INVALID_SOCKET && ::connect(probe, (sockaddr*)&addr, sizeof(addr))==0;
+        if(probe!=INVALID_SOCKET)
+            epicsSocketDestroy(probe);
+
+        if(!inuse) {
+            LOG(logLevelDebug, "Replacing stale socket %s.", _path.c_str());
+            ::unlink(_path.c_str());
+            retval = ::bind(serverSocket, (sockaddr*)&addr, sizeof(addr));
+        }
+    }
+    if(retval<0) {
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        epicsSocketDestroy(serverSocket);
+        ostringstream temp;
+        temp<<"Socket bind error "<<_name<<" : "<<strBuffer;
+        THROW_BASE_EXCEPTION(temp.str().c_str());
+    }
+
+    if(::listen(serverSocket, _config.backlog)<0) {
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        epicsSocketDestroy(serverSocket);
+        ::unlink(_path.c_str());
+        ostringstream temp;
+        temp<<"Socket listen error "<<_name<<" : "<<strBuffer;
+        THROW_BASE_EXCEPTION(temp.str().c_str());
+    }
+
+    _serverSocketChannel = serverSocket;
+    startWorkers("local-acceptor", std::max(1u, _config.threads));
+#else
+    THROW_BASE_EXCEPTION("Local sockets not supported on this target");
+#endif
+}
+
+void BlockingTCPAcceptor::startWorkers(const char *prefix, unsigned nthreads) {
+    _workers.reserve(nthreads);
+    for(unsigned i=0; i<nthreads; i++) {
+        ostringstream name;
+        name<<prefix;
+        if(nthreads>1u)
+            name<<"-"<<i;
+        _workers.push_back(std::tr1::shared_ptr<epics::pvData::Thread>(new epics::pvData::Thread(
+                              epics::pvData::Thread::Config(this, &BlockingTCPAcceptor::run)
+                                  .prio(epicsThreadPriorityMedium)
+                                  .name(name.str())
+                                  .stack(epicsThreadStackBig)
+                                  .autostart(false))));
+    }
+    for(size_t i=0; i<_workers.size(); i++)
+        _workers[i]->start();
+}
+
+bool BlockingTCPAcceptor::admit() {
+    if(_config.rate<=0.0)
+        return true;
+
+    while(true) {
+        double delay;
+        {
+            Lock guard(_mutex);
+            if(_destroyed)
+                return false;
+
+            epicsTimeStamp now;
+            epicsTimeGetCurrent(&now);
+            _tokens = std::min(double(std::max(1u, _config.burst)),
+                               _tokens + epicsTimeDiffInSeconds(&now, &_lastRefill)*_config.rate);
+            _lastRefill = now;
+
+            if(_tokens>=1.0) {
+                _tokens -= 1.0;
+                return true;
+            }
+            delay = (1.0-_tokens)/_config.rate;
+        }
+        // new connections wait in the listen() backlog.
+        // wake periodically to notice destroy()
+        epicsThreadSleep(std::min(delay, 0.1));
+    }
+}
+
 void BlockingTCPAcceptor::run() {
-    // rise level if port is assigned dynamically
     char ipAddrStr[24];
-    ipAddrToDottedIP(&_bindAddress.ia, ipAddrStr, sizeof(ipAddrStr));
-    LOG(logLevelDebug, "Accepting connections at %s.", ipAddrStr);
+    LOG(logLevelDebug, "Accepting connections at %s.", _name.c_str());
 
     bool socketOpen = true;
     char strBuffer[64];
 
     while(socketOpen) {
 
+        if(!admit())
+            break;
+
         SOCKET sock;
         {
             Lock guard(_mutex);
@@ -156,22 +297,28 @@ void BlockingTCPAcceptor::run() {
         SOCKET newClient = epicsSocketAccept(sock, &address.sa, &len);
         if(newClient!=INVALID_SOCKET) {
             // accept succeeded
-            ipAddrToDottedIP(&address.ia, ipAddrStr, sizeof(ipAddrStr));
+            if(_path.empty())
+                ipAddrToDottedIP(&address.ia, ipAddrStr, sizeof(ipAddrStr));
+            else
+                strcpy(ipAddrStr, "local");
             LOG(logLevelDebug, "Accepted connection from PVA client: %s.", ipAddrStr);
 
-            // enable TCP_NODELAY (disable Nagle's algorithm)
-            int optval = 1; // true
-            int retval = ::setsockopt(newClient, IPPROTO_TCP, TCP_NODELAY, (char *)&optval, sizeof(int));
-            if(retval<0) {
-                epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
-                LOG(logLevelDebug, "Error setting TCP_NODELAY: %s.", strBuffer);
-            }
+            int retval;
+            if(_path.empty()) {
+                // enable TCP_NODELAY (disable Nagle's algorithm)
+                int optval = 1; // true
+                retval = ::setsockopt(newClient, IPPROTO_TCP, TCP_NODELAY, (char *)&optval, sizeof(int));
+                if(retval<0) {
+                    epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+                    LOG(logLevelDebug, "Error setting TCP_NODELAY: %s.", strBuffer);
+                }
 
-            // enable TCP_KEEPALIVE
-            retval = ::setsockopt(newClient, SOL_SOCKET, SO_KEEPALIVE, (char *)&optval, sizeof(int));
-            if(retval<0) {
-                epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
-                LOG(logLevelDebug, "Error setting SO_KEEPALIVE: %s.", strBuffer);
+                // enable TCP_KEEPALIVE
+                retval = ::setsockopt(newClient, SOL_SOCKET, SO_KEEPALIVE, (char *)&optval, sizeof(int));
+                if(retval<0) {
+                    epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+                    LOG(logLevelDebug, "Error setting SO_KEEPALIVE: %s.", strBuffer);
+                }
             }
 
             // do NOT tune socket buffer sizes, this will disable auto-tunning
@@ -196,7 +343,8 @@ void BlockingTCPAcceptor::run() {
                     _socketSendBufferSize,
                     _receiveBufferSize);
 
-            // validate connection
+            // validate connection.  Blocks this thread until the client
+            // completes validation, or for up to 5 seconds.
             if(!validateConnection(transport, ipAddrStr)) {
                 // TODO
                 // wait for negative response to be sent back and
@@ -235,30 +383,36 @@ void BlockingTCPAcceptor::destroy() {
         if(_destroyed) return;
         _destroyed = true;
 
+        // workers use _serverSocketChannel until they exit
         sock = _serverSocketChannel;
-        _serverSocketChannel = INVALID_SOCKET;
     }
 
     if(sock!=INVALID_SOCKET) {
-        char ipAddrStr[24];
-        ipAddrToDottedIP(&_bindAddress.ia, ipAddrStr, sizeof(ipAddrStr));
-        LOG(logLevelDebug, "Stopped accepting connections at %s.", ipAddrStr);
+        LOG(logLevelDebug, "Stopped accepting connections at %s.", _name.c_str());
 
         switch(epicsSocketSystemCallInterruptMechanismQuery())
         {
         case esscimqi_socketBothShutdownRequired:
             shutdown(sock, SHUT_RDWR);
             hackAroundRTEMSSocketInterrupt();
-            epicsSocketDestroy(sock);
-            _thread.exitWait();
             break;
         case esscimqi_socketSigAlarmRequired:
             LOG(logLevelError, "SigAlarm close not implemented for this target\n");
         case esscimqi_socketCloseRequired:
             epicsSocketDestroy(sock);
-            _thread.exitWait();
             break;
         }
+
+        for(size_t i=0; i<_workers.size(); i++)
+            _workers[i]->exitWait();
+
+        if(epicsSocketSystemCallInterruptMechanismQuery()==esscimqi_socketBothShutdownRequired)
+            epicsSocketDestroy(sock);
+
+#ifdef PVA_UNIX_SOCKET
+        if(!_path.empty())
+            ::unlink(_path.c_str());
+#endif
     }
 }
 
@@ -5,6 +5,7 @@
  */
 
 #include <sstream>
+#include <string.h>
 #include <sys/types.h>
 
 #include <osiSock.h>
@@ -27,8 +28,95 @@ BlockingTCPConnector::BlockingTCPConnector(
     float heartbeatInterval) :
     _context(context),
     _receiveBufferSize(receiveBufferSize),
-    _heartbeatInterval(heartbeatInterval)
+    _heartbeatInterval(heartbeatInterval),
+    _unixDir(context->getConfiguration()->getPropertyAsString("EPICS_PVA_UNIX_DIR", ""))
 {
+#ifdef PVA_UNIX_SOCKET
+    if(!_unixDir.empty()) {
+        SOCKET sock = epicsSocketCreate(AF_INET, SOCK_DGRAM, 0);
+        if(sock!=INVALID_SOCKET) {
+            IfaceNodeVector ifaces;
+            if(discoverInterfaces(ifaces, sock)==0) {
+                for(size_t i=0; i<ifaces.size(); i++) {
+                    osiSockAddr addr(ifaces[i].addr);
+                    addr.ia.sin_port = 0;
+                    _localAddresses.push_back(addr);
+                }
+            }
+            epicsSocketDestroy(sock);
+        }
+    }
+#else
+    _unixDir.clear();
+#endif
+}
+
+std::string localSocketPath(const std::string& dir, const osiSockAddr& bound)
+{
+    char ipAddrStr[24];
+    ipAddrToDottedIP(&bound.ia, ipAddrStr, sizeof(ipAddrStr));
+    // ipAddrToDottedIP() appends ":<port>"
+    char *sep = strchr(ipAddrStr, ':');
+    if(sep)
+        *sep = '\0';
+
+    std::ostringstream strm;
+    strm<<dir<<"/pva-"<<ipAddrStr<<"-"<<ntohs(bound.ia.sin_port)<<".sock";
+    return strm.str();
+}
+
+#ifdef PVA_UNIX_SOCKET
+namespace {
+SOCKET connectLocal(const std::string& path)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(path.size()>=sizeof(addr.sun_path))
+        return INVALID_SOCKET;
+    strcpy(addr.sun_path, path.c_str());
+
+    SOCKET socket = epicsSocketCreate(AF_UNIX, SOCK_STREAM, 0);
+    if(socket==INVALID_SOCKET)
+        return socket;
+
+    if(::connect(socket, (sockaddr*)&addr, sizeof(addr))!=0) {
+        // no local socket.  not an error
+        char strBuffer[64];
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        LOG(logLevelDebug, "No local socket %s : %s", path.c_str(), strBuffer);
+        epicsSocketDestroy(socket);
+        return INVALID_SOCKET;
+    }
+    return socket;
+}
+} // namespace
+#endif
+
+SOCKET BlockingTCPConnector::tryConnectLocal(const osiSockAddr& address) {
+#ifdef PVA_UNIX_SOCKET
+    if(_unixDir.empty() || address.sa.sa_family!=AF_INET)
+        return INVALID_SOCKET;
+
+    bool local = (ntohl(address.ia.sin_addr.s_addr)>>24)==127u;
+    for(size_t i=0; !local && i<_localAddresses.size(); i++)
+        local = _localAddresses[i].ia.sin_addr.s_addr==address.ia.sin_addr.s_addr;
+    if(!local)
+        return INVALID_SOCKET;
+
+    // the server bound to exactly this address, or else to all interfaces.
+    // Servers bound to other addresses of this host may use the same port.
+    SOCKET socket = connectLocal(localSocketPath(_unixDir, address));
+    if(socket==INVALID_SOCKET && address.ia.sin_addr.s_addr!=htonl(INADDR_ANY)) {
+        osiSockAddr any(address);
+        any.ia.sin_addr.s_addr = htonl(INADDR_ANY);
+        socket = connectLocal(localSocketPath(_unixDir, any));
+    }
+    return socket;
+#else
+    (void)address;
+    return INVALID_SOCKET;
+#endif
 }
 
 SOCKET BlockingTCPConnector::tryConnect(osiSockAddr& address, int tries) {
@@ -98,28 +186,34 @@ Transport::shared_pointer BlockingTCPConnector::connect(std::tr1::shared_ptr<Cli
     try {
         LOG(logLevelDebug, "Connecting to PVA server: %s.", ipAddrStr);
 
-        socket = tryConnect(address, 3);
+        socket = tryConnectLocal(address);
+        const bool local = socket!=INVALID_SOCKET;
+        if(!local)
+            socket = tryConnect(address, 3);
 
-        LOG(logLevelDebug, "Socket connected to PVA server: %s.", ipAddrStr);
+        LOG(logLevelDebug, "Socket connected to PVA server: %s%s.", ipAddrStr, local ? " (local)" : "");
 
-        // enable TCP_NODELAY (disable Nagle's algorithm)
-        int optval = 1; // true
-        int retval = ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+        int retval;
+        if(!local) {
+            // enable TCP_NODELAY (disable Nagle's algorithm)
+            int optval = 1; // true
+            retval = ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
                                   (char *)&optval, sizeof(int));
-        if(retval<0) {
-            char errStr[64];
-            epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
-            LOG(logLevelWarn, "Error setting TCP_NODELAY: %s.", errStr);
-        }
+            if(retval<0) {
+                char errStr[64];
+                epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+                LOG(logLevelWarn, "Error setting TCP_NODELAY: %s.", errStr);
+            }
 
-        // enable TCP_KEEPALIVE
-        retval = ::setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE,
-                              (char *)&optval, sizeof(int));
-        if(retval<0)
-        {
-            char errStr[64];
-            epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
-            LOG(logLevelWarn, "Error setting SO_KEEPALIVE: %s.", errStr);
+            // enable TCP_KEEPALIVE
+            retval = ::setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE,
+                                  (char *)&optval, sizeof(int));
+            if(retval<0)
+            {
+                char errStr[64];
+                epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+                LOG(logLevelWarn, "Error setting SO_KEEPALIVE: %s.", errStr);
+            }
         }
 
         // TODO tune buffer sizes?! Win32 defaults are 8k, which is OK
@@ -139,7 +233,7 @@ Transport::shared_pointer BlockingTCPConnector::connect(std::tr1::shared_ptr<Cli
         // create() also adds to context connection pool _context->getTransportRegistry()
         transport = detail::BlockingClientTCPTransportCodec::create(
                     context, socket, responseHandler, _receiveBufferSize, _socketSendBufferSize,
-                    client, transportRevision, _heartbeatInterval, priority);
+                    client, transportRevision, _heartbeatInterval, priority, &address);
 
         // verify
         if(!transport->verify(5000)) {
@@ -14,6 +14,15 @@
 #include <sys/types.h>
 #include <cstdio>
 
+#if defined(__linux__)
+#  include <errno.h>
+#  include <sys/socket.h>
+#  if defined(MSG_WAITFORONE)
+     // recvmmsg() and sendmmsg()
+#    define HAVE_MMSG
+#  endif
+#endif
+
 #include <epicsThread.h>
 #include <osiSock.h>
 #include <epicsAtomic.h>
@@ -47,6 +56,31 @@ inline int sendto(int s, const char *buf, size_t len, int flags, const struct so
 // reserve some space for CMD_ORIGIN_TAG message
 #define RECEIVE_BUFFER_PRE_RESERVE (PVA_MESSAGE_HEADER_SIZE + 16)
 
+#ifdef HAVE_MMSG
+// max. datagrams received by one recvmmsg()
+#define RECEIVE_BATCH 8
+
+// sendmmsg() attempts of one destination which fail for lack of buffer space, before it is skipped
+#define SEND_BATCH_RETRIES 3
+
+// set if recvmmsg()/sendmmsg() fail with ENOSYS (eg. old kernel)
+static int mmsgUnsupported;
+#endif
+
+namespace {
+// interrupted or timeout, or ICMP error of a previous send
+bool ignorableRecvError(int socketError)
+{
+    return socketError == SOCK_EINTR ||
+            socketError == EAGAIN ||        // no alias in libCom
+            // windows times out with this
+            socketError == SOCK_ETIMEDOUT ||
+            socketError == SOCK_EWOULDBLOCK ||
+            socketError == SOCK_ECONNREFUSED || // avoid spurious ECONNREFUSED in Linux
+            socketError == SOCK_ECONNRESET;     // or ECONNRESET in Windows
+}
+}
+
 size_t BlockingUDPTransport::num_instances;
 
 BlockingUDPTransport::BlockingUDPTransport(bool serverFlag,
@@ -231,6 +265,12 @@ void BlockingUDPTransport::run() {
 
     try {
 
+#ifdef HAVE_MMSG
+        // returns on close, or if not supported
+        if(!atomic::get(mmsgUnsupported))
+            runBatched(thisTransport);
+#endif
+
         char* recvfrom_buffer_start = (char*)(_receiveBuffer.getBuffer()+RECEIVE_BUFFER_PRE_RESERVE);
         size_t recvfrom_buffer_len =_receiveBuffer.getSize()-RECEIVE_BUFFER_PRE_RESERVE;
         while(!_closed.get())
@@ -242,63 +282,13 @@ void BlockingUDPTransport::run() {
 
             if(likely(bytesRead>=0)) {
                 // successfully got datagram
-                atomic::add(_totalBytesRecv, bytesRead);
-                bool ignore = false;
-                for(size_t i = 0; i <_ignoredAddresses.size(); i++)
-                {
-                    if(_ignoredAddresses[i].ia.sin_addr.s_addr==fromAddress.ia.sin_addr.s_addr)
-                    {
-                        ignore = true;
-                        if(pvAccessIsLoggable(logLevelDebug)) {
-                            char strBuffer[64];
-                            sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
-                            LOG(logLevelDebug, "UDP Ignore (%d) %s x- %s", bytesRead, _remoteName.c_str(), strBuffer);
-                        }
-                        break;
-                    }
-                }
+                handleDatagram(thisTransport, fromAddress, recvfrom_buffer_start, bytesRead);
 
-                if(likely(!ignore)) {
-                    if(pvAccessIsLoggable(logLevelDebug)) {
-                        char strBuffer[64];
-                        sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
-                        LOG(logLevelDebug, "UDP %s Rx (%d) %s <- %s", (_clientServerWithEndianFlag&0x40)?"Server":"Client", bytesRead, _remoteName.c_str(), strBuffer);
-                    }
-
-                    _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
-                    _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
-
-                    try {
-                        processBuffer(thisTransport, fromAddress, &_receiveBuffer);
-                    } catch(std::exception& e) {
-                        if(IS_LOGGABLE(logLevelError)) {
-                            char strBuffer[64];
-                            sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
-                            size_t epos = _receiveBuffer.getPosition();
-
-                            // of course _receiveBuffer _may_ have been modified during processing...
-                            _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
-                            _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
-
-                            std::cerr<<"Error on UDP RX "<<strBuffer<<" -> "<<_remoteName<<" at "<<epos<<" : "<<e.what()<<"\n"
-                                      <<HexDump(_receiveBuffer).limit(256u);
-                        }
-                    }
-                }
             } else {
 
                 int socketError = SOCKERRNO;
 
-                // interrupted or timeout
-                if (socketError == SOCK_EINTR ||
-                        socketError == EAGAIN ||        // no alias in libCom
-                        // windows times out with this
-                        socketError == SOCK_ETIMEDOUT ||
-                        socketError == SOCK_EWOULDBLOCK)
-                    continue;
-
-                if (socketError == SOCK_ECONNREFUSED || // avoid spurious ECONNREFUSED in Linux
-                        socketError == SOCK_ECONNRESET)     // or ECONNRESET in Windows
+                if (ignorableRecvError(socketError))
                     continue;
 
                 // log a 'recvfrom' error
@@ -326,6 +316,111 @@ void BlockingUDPTransport::run() {
     }
 }
 
+#ifdef HAVE_MMSG
+void BlockingUDPTransport::runBatched(Transport::shared_pointer const & transport)
+{
+    // Datagrams are received into an arena, then copied in turn to _receiveBuffer
+    // where handlers expect to find them.  Search requests are small, so
+    // the copy costs much less than the syscalls saved.
+    std::vector<char> arena(RECEIVE_BATCH*size_t(MAX_UDP_RECV));
+    mmsghdr msgs[RECEIVE_BATCH];
+    iovec iov[RECEIVE_BATCH];
+    osiSockAddr fromAddress[RECEIVE_BATCH];
+
+    while(!_closed.get())
+    {
+        for(size_t i=0; i<RECEIVE_BATCH; i++) {
+            iov[i].iov_base = &arena[i*size_t(MAX_UDP_RECV)];
+            iov[i].iov_len = MAX_UDP_RECV;
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_name = &fromAddress[i].sa;
+            msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        // wait for the first datagram, then take any others already queued
+        int nmsg = recvmmsg(_channel, msgs, RECEIVE_BATCH, MSG_WAITFORONE, 0);
+
+        if(likely(nmsg>=0)) {
+            for(int i=0; i<nmsg; i++)
+                handleDatagram(transport, fromAddress[i], (const char*)iov[i].iov_base, msgs[i].msg_len);
+
+        } else {
+            int socketError = SOCKERRNO;
+
+            if(socketError == ENOSYS) {
+                atomic::set(mmsgUnsupported, 1);
+                LOG(logLevelDebug, "recvmmsg() not supported, falling back to recvfrom()");
+                return;
+            }
+
+            if (ignorableRecvError(socketError))
+                continue;
+
+            // log a 'recvmmsg' error
+            if(!_closed.get())
+            {
+                char errStr[64];
+                epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+                LOG(logLevelError, "Socket recvmmsg error: %s.", errStr);
+            }
+
+            close(false);
+            return;
+        }
+    }
+}
+#endif // HAVE_MMSG
+
+void BlockingUDPTransport::handleDatagram(Transport::shared_pointer const & transport,
+                                          osiSockAddr& fromAddress, const char* data, size_t bytesRead)
+{
+    atomic::add(_totalBytesRecv, bytesRead);
+    for(size_t i = 0; i <_ignoredAddresses.size(); i++)
+    {
+        if(_ignoredAddresses[i].ia.sin_addr.s_addr==fromAddress.ia.sin_addr.s_addr)
+        {
+            if(pvAccessIsLoggable(logLevelDebug)) {
+                char strBuffer[64];
+                sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
+                LOG(logLevelDebug, "UDP Ignore (%zu) %s x- %s", bytesRead, _remoteName.c_str(), strBuffer);
+            }
+            return;
+        }
+    }
+
+    if(pvAccessIsLoggable(logLevelDebug)) {
+        char strBuffer[64];
+        sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
+        LOG(logLevelDebug, "UDP %s Rx (%zu) %s <- %s", (_clientServerWithEndianFlag&0x40)?"Server":"Client", bytesRead, _remoteName.c_str(), strBuffer);
+    }
+
+    char* start = (char*)(_receiveBuffer.getBuffer()+RECEIVE_BUFFER_PRE_RESERVE);
+    if(data!=start)
+        memcpy(start, data, bytesRead);
+
+    _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
+    _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
+
+    try {
+        processBuffer(transport, fromAddress, &_receiveBuffer);
+    } catch(std::exception& e) {
+        if(IS_LOGGABLE(logLevelError)) {
+            char strBuffer[64];
+            sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
+            size_t epos = _receiveBuffer.getPosition();
+
+            // of course _receiveBuffer _may_ have been modified during processing...
+            _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
+            _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
+
+            std::cerr<<"Error on UDP RX "<<strBuffer<<" -> "<<_remoteName<<" at "<<epos<<" : "<<e.what()<<"\n"
+                      <<HexDump(_receiveBuffer).limit(256u);
+        }
+    }
+}
+
 bool BlockingUDPTransport::processBuffer(Transport::shared_pointer const & transport,
         osiSockAddr& fromAddress, ByteBuffer* receiveBuffer) {
 
@@ -487,6 +582,91 @@ bool BlockingUDPTransport::send(ByteBuffer* buffer, InetAddressType target) {
 
     buffer->flip();
 
+#ifdef HAVE_MMSG
+    if(!atomic::get(mmsgUnsupported)) {
+        // one sendmmsg() for all destinations
+        iovec iov;
+        iov.iov_base = (void*)buffer->getBuffer();
+        iov.iov_len = buffer->getLimit();
+
+        std::vector<mmsghdr> msgs;
+        std::vector<size_t> dest;
+        msgs.reserve(_sendAddresses.size());
+        dest.reserve(_sendAddresses.size());
+
+        for(size_t i = 0; i<_sendAddresses.size(); i++) {
+
+            // filter
+            if (target != inetAddressType_all)
+                if ((target == inetAddressType_unicast && !_isSendAddressUnicast[i]) ||
+                        (target == inetAddressType_broadcast_multicast && _isSendAddressUnicast[i]))
+                    continue;
+
+            if (IS_LOGGABLE(logLevelDebug))
+            {
+                LOG(logLevelDebug, "Sending %zu bytes %s -> %s.",
+                    buffer->getRemaining(), _remoteName.c_str(), inetAddressToString(_sendAddresses[i]).c_str());
+            }
+
+            mmsghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_hdr.msg_name = &_sendAddresses[i].sa;
+            msg.msg_hdr.msg_namelen = sizeof(sockaddr);
+            msg.msg_hdr.msg_iov = &iov;
+            msg.msg_hdr.msg_iovlen = 1;
+            msgs.push_back(msg);
+            dest.push_back(i);
+        }
+
+        bool allOK = true, fallback = false;
+        size_t next = 0;
+        unsigned retries = 0u; // for msgs[next]
+        while(next<msgs.size()) {
+            int nsent = sendmmsg(_channel, &msgs[next], msgs.size()-next, 0);
+            if(likely(nsent>0)) {
+                atomic::add(_totalBytesSent, nsent*buffer->getLimit());
+                next += nsent;
+                retries = 0u;
+                continue;
+            }
+
+            int socketError = SOCKERRNO;
+            if(socketError == ENOSYS && next==0u) {
+                atomic::set(mmsgUnsupported, 1);
+                LOG(logLevelDebug, "sendmmsg() not supported, falling back to sendto()");
+                fallback = true;
+                break;
+
+            } else if(socketError == SOCK_EINTR) {
+                continue; // nothing sent, try again
+
+            } else if((socketError == SOCK_ENOBUFS || socketError == SOCK_EWOULDBLOCK || socketError == EAGAIN)
+                      && retries < SEND_BATCH_RETRIES) {
+                // transient lack of buffer space.  Give it a moment to drain.
+                retries++;
+                epicsThreadSleep(0.001);
+                continue;
+            }
+
+            // failed to send to msgs[next], skip it.
+            char errStr[64];
+            epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+            LOG(logLevelDebug, "Socket sendmmsg to %s error: %s.",
+                inetAddressToString(_sendAddresses[dest[next]]).c_str(), errStr);
+            allOK = false;
+            next++;
+            retries = 0u;
+        }
+
+        if(!fallback) {
+            // all sent
+            buffer->setPosition(buffer->getLimit());
+
+            return allOK;
+        }
+    }
+#endif // HAVE_MMSG
+
     bool allOK = true;
     for(size_t i = 0; i<_sendAddresses.size(); i++) {
 
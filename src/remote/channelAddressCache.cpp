@@ -0,0 +1,196 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <epicsTime.h>
+
+#define epicsExportSharedSymbols
+#include <pv/channelAddressCache.h>
+#include <pv/inetAddressUtil.h>
+#include <pv/logger.h>
+
+namespace epics {
+namespace pvAccess {
+
+namespace {
+epicsUInt32 now()
+{
+    epicsTimeStamp ts;
+    epicsTimeGetCurrent(&ts);
+    return ts.secPastEpoch;
+}
+
+bool parseGUID(const std::string& hex, ServerGUID& guid)
+{
+    if(hex.size()!=2u*sizeof(guid.value))
+        return false;
+    for(size_t i=0; i<sizeof(guid.value); i++) {
+        unsigned byte;
+        if(sscanf(hex.c_str()+2u*i, "%2x", &byte)!=1)
+            return false;
+        guid.value[i] = char(byte);
+    }
+    return true;
+}
+}
+
+ChannelAddressCache::ChannelAddressCache(const std::string& fname, double maxAge)
+    :_fname(fname)
+    ,_maxAge(maxAge)
+    ,_dirty(false)
+{}
+
+ChannelAddressCache::~ChannelAddressCache() {}
+
+bool ChannelAddressCache::load()
+{
+    std::ifstream strm(_fname.c_str());
+    if(!strm.is_open())
+        return false;
+
+    const epicsUInt32 oldest = _maxAge>0.0 ? now() - epicsUInt32(_maxAge) : 0u;
+    entries_t entries;
+    std::string line;
+    size_t nbad = 0u;
+
+    while(std::getline(strm, line)) {
+        if(line.empty() || line[0]=='#')
+            continue;
+
+        std::istringstream lstrm(line);
+        std::string addr, guid, name;
+        Entry ent;
+        memset(&ent.address, 0, sizeof(ent.address));
+
+        if(!(lstrm>>addr>>guid>>ent.lastSeen) || lstrm.get()!=' ' || !std::getline(lstrm, name) || name.empty()
+                || aToIPAddr(addr.c_str(), 0, &ent.address.ia) || !parseGUID(guid, ent.guid)) {
+            nbad++;
+            continue;
+        }
+
+        if(ent.lastSeen < oldest)
+            continue;
+
+        entries[name] = ent;
+    }
+
+    if(nbad)
+        LOG(logLevelWarn, "Ignoring %u invalid lines in channel address cache '%s'", unsigned(nbad), _fname.c_str());
+    LOG(logLevelDebug, "Loaded %u entries from channel address cache '%s'", unsigned(entries.size()), _fname.c_str());
+
+    Guard G(_mutex);
+    _entries.swap(entries);
+    _dirty = false;
+    return true;
+}
+
+bool ChannelAddressCache::save()
+{
+    std::ostringstream content;
+    {
+        Guard G(_mutex);
+        if(!_dirty)
+            return true;
+
+        const epicsUInt32 oldest = _maxAge>0.0 ? now() - epicsUInt32(_maxAge) : 0u;
+
+        content<<"# pvAccess channel address cache\n"<<std::hex<<std::setfill('0');
+        for(entries_t::const_iterator it(_entries.begin()), end(_entries.end()); it!=end; ++it) {
+            const Entry& ent = it->second;
+            if(ent.lastSeen < oldest)
+                continue;
+            if(it->first.find('\n')!=std::string::npos)
+                continue;
+
+            content<<inetAddressToString(ent.address)<<' ';
+            for(size_t i=0; i<sizeof(ent.guid.value); i++)
+                content<<std::setw(2)<<unsigned(epicsUInt8(ent.guid.value[i]));
+            content<<' '<<std::dec<<ent.lastSeen<<' '<<it->first<<'\n'<<std::hex;
+        }
+        _dirty = false;
+    }
+
+    // write and rename, so that a reader never sees a partial file
+    const std::string temp(_fname+".tmp");
+    {
+        std::ofstream strm(temp.c_str(), std::ios::out|std::ios::trunc);
+        strm<<content.str();
+        strm.close();
+        if(strm.fail()) {
+            LOG(logLevelWarn, "Unable to write channel address cache '%s'", temp.c_str());
+            ::remove(temp.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    // rename() does not replace an existing file
+    ::remove(_fname.c_str());
+#endif
+    if(::rename(temp.c_str(), _fname.c_str())) {
+        LOG(logLevelWarn, "Unable to replace channel address cache '%s'", _fname.c_str());
+        ::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ChannelAddressCache::lookup(const std::string& name, Entry& entry) const
+{
+    Guard G(_mutex);
+    entries_t::const_iterator it(_entries.find(name));
+    if(it==_entries.end())
+        return false;
+    entry = it->second;
+    return true;
+}
+
+void ChannelAddressCache::update(const std::string& name, const osiSockAddr& address, const ServerGUID& guid)
+{
+    Guard G(_mutex);
+    Entry& ent = _entries[name];
+    ent.address = address;
+    ent.guid = guid;
+    ent.lastSeen = now();
+    _dirty = true;
+}
+
+void ChannelAddressCache::remove(const std::string& name)
+{
+    Guard G(_mutex);
+    if(_entries.erase(name))
+        _dirty = true;
+}
+
+size_t ChannelAddressCache::invalidate(const ServerGUID& guid)
+{
+    Guard G(_mutex);
+    size_t count = 0u;
+    for(entries_t::iterator it(_entries.begin()); it!=_entries.end();) {
+        if(memcmp(it->second.guid.value, guid.value, sizeof(guid.value))==0) {
+            _entries.erase(it++);
+            count++;
+        } else {
+            ++it;
+        }
+    }
+    if(count)
+        _dirty = true;
+    return count;
+}
+
+size_t ChannelAddressCache::size() const
+{
+    Guard G(_mutex);
+    return _entries.size();
+}
+
+}
+}
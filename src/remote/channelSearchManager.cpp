@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <vector>
+#include <algorithm>
 
 #include <epicsMutex.h>
 
@@ -18,6 +19,7 @@
 #include <pv/pvaConstants.h>
 #include <pv/blockingUDP.h>
 #include <pv/serializeHelper.h>
+#include <pv/clientContextImpl.h>
 #include <pv/logger.h>
 
 using namespace std;
@@ -47,6 +49,47 @@ public:
     }
 };
 
+// CMD_SEARCH sent through a TCP connection to a name server
+class NameServerSearch : public pva::TransportSender
+{
+public:
+    NameServerSearch(epics::pvData::int32 sequenceNumber, const osiSockAddr& responseAddress)
+        :sequenceNumber(sequenceNumber)
+        ,responseAddress(responseAddress)
+    {}
+    virtual ~NameServerSearch() {}
+
+    epics::pvData::int32 sequenceNumber;
+    osiSockAddr responseAddress;
+    std::vector<pva::SearchInstance::shared_pointer> channels;
+
+    virtual void send(epics::pvData::ByteBuffer* buffer, pva::TransportSendControl* control) OVERRIDE FINAL
+    {
+        control->startMessage(pva::CMD_SEARCH, 4+1+3+16+2+1+4+2);
+
+        buffer->putInt(sequenceNumber);
+        // reply only if found.  Do not forward.
+        buffer->putByte((epics::pvData::int8)0);
+        // reserved part
+        buffer->putByte((epics::pvData::int8)0);
+        buffer->putShort((epics::pvData::int16)0);
+
+        // ignored by server, which replies through this connection
+        pva::encodeAsIPv6Address(buffer, &responseAddress);
+        buffer->putShort((epics::pvData::int16)ntohs(responseAddress.ia.sin_port));
+
+        buffer->putByte((epics::pvData::int8)1);
+        pva::SerializeHelper::serializeString("tcp", buffer, control);
+
+        buffer->putShort((epics::pvData::int16)channels.size());
+        for(size_t i=0; i<channels.size(); i++) {
+            control->ensureBuffer(4);
+            buffer->putInt(channels[i]->getSearchInstanceID());
+            pva::SerializeHelper::serializeString(channels[i]->getSearchInstanceName(), buffer, control);
+        }
+    }
+};
+
 }// namespace
 
 namespace epics {
@@ -62,14 +105,29 @@ static const int PAYLOAD_POSITION = 4;
 static const double ATOMIC_PERIOD = 0.225;
 static const double PERIOD_JITTER_MS = 0.025;
 
+// search interval (in periods), doubled after each search
 static const int DEFAULT_USER_VALUE = 1;
 static const int BOOST_VALUE = 1;
-// must be power of two (so that search is done)
-static const int MAX_COUNT_VALUE = 1 << 8;
-static const int MAX_FALLBACK_COUNT_VALUE = (1 << 7) + 1;
+static const int MAX_USER_VALUE = 1 << 7;
 
+// timer wheel size (in periods), must be > MAX_USER_VALUE
+static const uint32_t WHEEL_SIZE = 1u << 8;
+static const uint32_t BACKLOG_DUE = 0xffffffff;
+
+// UDP frames sent in a burst, and sent per period.
 static const int MAX_FRAMES_AT_ONCE = 10;
-static const int DELAY_BETWEEN_FRAMES_MS = 50;
+// the minimum is the previous fixed rate of 10 frames per 50ms
+static const int MIN_FRAMES_PER_PERIOD = 45;
+static const int MAX_FRAMES_PER_PERIOD = 400;
+
+// bytes available for channels in one search frame
+static const size_t FRAME_CAPACITY = MAX_UDP_UNFRAGMENTED_SEND - (PVA_MESSAGE_HEADER_SIZE + 4+1+3+16+2+1+4+2);
+
+// max. channels in one CMD_SEARCH sent to a name server
+// (client reads the count of a search response as int16)
+static const size_t NAME_SERVER_BATCH = 4096;
+// min. time between attempts to (re)connect to a name server
+static const int64_t NAME_SERVER_RECONNECT_MS = 10000;
 
 
 ChannelSearchManager::ChannelSearchManager(Context::shared_pointer const & context) :
@@ -79,6 +137,11 @@ ChannelSearchManager::ChannelSearchManager(Context::shared_pointer const & conte
     m_sequenceNumber(0),
     m_sendBuffer(MAX_UDP_UNFRAGMENTED_SEND),
     m_channels(),
+    m_wheel(WHEEL_SIZE),
+    m_tick(0),
+    m_window(MIN_FRAMES_PER_PERIOD),
+    m_sentLast(0),
+    m_responses(0),
     m_lastTimeSent(),
     m_channelMutex(),
     m_userValueMutex(),
@@ -88,6 +151,17 @@ ChannelSearchManager::ChannelSearchManager(Context::shared_pointer const & conte
     srand ( time(NULL) );
 }
 
+void ChannelSearchManager::setNameServers(const InetAddrVector& addresses)
+{
+    Lock guard(m_nameServerMutex);
+    m_nameServers.resize(addresses.size());
+    for(size_t i=0; i<addresses.size(); i++) {
+        m_nameServers[i].address = addresses[i];
+        m_nameServers[i].transport.reset();
+        m_nameServers[i].lastAttempt = 0;
+    }
+}
+
 void ChannelSearchManager::activate()
 {
     m_responseAddress = Context::shared_pointer(m_context)->getSearchTransport()->getRemoteAddress();
@@ -98,6 +172,15 @@ void ChannelSearchManager::activate()
     // add some jitter so that all the clients do not send at the same time
     double period = ATOMIC_PERIOD + double(rand())/RAND_MAX*PERIOD_JITTER_MS;
 
+    if (!m_nameServers.empty())
+    {
+        m_nameServerThread.reset(new epics::pvData::Thread(
+                                     epics::pvData::Thread::Config(this, &ChannelSearchManager::nameServerConnector)
+                                         .prio(epicsThreadPriorityMedium)
+                                         .name("PVA name server connect")
+                                         .stack(epicsThreadStackBig)));
+    }
+
     Context::shared_pointer context(m_context.lock());
     if (context)
         context->getTimer()->schedulePeriodic(shared_from_this(), period, period);
@@ -105,23 +188,35 @@ void ChannelSearchManager::activate()
 
 ChannelSearchManager::~ChannelSearchManager()
 {
-    Lock guard(m_mutex);
-    if (!m_canceled.get()) {
-        LOG(logLevelWarn, "Logic error: ChannelSearchManager destroyed w/o cancel()");
+    {
+        Lock guard(m_mutex);
+        if (!m_canceled.get()) {
+            LOG(logLevelWarn, "Logic error: ChannelSearchManager destroyed w/o cancel()");
+            m_canceled.set();
+        }
     }
+    m_nameServerWakeup.signal();
+    // joins thread
+    m_nameServerThread.reset();
 }
 
 void ChannelSearchManager::cancel()
 {
-    Lock guard(m_mutex);
+    {
+        Lock guard(m_mutex);
 
-    if (m_canceled.get())
-        return;
-    m_canceled.set();
+        if (m_canceled.get())
+            return;
+        m_canceled.set();
 
-    Context::shared_pointer context(m_context.lock());
-    if (context)
-        context->getTimer()->cancel(shared_from_this());
+        Context::shared_pointer context(m_context.lock());
+        if (context)
+            context->getTimer()->cancel(shared_from_this());
+    }
+
+    // may wait for a connect() in progress
+    m_nameServerWakeup.signal();
+    m_nameServerThread.reset();
 }
 
 int32_t ChannelSearchManager::registeredCount()
@@ -140,12 +235,14 @@ void ChannelSearchManager::registerSearchInstance(SearchInstance::shared_pointer
         Lock guard(m_channelMutex);
 
         // overrides if already registered
-        m_channels[channel->getSearchInstanceID()] = channel;
+        m_channels_t::iterator it(m_channels.insert(std::make_pair(channel->getSearchInstanceID(), Registration())).first);
+        it->second.instance = channel;
         immediateTrigger = (m_channels.size() == 1);
 
         Lock guard2(m_userValueMutex);
         int32_t& userValue = channel->getUserValue();
-        userValue = (penalize ? MAX_FALLBACK_COUNT_VALUE : DEFAULT_USER_VALUE);
+        userValue = (penalize ? MAX_USER_VALUE : DEFAULT_USER_VALUE);
+        schedule(it, m_tick + userValue);
     }
 
     if (immediateTrigger)
@@ -177,10 +274,11 @@ void ChannelSearchManager::searchResponse(const ServerGUID & guid, pvAccessID ci
     }
     else
     {
-        SearchInstance::shared_pointer si(channelsIter->second.lock());
+        SearchInstance::shared_pointer si(channelsIter->second.instance.lock());
 
         // remove from search list
-        m_channels.erase(cid);
+        m_channels.erase(channelsIter);
+        m_responses++;
 
         guard.unlock();
 
@@ -306,83 +404,254 @@ void ChannelSearchManager::boost()
     m_channels_t::iterator channelsIter = m_channels.begin();
     for(; channelsIter != m_channels.end(); channelsIter++)
     {
-        SearchInstance::shared_pointer inst(channelsIter->second.lock());
+        SearchInstance::shared_pointer inst(channelsIter->second.instance.lock());
         if(!inst) continue;
         int32_t& userValue = inst->getUserValue();
         userValue = BOOST_VALUE;
+        // search in next period
+        schedule(channelsIter, m_tick + 1);
     }
 }
 
+void ChannelSearchManager::schedule(m_channels_t::iterator& it, uint32_t due)
+{
+    it->second.due = due;
+    if (due == BACKLOG_DUE)
+        m_backlog.push_back(it->first);
+    else
+        m_wheel[due % WHEEL_SIZE].push_back(it->first);
+}
+
+void ChannelSearchManager::adjustWindow()
+{
+    if (m_sentLast == 0)
+        return;
+
+    // Absent channels are never answered, so this can not tell the difference
+    // between those and lost datagrams.  Either way, slow down.
+    if (m_responses*2u >= m_sentLast)
+        m_window = std::min(MAX_FRAMES_PER_PERIOD, m_window*2);
+    else if (m_responses*8u >= m_sentLast)
+        m_window = std::min(MAX_FRAMES_PER_PERIOD, m_window+1);
+    else
+        m_window = std::max(MIN_FRAMES_PER_PERIOD, m_window/2);
+
+    m_responses = 0;
+}
+
 void ChannelSearchManager::callback()
 {
+    int64_t nowMS;
+
     // high-frequency beacon anomaly trigger guard
     {
         Lock guard(m_mutex);
 
         epics::pvData::TimeStamp now;
         now.getCurrent();
-        int64_t nowMS = now.getMilliseconds();
+        nowMS = now.getMilliseconds();
 
         if (nowMS - m_lastTimeSent < 100)
             return;
         m_lastTimeSent = nowMS;
     }
 
-
-    int count = 0;
-    int frameSent = 0;
+    // no UDP search when only name servers are configured
+    bool udpSearch = false;
+    {
+        Context::shared_pointer context(m_context.lock());
+        if (context)
+        {
+            BlockingUDPTransport::shared_pointer ut(std::tr1::static_pointer_cast<BlockingUDPTransport>(context->getSearchTransport()));
+            udpSearch = ut && !ut->getSendAddresses().empty();
+        }
+    }
 
     vector<SearchInstance::shared_pointer> toSend;
+    int32_t window;
     {
         Lock guard(m_channelMutex);
-        toSend.reserve(m_channels.size());
+        Lock guard2(m_userValueMutex);
+
+        const uint32_t tick = ++m_tick;
+
+        adjustWindow();
+        window = m_window;
+
+        // bytes of channel names (and CIDs) which may be sent
+        size_t budget = udpSearch ? size_t(window)*FRAME_CAPACITY : size_t(-1);
+        bool full = false;
 
-        for(m_channels_t::iterator channelsIter = m_channels.begin();
-            channelsIter != m_channels.end(); channelsIter++)
+        // those left over from previous periods first
+        while (!m_backlog.empty() && !full)
         {
-            SearchInstance::shared_pointer inst(channelsIter->second.lock());
-            if(!inst) continue;
+            m_channels_t::iterator it(m_channels.find(m_backlog.front()));
+            if (it != m_channels.end() && it->second.due == BACKLOG_DUE)
+            {
+                SearchInstance::shared_pointer inst(it->second.instance.lock());
+                if (!inst)
+                {
+                    m_channels.erase(it);
+                }
+                else
+                {
+                    const size_t size = 4u + 5u + inst->getSearchInstanceName().size();
+                    if (size > budget)
+                    {
+                        full = true;
+                        break;
+                    }
+                    budget -= size;
+
+                    int32_t& interval = inst->getUserValue();
+                    schedule(it, tick + interval);
+                    interval = std::min(interval*2, MAX_USER_VALUE);
+                    toSend.push_back(inst);
+                }
+            }
+            m_backlog.pop_front();
+        }
+
+        std::vector<pvAccessID> due;
+        due.swap(m_wheel[tick % WHEEL_SIZE]);
+
+        for (size_t i = 0; i < due.size(); i++)
+        {
+            m_channels_t::iterator it(m_channels.find(due[i]));
+            // unregistered, or re-scheduled
+            if (it == m_channels.end() || it->second.due != tick)
+                continue;
+
+            SearchInstance::shared_pointer inst(it->second.instance.lock());
+            if (!inst)
+            {
+                m_channels.erase(it);
+                continue;
+            }
+
+            const size_t size = 4u + 5u + inst->getSearchInstanceName().size();
+            if (full || size > budget)
+            {
+                full = true;
+                schedule(it, BACKLOG_DUE);
+                continue;
+            }
+            budget -= size;
+
+            int32_t& interval = inst->getUserValue();
+            schedule(it, tick + interval);
+            interval = std::min(interval*2, MAX_USER_VALUE);
             toSend.push_back(inst);
         }
+
+        m_sentLast = toSend.size();
     }
 
-    vector<SearchInstance::shared_pointer>::iterator siter = toSend.begin();
-    for (; siter != toSend.end(); siter++)
+    if (udpSearch && !toSend.empty())
     {
-        bool skip;
-        {
-            epicsGuard<epicsMutex> G(m_userValueMutex);
-            int32_t& countValue = (*siter)->getUserValue();
-            skip = !isPowerOfTwo(countValue);
+        // spread bursts over the first half of the period
+        const double burstDelay = ATOMIC_PERIOD/2.0*MAX_FRAMES_AT_ONCE/window;
+        int frameSent = 0;
 
-            if (countValue >= MAX_COUNT_VALUE)
-                countValue = MAX_FALLBACK_COUNT_VALUE;
-            else
-                countValue++;
+        for (size_t i = 0; i < toSend.size(); i++)
+        {
+            if (generateSearchRequestMessage(toSend[i], true, false))
+                frameSent++;
+            if (frameSent == MAX_FRAMES_AT_ONCE)
+            {
+                epicsThreadSleep(burstDelay);
+                frameSent = 0;
+            }
         }
 
-        // back-off
-        if (skip)
-            continue;
+        flushSendBuffer();
+    }
 
-        count++;
+    if (!toSend.empty())
+        searchNameServers(toSend);
+}
 
-        if (generateSearchRequestMessage(*siter, true, false))
-            frameSent++;
-        if (frameSent == MAX_FRAMES_AT_ONCE)
+void ChannelSearchManager::searchNameServers(const std::vector<SearchInstance::shared_pointer>& toSend)
+{
+    // fixed after activate()
+    if (m_nameServers.empty())
+        return;
+
+    vector<Transport::shared_pointer> connected;
+    connected.reserve(m_nameServers.size());
+    bool missing = false;
+    {
+        Lock guard(m_nameServerMutex);
+
+        for (size_t i=0; i<m_nameServers.size(); i++)
         {
-            epicsThreadSleep(DELAY_BETWEEN_FRAMES_MS/(double)1000.0);
-            frameSent = 0;
+            const NameServer& ns = m_nameServers[i];
+
+            if (ns.transport && !ns.transport->isClosed())
+                connected.push_back(ns.transport);
+            else
+                missing = true;
         }
     }
 
-    if (count > 0)
-        flushSendBuffer();
+    // never connect from the timer thread
+    if (missing)
+        m_nameServerWakeup.signal();
+
+    for (size_t t=0; t<connected.size(); t++)
+    {
+        for (size_t start=0; start<toSend.size(); start += NAME_SERVER_BATCH)
+        {
+            // an entry may only be queued to one transport
+            std::tr1::shared_ptr<NameServerSearch> req(new NameServerSearch(m_sequenceNumber, m_responseAddress));
+            req->channels.assign(toSend.begin()+start,
+                                 toSend.begin()+std::min(toSend.size(), start+NAME_SERVER_BATCH));
+            connected[t]->enqueueSendRequest(req);
+        }
+    }
 }
 
-bool ChannelSearchManager::isPowerOfTwo(int32_t x)
+void ChannelSearchManager::nameServerConnector()
 {
-    return ((x > 0) && (x & (x - 1)) == 0);
+    while (!m_canceled.get())
+    {
+        epics::pvData::TimeStamp now;
+        now.getCurrent();
+        const int64_t nowMS = now.getMilliseconds();
+
+        for (size_t i=0; i<m_nameServers.size() && !m_canceled.get(); i++)
+        {
+            osiSockAddr address;
+            {
+                Lock guard(m_nameServerMutex);
+                NameServer& ns = m_nameServers[i];
+
+                if (ns.transport && ns.transport->isClosed())
+                    ns.transport.reset();
+
+                if (ns.transport || nowMS - ns.lastAttempt < NAME_SERVER_RECONNECT_MS)
+                    continue;
+                ns.lastAttempt = nowMS;
+                address = ns.address;
+            }
+
+            ClientContextImpl::shared_pointer context(std::tr1::dynamic_pointer_cast<ClientContextImpl>(m_context.lock()));
+            if (!context)
+                return;
+
+            // may block until the connection timeout.
+            // no client.  Connection is kept open until context is destroyed
+            Transport::shared_pointer transport(context->getTransport(ClientChannelImpl::shared_pointer(), &address,
+                                                                      PVA_CLIENT_PROTOCOL_REVISION, PVA_DEFAULT_PRIORITY));
+            if (!transport)
+                LOG(logLevelDebug, "Unable to connect to name server %s", inetAddressToString(address).c_str());
+
+            Lock guard(m_nameServerMutex);
+            m_nameServers[i].transport = transport;
+        }
+
+        m_nameServerWakeup.wait(NAME_SERVER_RECONNECT_MS/1000.0);
+    }
 }
 
 void ChannelSearchManager::timerStopped()
@@ -10,8 +10,14 @@
 #include <limits>
 #include <stdexcept>
 #include <sstream>
+#include <cstring>
+#include <errno.h>
 #include <sys/types.h>
 
+#if !defined(_WIN32)
+#  include <sys/uio.h>
+#endif
+
 #include <osiSock.h>
 #include <epicsTime.h>
 #include <epicsThread.h>
@@ -698,12 +704,15 @@ void AbstractCodec::flushSerializeBuffer() {
     flush(false);
 }
 
-void AbstractCodec::flushSendBuffer() {
+void AbstractCodec::flushSendBuffer(ByteBuffer *payload) {
 
     _sendBuffer.flip();
 
     try {
-        send(&_sendBuffer);
+        if(payload)
+            send(&_sendBuffer, payload);
+        else
+            send(&_sendBuffer);
     } catch (io_exception &) {
         try {
             if (isOpen())
@@ -805,7 +814,54 @@ void AbstractCodec::send(ByteBuffer *buffer)
 }
 
 
+// send all of buffer, then all of payload
+void AbstractCodec::send(ByteBuffer *buffer, ByteBuffer *payload)
+{
+    int tries = 0;
+    while (buffer->getRemaining() > 0 || payload->getRemaining() > 0)
+    {
+        int bytesSent = writeGather(buffer, payload);
+
+        if (bytesSent < 0)
+        {
+            // connection lost
+            close();
+            throw connection_closed_exception("bytesSent < 0");
+        }
+        else if (bytesSent == 0)
+        {
+            sendBufferFull(tries++);
+            continue;
+        }
+
+        atomic::add(_totalBytesSent, bytesSent);
+        tries = 0;
+    }
+}
+
+
+int AbstractCodec::writeGather(ByteBuffer *first, ByteBuffer *second)
+{
+    if (first->getRemaining() > 0)
+        return write(first);
+    else
+        return write(second);
+}
+
+
 void AbstractCodec::processSendQueue()
+{
+    processSendQueue(true);
+}
+
+
+bool AbstractCodec::processReadySenders()
+{
+    return processSendQueue(false);
+}
+
+
+bool AbstractCodec::processSendQueue(bool wait)
 {
 
     {
@@ -822,6 +878,9 @@ void AbstractCodec::processSendQueue()
 
                 sendCompleted();    // do not schedule sending
 
+                if (!wait)          // event driven, scheduleSend() will call again
+                    return false;
+
                 if (terminated())   // termination
                     break;
                 // termination (we want to process even if shutdown)
@@ -842,6 +901,8 @@ void AbstractCodec::processSendQueue()
     // flush
     if (_sendBuffer.getPosition() > 0)
         flush(true);
+
+    return !_sendQueue.empty();
 }
 
 
@@ -956,16 +1017,14 @@ bool AbstractCodec::directSerialize(ByteBuffer* /*existingBuffer*/, const char*
     // TODO size_t to int32
     startMessage(_lastSegmentedMessageCommand, 0, static_cast<int32>(count));
 
-    // flush
-    flushSendBuffer();
-
     // TODO think if alignment is preserved after...
 
     //
-    // send toSerialize buffer
+    // flush, and send toSerialize buffer without copying.
+    // toSerialize is owned by the caller, and remains valid until we return.
     //
     ByteBuffer wrappedBuffer(const_cast<char*>(toSerialize), count);
-    send(&wrappedBuffer);
+    flushSendBuffer(&wrappedBuffer);
 
     //
     // continue where we left before calling directSerialize
@@ -978,7 +1037,82 @@ bool AbstractCodec::directSerialize(ByteBuffer* /*existingBuffer*/, const char*
 bool AbstractCodec::directDeserialize(ByteBuffer *existingBuffer, char* deserializeTo,
                                       std::size_t elementCount, std::size_t elementSize)
 {
-    return false;
+    // Only called by pvData when no byte swapping is needed.
+    // Anything else must go through _socketBuffer.
+    if (existingBuffer != &_socketBuffer)
+        return false;
+
+    std::size_t count = elementCount * elementSize;
+
+    // same threshold as directSerialize()
+    if (count < 64*1024)
+        return false;
+
+    try
+    {
+        while (count > 0)
+        {
+            // first, whatever is already buffered
+            std::size_t buffered = std::min(_socketBuffer.getRemaining(), count);
+            if (buffered > 0)
+            {
+                std::size_t pos = _socketBuffer.getPosition();
+                memcpy(deserializeTo, _socketBuffer.getBuffer() + pos, buffered);
+                _socketBuffer.setPosition(pos + buffered);
+                deserializeTo += buffered;
+                count -= buffered;
+                continue;
+            }
+
+            // buffer is empty.  Remainder of the current (segment) payload not yet read?
+            std::size_t consumed = _socketBuffer.getPosition() - _storedPosition;
+            std::size_t payloadLeft = _storedPayloadSize > consumed ? _storedPayloadSize - consumed : 0u;
+
+            if (payloadLeft == 0)
+            {
+                // end of segment.  handle next header(s) and fill buffer as usual
+                ensureData(1);
+                continue;
+            }
+
+            // read straight into destination
+            std::size_t direct = std::min(payloadLeft, count);
+            ByteBuffer wrappedBuffer(deserializeTo, direct);
+            while (wrappedBuffer.getRemaining() > 0)
+            {
+                int bytesRead = read(&wrappedBuffer);
+
+                if (bytesRead < 0)
+                {
+                    close();
+                    throw connection_closed_exception("bytesRead < 0");
+                }
+                else if (bytesRead == 0)
+                {
+                    readPollOne();
+                    continue;
+                }
+
+                atomic::add(_totalBytesRecv, bytesRead);
+            }
+
+            // these bytes of the payload bypassed _socketBuffer
+            _storedPayloadSize -= direct;
+            deserializeTo += direct;
+            count -= direct;
+        }
+    }
+    catch (io_exception &) {
+        try {
+            close();
+        } catch (io_exception & ) {
+            // noop, best-effort close
+        }
+        throw connection_closed_exception(
+            "Failed to read directly into destination.");
+    }
+
+    return true;
 }
 
 //
@@ -996,14 +1130,246 @@ BlockingTCPTransportCodec::~BlockingTCPTransportCodec()
 }
 
 void BlockingTCPTransportCodec::readPollOne() {
-    throw std::logic_error("should not be called for blocking IO");
+    if(!_reactor)
+        throw std::logic_error("should not be called for blocking IO");
+    // only whole messages are passed to processRead(), so the peer sent less than it announced
+    LOG(logLevelError, "%s : Truncated message received, disconnecting...", _socketName.c_str());
+    close();
+    throw connection_closed_exception("truncated message");
 }
 
 
 void BlockingTCPTransportCodec::writePollOne() {
+    // with _reactor, write() keeps what the socket does not accept
     throw std::logic_error("should not be called for blocking IO");
 }
 
+namespace {
+// bytes moved from socket to BlockingTCPTransportCodec::_rxStage by one recv()
+const size_t rxChunk = 64u*1024u;
+// limit on recv() calls by one readReady(), so that one busy connection can't starve others
+const size_t rxChunkMax = 16u;
+}
+
+bool BlockingTCPTransportCodec::rxFill()
+{
+    // drop what read() has already returned
+    if(_rxPos) {
+        _rxStage.erase(_rxStage.begin(), _rxStage.begin()+_rxPos);
+        _rxComplete -= _rxPos;
+        _rxScan -= _rxPos;
+        _rxPos = 0u;
+    }
+    // don't hold on to storage for an unusually large message
+    if(_rxStage.empty() && _rxStage.capacity() > rxChunk*rxChunkMax)
+        std::vector<char>().swap(_rxStage);
+
+    for(size_t i=0; i<rxChunkMax; i++) {
+        const size_t before = _rxStage.size();
+        _rxStage.resize(before + rxChunk);
+
+        int bytesRead = ::recv(_channel, &_rxStage[before], rxChunk, 0);
+        int err = bytesRead<0 ? SOCKERRNO : 0;
+
+        _rxStage.resize(before + std::max(0, bytesRead));
+
+        if(bytesRead>0)
+            epicsTimeGetCurrent(&_lastRx);
+
+        if(bytesRead==0) {
+            return false; // connection loss
+
+        } else if(bytesRead<0) {
+            if(err==SOCK_EINTR)
+                continue;
+            else if(err==SOCK_EWOULDBLOCK || err==EAGAIN)
+                break; // nothing more to read
+            if(_isOpen.get() && err!=SOCK_ECONNRESET && err!=SOCK_ECONNABORTED)
+                errlogPrintf("%s : Connection closed with RX socket error %d\n", _socketName.c_str(), err);
+            return false;
+
+        } else if(size_t(bytesRead) < rxChunk) {
+            break; // socket buffer drained
+        }
+    }
+
+    // find the end of the last complete message, or segmented message.
+    // cf. processHeader()
+    while(_rxStage.size() - _rxScan >= PVA_MESSAGE_HEADER_SIZE) {
+        const epicsUInt8 *header = (const epicsUInt8*)&_rxStage[_rxScan];
+
+        if(header[0]!=epicsUInt8(PVA_MAGIC)) {
+            // let processHeader() reject
+            _rxScan = _rxComplete = _rxStage.size();
+            break;
+        }
+
+        const epicsUInt8 flags = header[2];
+        const bool isControl = flags&0x01;
+        size_t payloadSize = 0u;
+        if(!isControl) {
+            // for control messages, this is data
+            if(flags&0x80)
+                payloadSize = (epicsUInt32(header[4])<<24) | (epicsUInt32(header[5])<<16) | (epicsUInt32(header[6])<<8) | header[7];
+            else
+                payloadSize = (epicsUInt32(header[7])<<24) | (epicsUInt32(header[6])<<16) | (epicsUInt32(header[5])<<8) | header[4];
+        }
+
+        if(payloadSize > _rxMax) {
+            LOG(logLevelError, "%s : Closing connection, message of %zu bytes exceeds limit of %zu bytes.",
+                _socketName.c_str(), payloadSize, _rxMax);
+            return false;
+        }
+
+        if(_rxStage.size() - _rxScan - PVA_MESSAGE_HEADER_SIZE < payloadSize)
+            break; // wait for the rest of the payload
+
+        _rxScan += PVA_MESSAGE_HEADER_SIZE + payloadSize;
+
+        if(!isControl) {
+            // first (0x10) and in-between (0x30) segments are followed by more
+            const epicsUInt8 segment = flags&0x30;
+            _rxSegmented = segment==0x10 || segment==0x30;
+        }
+        if(!_rxSegmented)
+            _rxComplete = _rxScan;
+    }
+
+    // a segmented message is only processed once all segments have arrived,
+    // so don't let a peer which never sends the last segment grow _rxStage without bound.
+    if(_rxStage.size() - _rxComplete > _rxMax) {
+        LOG(logLevelError, "%s : Closing connection, incomplete message of %zu bytes exceeds limit of %zu bytes.",
+            _socketName.c_str(), _rxStage.size() - _rxComplete, _rxMax);
+        return false;
+    }
+
+    return true;
+}
+
+bool BlockingTCPTransportCodec::txDrain()
+{
+    while(_txPos < _txPending.size()) {
+        int bytesSent = ::send(_channel, &_txPending[_txPos], _txPending.size()-_txPos, 0);
+
+        if(unlikely(bytesSent<0)) {
+            int socketError = SOCKERRNO;
+            if (socketError==SOCK_EINTR)
+                continue;
+            else if (socketError==SOCK_ENOBUFS || socketError==SOCK_EWOULDBLOCK || socketError==EAGAIN)
+                return true; // still full
+            return false;
+        }
+
+        _txPos += bytesSent;
+    }
+
+    if(_txPending.capacity() > rxChunk*rxChunkMax)
+        std::vector<char>().swap(_txPending);
+    else
+        _txPending.clear();
+    _txPos = 0u;
+    return true;
+}
+
+int BlockingTCPTransportCodec::txDefer(ByteBuffer* first, ByteBuffer* second)
+{
+    // drop what has already been sent
+    if(_txPos) {
+        _txPending.erase(_txPending.begin(), _txPending.begin()+_txPos);
+        _txPos = 0u;
+    }
+    ByteBuffer* bufs[2] = {first, second};
+    size_t total = 0u;
+    for(size_t i=0; i<2; i++) {
+        if(!bufs[i])
+            continue;
+        const size_t pos = bufs[i]->getPosition(),
+                     remaining = bufs[i]->getRemaining();
+        const char *data = bufs[i]->getBuffer()+pos;
+        _txPending.insert(_txPending.end(), data, data+remaining);
+        bufs[i]->setPosition(pos + remaining);
+        total += remaining;
+    }
+    // writeReady() will be called when the socket has room
+    scheduleSend();
+    return int(total);
+}
+
+void BlockingTCPTransportCodec::scheduleSend() {
+    if(_reactor)
+        _reactor->requestWrite(_channel);
+}
+
+void BlockingTCPTransportCodec::readReady()
+{
+    try {
+        if(!rxFill()) {
+            close();
+            return;
+        }
+        // processRead() returns after MAX_MESSAGE_PROCESS messages, which may leave
+        // complete messages buffered for which no further readiness event will come.
+        while(isOpen() && (_rxPos < _rxComplete || _socketBuffer.getRemaining() >= PVA_MESSAGE_HEADER_SIZE)) {
+            processRead();
+        }
+        return;
+    } catch (std::exception &e) {
+        PRINT_EXCEPTION(e);
+        LOG(logLevelError,
+            "an exception caught while in readReady at %s:%d: %s",
+            __FILE__, __LINE__, e.what());
+    } catch (...) {
+        LOG(logLevelError,
+            "unknown exception caught while in readReady at %s:%d.",
+            __FILE__, __LINE__);
+    }
+    // exception
+    close();
+}
+
+void BlockingTCPTransportCodec::writeReady()
+{
+    try {
+        // what the socket did not accept earlier goes before anything new
+        if(!txDrain()) {
+            close();
+            return;
+        }
+        if(!_txPending.empty())
+            scheduleSend(); // still full
+        else if(processReadySenders())
+            scheduleSend();
+        return;
+    } catch (connection_closed_exception &) {
+        // noop
+    } catch (std::exception &e) {
+        PRINT_EXCEPTION(e);
+        LOG(logLevelWarn,
+            "an exception caught while in writeReady at %s:%d: %s",
+            __FILE__, __LINE__, e.what());
+    } catch (...) {
+        LOG(logLevelWarn,
+            "unknown exception caught while in writeReady at %s:%d.",
+            __FILE__, __LINE__);
+    }
+    // exception
+    close();
+}
+
+void BlockingTCPTransportCodec::periodic()
+{
+    // cf. SO_RCVTIMEO in setRxTimeout()
+    if(_rxTimeout<=0.0 || !isOpen())
+        return;
+
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+    if(epicsTimeDiffInSeconds(&now, &_lastRx) > _rxTimeout) {
+        LOG(logLevelDebug, "%s : Connection timeout", _socketName.c_str());
+        close();
+    }
+}
+
 
 void BlockingTCPTransportCodec::close() {
 
@@ -1015,21 +1381,32 @@ void BlockingTCPTransportCodec::close() {
         // clean resources (close socket)
         internalClose();
 
-        // Break sender from queue wait
-        BreakTransport::shared_pointer B(new BreakTransport);
-        enqueueSendRequest(B);
+        if(_reactor) {
+            // no sender thread to wake
+            _sendQueue.clear();
+        } else {
+            // Break sender from queue wait
+            BreakTransport::shared_pointer B(new BreakTransport);
+            enqueueSendRequest(B);
+        }
     }
 }
 
 void BlockingTCPTransportCodec::waitJoin()
 {
     assert(!_isOpen.get());
-    _sendThread.exitWait();
-    _readThread.exitWait();
+    if(_sendThread.get())
+        _sendThread->exitWait();
+    if(_readThread.get())
+        _readThread->exitWait();
 }
 
 void BlockingTCPTransportCodec::internalClose()
 {
+    // stop readiness callbacks before the socket can be re-used
+    if(_reactor)
+        _reactor->remove(_channel);
+
     {
 
         epicsSocketSystemCallInterruptMechanismQueryInfo info  =
@@ -1087,9 +1464,37 @@ bool BlockingTCPTransportCodec::isOpen() {
 // NOTE: must not be called from constructor (e.g. needs shared_from_this())
 void BlockingTCPTransportCodec::start() {
 
-    _readThread.start();
+    if(_reactor) {
+        // cf. receiveThread()
+        setRxTimeout(true);
+        epicsTimeGetCurrent(&_lastRx);
+
+        osiSockIoctl_t nonblocking = 1;
+        if(socket_ioctl(_channel, FIONBIO, &nonblocking)) {
+            char errStr[64];
+            epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+            throw std::runtime_error(_socketName+" : Unable to set non-blocking: "+errStr);
+        }
 
-    _sendThread.start();
+        _reactor->add(_channel, shared_from_this());
+
+        // verification may already be queued
+        if(!sendQueueEmpty())
+            scheduleSend();
+        return;
+    }
+
+    _readThread.reset(new epics::pvData::Thread(
+                          epics::pvData::Thread::Config(this, &BlockingTCPTransportCodec::receiveThread)
+                          .prio(epicsThreadPriorityCAServerLow)
+                          .name("TCP-rx")
+                          .stack(epicsThreadStackBig)));
+
+    _sendThread.reset(new epics::pvData::Thread(
+                          epics::pvData::Thread::Config(this, &BlockingTCPTransportCodec::sendThread)
+                          .prio(epicsThreadPriorityCAServerLow)
+                          .name("TCP-tx")
+                          .stack(epicsThreadStackBig)));
 
 }
 
@@ -1176,6 +1581,9 @@ void BlockingTCPTransportCodec::setRxTimeout(bool ena)
      * - As a compromise, continue to send echo every 15 seconds, but increase default timeout to 40.
      */
     double timeout = !ena ? 0.0 : 4.0/3.0*std::max(0.0, _context->getConfiguration()->getPropertyAsDouble("EPICS_PVA_CONN_TMO", 30.0));
+    _rxTimeout = timeout;
+    if(_reactor)
+        return; // applied by periodic()
 #ifdef _WIN32
     DWORD timo = DWORD(timeout*1000); // in milliseconds
 #else
@@ -1196,6 +1604,11 @@ void BlockingTCPTransportCodec::setRxTimeout(bool ena)
 }
 
 void BlockingTCPTransportCodec::sendBufferFull(int tries) {
+    if(_shmTx) {
+        // the peer only has to copy out of the ring
+        epicsThreadSleep(tries<100 ? 0.0 : 0.001);
+        return;
+    }
     // TODO constants
     epicsThreadSleep(std::max<double>(tries * 0.1, 1));
 }
@@ -1209,6 +1622,7 @@ void BlockingTCPTransportCodec::sendBufferFull(int tries) {
 //
 
 size_t BlockingTCPTransportCodec::num_instances;
+int BlockingTCPTransportCodec::num_local;
 
 BlockingTCPTransportCodec::BlockingTCPTransportCodec(bool serverFlag, const Context::shared_pointer &context,
     SOCKET channel, const ResponseHandler::shared_pointer &responseHandler,
@@ -1220,17 +1634,22 @@ BlockingTCPTransportCodec::BlockingTCPTransportCodec(bool serverFlag, const Cont
          receiveBufferSize,
          sendBufferSize,
          true)
-    ,_readThread(epics::pvData::Thread::Config(this, &BlockingTCPTransportCodec::receiveThread)
-                 .prio(epicsThreadPriorityCAServerLow)
-                 .name("TCP-rx")
-                 .stack(epicsThreadStackBig)
-                 .autostart(false))
-    ,_sendThread(epics::pvData::Thread::Config(this, &BlockingTCPTransportCodec::sendThread)
-                 .prio(epicsThreadPriorityCAServerLow)
-                 .name("TCP-tx")
-                 .stack(epicsThreadStackBig)
-                 .autostart(false))
+    ,_reactor(context->getTransportReactor())
+    ,_rxTimeout(0.0)
+    ,_rxPos(0u)
+    ,_rxComplete(0u)
+    ,_rxScan(0u)
+    ,_rxSegmented(false)
+    ,_rxMax(std::max(receiveBufferSize,
+                     size_t(std::max(0, context->getConfiguration()->getPropertyAsInteger("EPICS_PVA_MAX_MESSAGE_BYTES", 64*1024*1024)))))
+    ,_txPos(0u)
     ,_channel(channel)
+    ,_shmSize(serverFlag ? 0u : size_t(std::max(0, context->getConfiguration()->getPropertyAsInteger("EPICS_PVA_SHM_SIZE", 0))))
+    ,_shmAllowed(serverFlag && context->getConfiguration()->getPropertyAsBoolean("EPICS_PVAS_SHM", true))
+    ,_shmTx(false)
+    ,_shmRx(false)
+    ,_shmOffered(false)
+    ,_localSocket(false)
     ,_context(context), _responseHandler(responseHandler)
     ,_remoteTransportReceiveBufferSize(MAX_TCP_RECV)
     ,_priority(priority)
@@ -1250,6 +1669,28 @@ BlockingTCPTransportCodec::BlockingTCPTransportCodec(bool serverFlag, const Cont
             "Error fetching socket remote address: %s.",
             errStr);
         _socketName = "<unknown>:0";
+#ifdef PVA_UNIX_SOCKET
+    } else if(_socketAddress.sa.sa_family==AF_UNIX) {
+        // local socket.  The client side has no name, so use the server side
+        sockaddr_un local;
+        memset(&local, 0, sizeof(local));
+        osiSocklen_t len = sizeof(local);
+        if(getsockname(_channel, (sockaddr*)&local, &len)!=0 || !local.sun_path[0]) {
+            len = sizeof(local);
+            getpeername(_channel, (sockaddr*)&local, &len);
+        }
+        local.sun_path[sizeof(local.sun_path)-1] = '\0';
+        _socketName = std::string("unix:")+local.sun_path;
+        _localSocket = true;
+
+        // make up a unique TransportRegistry key in 0.0.0.0/8, which is never a peer address.
+        // The client replaces this with the server's TCP address.
+        const epicsUInt32 id = epicsUInt32(atomic::increment(num_local));
+        memset(&_socketAddress, 0, sizeof(_socketAddress));
+        _socketAddress.ia.sin_family = AF_INET;
+        _socketAddress.ia.sin_addr.s_addr = htonl(id&0x00ffffff);
+        _socketAddress.ia.sin_port = htons(epicsUInt16(id>>24));
+#endif
     } else {
         char ipAddrStr[24];
         ipAddrToDottedIP(&_socketAddress.ia, ipAddrStr, sizeof(ipAddrStr));
@@ -1266,6 +1707,16 @@ void BlockingTCPTransportCodec::invalidDataStreamHandler() {
 int BlockingTCPTransportCodec::write(
     epics::pvData::ByteBuffer *src) {
 
+    if(_shmTx)
+        return shmWrite(src, 0);
+    else if(_reactor && !_txPending.empty()) {
+        // keep order.  Send directly only once earlier bytes are out
+        if(!txDrain())
+            return -1;
+        if(!_txPending.empty())
+            return txDefer(src, 0);
+    }
+
     std::size_t remaining;
     while((remaining=src->getRemaining()) > 0) {
 
@@ -1284,6 +1735,9 @@ int BlockingTCPTransportCodec::write(
             // spurious EINTR check
             if (socketError==SOCK_EINTR)
                 continue;
+            // non-blocking socket (TransportReactor) is full.  Keep the rest for writeReady()
+            else if (_reactor && (socketError==SOCK_ENOBUFS || socketError==SOCK_EWOULDBLOCK || socketError==EAGAIN))
+                return txDefer(src, 0);
             else if (socketError==SOCK_ENOBUFS)
                 return 0;
         }
@@ -1300,16 +1754,113 @@ int BlockingTCPTransportCodec::write(
 }
 
 
+int BlockingTCPTransportCodec::writeGather(
+    epics::pvData::ByteBuffer *first, epics::pvData::ByteBuffer *second) {
+    if(_shmTx)
+        return shmWrite(first, second);
+    else if(_reactor && !_txPending.empty()) {
+        // keep order.  Send directly only once earlier bytes are out
+        if(!txDrain())
+            return -1;
+        if(!_txPending.empty())
+            return txDefer(first, second);
+    }
+#if defined(_WIN32)
+    return AbstractCodec::writeGather(first, second);
+#else
+    while(first->getRemaining() > 0 || second->getRemaining() > 0) {
+
+        iovec iov[2];
+        size_t niov = 0;
+        ByteBuffer* bufs[2] = {first, second};
+        for(size_t i=0; i<2; i++) {
+            if(bufs[i]->getRemaining()==0)
+                continue;
+            iov[niov].iov_base = const_cast<char*>(&bufs[i]->getBuffer()[bufs[i]->getPosition()]);
+            iov[niov].iov_len = bufs[i]->getRemaining();
+            niov++;
+        }
+
+        msghdr msg = msghdr();
+        msg.msg_iov = iov;
+        msg.msg_iovlen = niov;
+
+        ssize_t bytesSent = ::sendmsg(_channel, &msg, 0);
+
+        // NOTE: do not log here, you might override SOCKERRNO relevant to recv() operation above
+
+        if(unlikely(bytesSent<0)) {
+
+            int socketError = SOCKERRNO;
+
+            // spurious EINTR check
+            if (socketError==SOCK_EINTR)
+                continue;
+            // non-blocking socket (TransportReactor) is full.  Keep the rest for writeReady()
+            else if (_reactor && (socketError==SOCK_ENOBUFS || socketError==SOCK_EWOULDBLOCK || socketError==EAGAIN))
+                return txDefer(first, second);
+            else if (socketError==SOCK_ENOBUFS)
+                return 0;
+
+            return -1;
+        }
+
+        // advance past what was sent, first fills before second
+        size_t sent = bytesSent;
+        for(size_t i=0; i<2 && sent; i++) {
+            size_t n = std::min(sent, bufs[i]->getRemaining());
+            bufs[i]->setPosition(bufs[i]->getPosition() + n);
+            sent -= n;
+        }
+
+        return int(bytesSent);
+    }
+
+    return 0;
+#endif
+}
+
+
 int BlockingTCPTransportCodec::read(epics::pvData::ByteBuffer* dst) {
 
+    if(_reactor) {
+        // only whole messages, as found by rxFill()
+        const std::size_t n = std::min(dst->getRemaining(), _rxComplete - _rxPos);
+        if(n) {
+            std::size_t pos = dst->getPosition();
+            memcpy((char*)(dst->getBuffer()+pos), &_rxStage[_rxPos], n);
+            dst->setPosition(pos + n);
+            _rxPos += n;
+        }
+        return int(n);
+    }
+
     std::size_t remaining;
     while((remaining=dst->getRemaining()) > 0) {
 
         // read
         std::size_t pos = dst->getPosition();
+        char *buf = (char*)(dst->getBuffer()+pos);
+        char doorbell[64];
+
+        if(_shmRx) {
+            size_t n = _shm->read(_clientServerFlag ? ShmRing::ClientToServer : ShmRing::ServerToClient,
+                                  buf, remaining);
+            if(unlikely(n==ShmRing::corrupt)) {
+                LOG(logLevelError, "%s : Shared memory ring corrupted.  Closing", _socketName.c_str());
+                _shmRx = false;
+                close();
+                return -1;
+            } else if(n) {
+                dst->setPosition(pos + n);
+                return int(n);
+            }
+            // ring is empty.  wait for the peer to write more.
+            buf = doorbell;
+            remaining = sizeof(doorbell);
+        }
 
-        int bytesRead = ::recv(_channel,
-                             (char*)(dst->getBuffer()+pos), remaining, 0);
+        int bytesRead = ::recv(_channel, buf, remaining, 0);
 
         // NOTE: do not log here, you might override SOCKERRNO relevant to recv() operation above
 
@@ -1345,6 +1896,9 @@ int BlockingTCPTransportCodec::read(epics::pvData::ByteBuffer* dst) {
             }
         }
 
+        if(_shmRx)
+            continue; // doorbell, look again
+
         dst->setPosition(dst->getPosition() + bytesRead);
         return bytesRead;
     }
@@ -1353,6 +1907,165 @@ int BlockingTCPTransportCodec::read(epics::pvData::ByteBuffer* dst) {
 }
 
 
+void BlockingTCPTransportCodec::processControlMessage() {
+    switch(_command) {
+    case CMD_SET_ENDIANESS:
+        // check 7-th bit
+        setByteOrder(_flags < 0 ? EPICS_ENDIAN_BIG : EPICS_ENDIAN_LITTLE);
+        break;
+
+    case CMD_SHM_OFFER:
+        if(!_clientServerFlag)
+            break;
+        if(_shmOffered) {
+            // a client makes at most one offer.  Don't allow guessing of another client's token.
+            LOG(logLevelError, "Repeated shared memory offer from %s.  Disconnecting.", _socketName.c_str());
+            close();
+            break;
+        }
+        _shmOffered = true;
+        if(_shmAllowed && !_reactor && isLocalPeer()) {
+            int error = 0;
+            _shm = ShmRing::open(_payloadSize, &error);
+            if(!_shm && error!=EACCES) {
+                // a client's own segment exists, and is valid, until we accept.
+                // A peer running as another user gets EACCES, and only a reject.
+                LOG(logLevelError, "Invalid shared memory offer from %s.  Disconnecting.", _socketName.c_str());
+                close();
+                break;
+            }
+        }
+        if(_shm) {
+            LOG(logLevelDebug, "Using shared memory %s for %s", _shm->name().c_str(), _socketName.c_str());
+            enqueueShmControl(CMD_SHM_ACCEPT, 0);
+        } else {
+            enqueueShmControl(CMD_SHM_REJECT, 0);
+        }
+        break;
+
+    case CMD_SHM_ACCEPT:
+        if(_clientServerFlag || !_shm || _shmRx)
+            break;
+        LOG(logLevelDebug, "Using shared memory %s for %s", _shm->name().c_str(), _socketName.c_str());
+        _shm->unlink();
+        _shmRx = true;
+        // anything remaining in the socket buffer is doorbells
+        _socketBuffer.setPosition(_socketBuffer.getLimit());
+        enqueueShmControl(CMD_SHM_SWITCH, 0);
+        break;
+
+    case CMD_SHM_REJECT:
+        if(_clientServerFlag || !_shm || _shmRx)
+            break;
+        LOG(logLevelDebug, "%s declines shared memory", _socketName.c_str());
+        _shm.reset();
+        break;
+
+    case CMD_SHM_SWITCH:
+        if(!_clientServerFlag || !_shm || _shmRx)
+            break;
+        _shmRx = true;
+        _socketBuffer.setPosition(_socketBuffer.getLimit());
+        break;
+
+    default:
+        break;
+    }
+}
+
+struct BlockingTCPTransportCodec::ShmControlSender : public TransportSender {
+    // send() is only called from the send thread of 'codec', which joins before it is destroyed
+    BlockingTCPTransportCodec * const codec;
+    const int8 command;
+    const int32 data;
+    ShmControlSender(BlockingTCPTransportCodec *codec, int8 command, int32 data)
+        :codec(codec), command(command), data(data) {}
+    virtual ~ShmControlSender() {}
+    virtual void send(ByteBuffer* /*buffer*/, TransportSendControl* /*control*/) OVERRIDE FINAL {
+        codec->sendShmControl(command, data);
+    }
+};
+
+void BlockingTCPTransportCodec::enqueueShmControl(int8 command, int32 data)
+{
+    TransportSender::shared_pointer sender(new ShmControlSender(this, command, data));
+    enqueueSendRequest(sender);
+}
+
+void BlockingTCPTransportCodec::sendShmControl(int8 command, int32 data)
+{
+    putControlMessage(command, data);
+    // everything before the switch goes through the socket
+    flush(true);
+
+    if(command==CMD_SHM_ACCEPT || command==CMD_SHM_SWITCH)
+        _shmTx = true;
+}
+
+int BlockingTCPTransportCodec::shmWrite(ByteBuffer* first, ByteBuffer* second)
+{
+    if(!isOpen())
+        return -1;
+
+    const ShmRing::Direction dir = _clientServerFlag ? ShmRing::ServerToClient : ShmRing::ClientToServer;
+    ByteBuffer* bufs[2] = {first, second};
+    size_t total = 0u;
+    for(size_t i=0; i<2; i++) {
+        if(!bufs[i])
+            continue;
+        size_t remaining = bufs[i]->getRemaining();
+        size_t n = _shm->write(dir, &bufs[i]->getBuffer()[bufs[i]->getPosition()], remaining);
+        if(unlikely(n==ShmRing::corrupt)) {
+            LOG(logLevelError, "%s : Shared memory ring corrupted.  Closing", _socketName.c_str());
+            _shmTx = false;
+            close();
+            return -1;
+        }
+        bufs[i]->setPosition(bufs[i]->getPosition() + n);
+        total += n;
+        if(n<remaining)
+            break; // ring full
+    }
+
+    if(total) {
+        // wake the reader.  If the socket is full, then doorbells are already pending.
+        const char doorbell = 0;
+#ifdef MSG_DONTWAIT
+        const int flags = MSG_DONTWAIT;
+#else
+        const int flags = 0;
+#endif
+        (void)::send(_channel, &doorbell, 1, flags);
+    }
+    return int(total);
+}
+
+bool BlockingTCPTransportCodec::isLocalPeer() const
+{
+    if(_localSocket)
+        return true;
+    if(_socketAddress.sa.sa_family!=AF_INET)
+        return false;
+    if((ntohl(_socketAddress.ia.sin_addr.s_addr)>>24)==127u)
+        return true;
+
+    osiSockAddr local;
+    osiSocklen_t slen = sizeof(local);
+    if(getsockname(_channel, &local.sa, &slen))
+        return false;
+    return local.ia.sin_addr.s_addr==_socketAddress.ia.sin_addr.s_addr;
+}
+
+void BlockingTCPTransportCodec::shmOffer()
+{
+    if(!_shmSize || _reactor || _shm || !isLocalPeer())
+        return;
+
+    _shm = ShmRing::create(_shmSize);
+    if(_shm)
+        enqueueShmControl(CMD_SHM_OFFER, int32(_shm->token()));
+}
+
 bool BlockingTCPTransportCodec::verify(epics::pvData::int32 timeoutMs) {
     return _verifiedEvent.wait(timeoutMs/1000.0) && _verified;
 }
@@ -1426,7 +2139,7 @@ BlockingServerTCPTransportCodec::BlockingServerTCPTransportCodec(
     int32_t receiveBufferSize)
     :BlockingTCPTransportCodec(true, context, channel, responseHandler,
                                sendBufferSize, receiveBufferSize, PVA_DEFAULT_PRIORITY)
-    ,_lastChannelSID(0x12003400)
+    ,_channelCount(0)
     ,_verificationStatus(pvData::Status::fatal("Uninitialized error"))
     ,_verifyOrVerified(false)
 {
@@ -1442,13 +2155,13 @@ BlockingServerTCPTransportCodec::~BlockingServerTCPTransportCodec() {
 
 
 pvAccessID BlockingServerTCPTransportCodec::preallocateChannelSID() {
+    // reserve SID
+    return _channels.allocate();
+}
+
 
-    Lock lock(_channelsMutex);
-    // search first free (theoretically possible loop of death)
-    pvAccessID sid = ++_lastChannelSID;
-    while(_channels.find(sid)!=_channels.end())
-        sid = ++_lastChannelSID;
-    return sid;
+void BlockingServerTCPTransportCodec::depreallocateChannelSID(pvAccessID sid) {
+    _channels.remove(sid);
 }
 
 
@@ -1456,46 +2169,45 @@ void BlockingServerTCPTransportCodec::registerChannel(
     pvAccessID sid,
     ServerChannel::shared_pointer const & channel) {
 
-    Lock lock(_channelsMutex);
-    _channels[sid] = channel;
-
+    if(_channels.set(sid, channel))
+        atomic::increment(_channelCount);
 }
 
 
 void BlockingServerTCPTransportCodec::unregisterChannel(pvAccessID sid) {
 
-    Lock lock(_channelsMutex);
-    _channels.erase(sid);
+    ServerChannel::shared_pointer channel;
+    if(_channels.remove(sid, channel) && channel)
+        atomic::decrement(_channelCount);
 }
 
 
 ServerChannel::shared_pointer
 BlockingServerTCPTransportCodec::getChannel(pvAccessID sid) {
 
-    Lock lock(_channelsMutex);
-
-    std::map<pvAccessID, ServerChannel::shared_pointer>::iterator it =
-        _channels.find(sid);
-
-    if(it!=_channels.end()) return it->second;
-
-    return ServerChannel::shared_pointer();
+    ServerChannel::shared_pointer channel;
+    _channels.find(sid, channel);
+    return channel;
 }
 
 
 size_t BlockingServerTCPTransportCodec::getChannelCount() const {
 
-    Lock lock(_channelsMutex);
-    return _channels.size();
+    // not _channels.size(), which includes preallocated SIDs.
+    // may briefly be negative while a channel is registered and unregistered concurrently
+    return size_t(std::max(0, atomic::get(_channelCount)));
 }
 
 void BlockingServerTCPTransportCodec::getChannels(std::vector<ServerChannel::shared_pointer>& channels) const
 {
-    Lock lock(_channelsMutex);
-    for(_channels_t::const_iterator it(_channels.begin()), end(_channels.end());
-        it!=end; ++it)
-    {
-        channels.push_back(it->second);
+    std::vector<ServerChannel::shared_pointer> temp;
+    _channels.values(temp);
+
+    channels.reserve(channels.size()+temp.size());
+    for(size_t i=0; i<temp.size(); i++) {
+        // skip SIDs preallocated, but not yet registered
+        if(temp[i])
+            channels.push_back(temp[i]);
     }
 }
 
@@ -1589,22 +2301,25 @@ void BlockingServerTCPTransportCodec::send(ByteBuffer* buffer,
 }
 
 void BlockingServerTCPTransportCodec::destroyAllChannels() {
-    Lock lock(_channelsMutex);
-    if(_channels.size()==0) return;
+    std::vector<ServerChannel::shared_pointer> temp;
+    _channels.clear(temp);
+    if(temp.empty()) return;
 
     if (IS_LOGGABLE(logLevelDebug))
     {
         LOG(
             logLevelDebug,
             "Transport to %s still has %zu channel(s) active and closing...",
-            _socketName.c_str(), _channels.size());
+            _socketName.c_str(), temp.size());
     }
 
-    _channels_t temp;
-    temp.swap(_channels);
-
-    for(_channels_t::iterator it(temp.begin()), end(temp.end()); it!=end; ++it)
-        it->second->destroy();
+    for(size_t i=0; i<temp.size(); i++) {
+        // skip SIDs preallocated, but not yet registered
+        if(temp[i]) {
+            atomic::decrement(_channelCount);
+            temp[i]->destroy();
+        }
+    }
 }
 
 void BlockingServerTCPTransportCodec::internalClose() {
@@ -1691,13 +2406,19 @@ BlockingClientTCPTransportCodec::BlockingClientTCPTransportCodec(
     ClientChannelImpl::shared_pointer const & client,
     epics::pvData::int8 /*remoteTransportRevision*/,
     float heartbeatInterval,
-    int16_t priority ) :
+    int16_t priority,
+    const osiSockAddr* serverAddress) :
     BlockingTCPTransportCodec(false, context, channel, responseHandler,
                               sendBufferSize, receiveBufferSize, priority),
+    _pinned(false),
     _connectionTimeout(heartbeatInterval),
     _verifyOrEcho(true),
     sendQueued(true) // don't start sending echo until after auth complete
 {
+    // connected through a local socket, register as the server's TCP address
+    if(serverAddress && _localSocket)
+        _socketAddress = *serverAddress;
+
     // initialize owners list, send queue
     acquire(client);
 
@@ -1752,7 +2473,10 @@ bool BlockingClientTCPTransportCodec::acquire(ClientChannelImpl::shared_pointer
         LOG(logLevelDebug, "Acquiring transport to %s.", _socketName.c_str());
     }
 
-    _owners[client->getID()] = ClientChannelImpl::weak_pointer(client);
+    if(client)
+        _owners[client->getID()] = ClientChannelImpl::weak_pointer(client);
+    else
+        _pinned = true;
     //_owners.insert(ClientChannelImpl::weak_pointer(client));
 
     return true;
@@ -1810,7 +2534,7 @@ void BlockingClientTCPTransportCodec::release(pvAccessID clientID) {
 
     // not used anymore, close it
     // TODO consider delayed destruction (can improve performance!!!)
-    if(_owners.size()==0) {
+    if(_owners.size()==0 && !_pinned) {
         lock.unlock();
         close();
     }
@@ -1944,6 +2668,8 @@ void BlockingClientTCPTransportCodec::verified(epics::pvData::Status const & sta
     if(sess)
         sess->authenticationComplete(status);
     this->BlockingTCPTransportCodec::verified(status);
+    if(status.isSuccess())
+        shmOffer();
 }
 
 }
@@ -0,0 +1,140 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <pv/pvData.h>
+
+#define epicsExportSharedSymbols
+#include <pv/monitorElementPool.h>
+#include <pv/introspectionRegistry.h>
+
+namespace pvd = epics::pvData;
+
+namespace epics {
+namespace pvAccess {
+
+MonitorElementPool::MonitorElementPool(size_t maxPerType, size_t maxTotal)
+    :_maxPerType(maxPerType)
+    ,_maxTotal(maxTotal)
+{}
+
+MonitorElementPool::~MonitorElementPool() {}
+
+pvd::StructureConstPtr MonitorElementPool::canonical(const pvd::StructureConstPtr& type)
+{
+    Guard G(_mutex);
+
+    // only on (re)connect, so a full scan is acceptable
+    prune();
+
+    if(_entries.find(type.get())!=_entries.end())
+        return type;
+
+    // usually one candidate per hash
+    const size_t hash = IntrospectionRegistry::hash(*type);
+    std::pair<types_t::const_iterator, types_t::const_iterator> range(_types.equal_range(hash));
+    for(; range.first!=range.second; ++range.first) {
+        pvd::StructureConstPtr known(_entries[range.first->second].type.lock());
+        if(known && *known==*type)
+            return known;
+    }
+
+    Entry& ent = _entries[type.get()];
+    ent.type = type;
+    ent.hash = hash;
+    _types.insert(std::make_pair(hash, type.get()));
+    _stats.ntypes = _entries.size();
+    return type;
+}
+
+void MonitorElementPool::prune()
+{
+    for(entries_t::iterator it(_entries.begin()), end(_entries.end()); it!=end;) {
+        entries_t::iterator cur(it++);
+        // unused structures keep their type alive
+        if(!cur->second.type.expired())
+            continue;
+
+        std::pair<types_t::iterator, types_t::iterator> range(_types.equal_range(cur->second.hash));
+        for(; range.first!=range.second; ++range.first) {
+            if(range.first->second==cur->first) {
+                _types.erase(range.first);
+                break;
+            }
+        }
+        _entries.erase(cur);
+    }
+    _stats.ntypes = _entries.size();
+}
+
+pvd::PVStructurePtr MonitorElementPool::get(const pvd::StructureConstPtr& type)
+{
+    {
+        Guard G(_mutex);
+
+        entries_t::iterator it(_entries.find(type.get()));
+        if(it!=_entries.end() && !it->second.unused.empty()) {
+            Entry& ent = it->second;
+            pvd::PVStructurePtr ret;
+            ret.swap(ent.unused.back());
+            ent.unused.pop_back();
+            if(ent.unused.empty()) {
+                // no longer keep the type alive, or storage for a burst of puts
+                std::vector<pvd::PVStructurePtr>().swap(ent.unused);
+                ent.empty.reset();
+            }
+            _stats.npooled--;
+            _stats.nreused++;
+            return ret;
+        }
+        _stats.ncreated++;
+    }
+    // allocate without lock
+    return pvd::getPVDataCreate()->createPVStructure(type);
+}
+
+void MonitorElementPool::put(const pvd::PVStructurePtr& pvStructure)
+{
+    if(!pvStructure || !pvStructure.unique() || _maxPerType==0u)
+        return;
+
+    const pvd::StructureConstPtr& type(pvStructure->getStructure());
+    pvd::PVStructurePtr empty;
+    {
+        Guard G(_mutex);
+
+        entries_t::iterator it(_entries.find(type.get()));
+        if(it==_entries.end() || it->second.unused.size()>=_maxPerType || _stats.npooled>=_maxTotal)
+            return;
+        empty = it->second.empty;
+    }
+
+    // copy and allocate without lock
+    if(!empty)
+        empty = pvd::getPVDataCreate()->createPVStructure(type);
+
+    // forget the previous owner's values, and release its array storage
+    pvStructure->copyUnchecked(*empty);
+
+    Guard G(_mutex);
+
+    entries_t::iterator it(_entries.find(type.get()));
+    if(it==_entries.end() || it->second.unused.size()>=_maxPerType || _stats.npooled>=_maxTotal)
+        return;
+
+    if(!it->second.empty)
+        it->second.empty = empty;
+    it->second.unused.push_back(pvStructure);
+    _stats.npooled++;
+}
+
+void MonitorElementPool::stats(Stats& ret) const
+{
+    Guard G(_mutex);
+    ret = _stats;
+}
+
+}
+}
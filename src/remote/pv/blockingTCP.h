@@ -10,6 +10,8 @@
 #include <set>
 #include <map>
 #include <deque>
+#include <string>
+#include <vector>
 
 #ifdef epicsExportSharedSymbols
 #   define blockingTCPEpicsExportSharedSymbols
@@ -26,6 +28,13 @@
 #include <pv/lock.h>
 #include <pv/timer.h>
 #include <pv/event.h>
+#include <pv/thread.h>
+
+// local (unix domain) stream sockets
+#if defined(AF_UNIX) && !defined(_WIN32)
+#  include <sys/un.h>
+#  define PVA_UNIX_SOCKET
+#endif
 
 #ifdef blockingTCPEpicsExportSharedSymbols
 #   define epicsExportSharedSymbols
@@ -88,20 +97,63 @@ private:
      */
     SOCKET tryConnect(osiSockAddr& address, int tries);
 
+    /**
+     * Directory of local server sockets ($EPICS_PVA_UNIX_DIR).  Empty to disable.
+     */
+    std::string _unixDir;
+
+    /**
+     * Addresses of this host, with port zero.
+     */
+    std::vector<osiSockAddr> _localAddresses;
+
+    /**
+     * If the server at this address is on this host, and has a local socket,
+     * then connect to that instead.
+     * @return INVALID_SOCKET if not possible.
+     */
+    SOCKET tryConnectLocal(const osiSockAddr& address);
 };
 
+/** The name of the local (unix) socket of the server bound to this TCP address and port.
+ * eg. "<dir>/pva-127.0.0.1-5075.sock", or "<dir>/pva-0.0.0.0-5075.sock" when bound to all interfaces.
+ */
+epicsShareFunc std::string localSocketPath(const std::string& dir, const osiSockAddr& bound);
+
 /**
  * Channel Access Server TCP acceptor.
  * @author <a href="mailto:matej.sekoranjaATcosylab.com">Matej Sekoranja</a>
  * @version $Id: BlockingTCPAcceptor.java,v 1.1 2010/05/03 14:45:42 mrkraimer Exp $
  */
-class BlockingTCPAcceptor : public epicsThreadRunable {
+class BlockingTCPAcceptor {
 public:
     POINTER_DEFINITIONS(BlockingTCPAcceptor);
 
+    struct Config {
+        //! Number of threads calling accept() on the listening socket.
+        unsigned threads;
+        //! listen() backlog
+        int backlog;
+        //! Connections started per second.  <=0 for unlimited.
+        double rate;
+        //! Connections which may be started at once, after a quiet period.
+        unsigned burst;
+        Config() :threads(1u), backlog(128), rate(0.0), burst(64u) {}
+    };
+
     BlockingTCPAcceptor(Context::shared_pointer const & context,
                         ResponseHandler::shared_pointer const & responseHandler,
-                        const osiSockAddr& addr, int receiveBufferSize);
+                        const osiSockAddr& addr, int receiveBufferSize,
+                        const Config& config = Config());
+
+    /** Accept connections on a local (unix) socket.
+     * The socket file is created, replacing any stale file, and removed by destroy().
+     * @throws std::exception if not supported, or the path is in use by another server.
+     */
+    BlockingTCPAcceptor(Context::shared_pointer const & context,
+                        ResponseHandler::shared_pointer const & responseHandler,
+                        const std::string& path, int receiveBufferSize,
+                        const Config& config = Config());
 
     virtual ~BlockingTCPAcceptor();
 
@@ -113,13 +165,18 @@ public:
         return &_bindAddress;
     }
 
+    //! Path of local socket, or empty for TCP
+    const std::string& getPath() const {
+        return _path;
+    }
+
     /**
      * Destroy acceptor (stop listening).
      */
     void destroy();
 
 private:
-    virtual void run();
+    void run();
 
     /**
      * Context instance.
@@ -137,7 +194,17 @@ private:
     osiSockAddr _bindAddress;
 
     /**
-     * Server socket channel.
+     * Local socket path, or empty for TCP.
+     */
+    const std::string _path;
+
+    /**
+     * For log messages.  IP address or path.
+     */
+    std::string _name;
+
+    /**
+     * Server socket channel.  Shared by all threads.
      */
     SOCKET _serverSocketChannel;
 
@@ -146,14 +213,22 @@ private:
      */
     int _receiveBufferSize;
 
+    const Config _config;
+
     /**
      * Destroyed flag.
      */
     bool _destroyed;
 
+    /**
+     * Admission token bucket.
+     */
+    double _tokens;
+    epicsTimeStamp _lastRefill;
+
     epics::pvData::Mutex _mutex;
 
-    epicsThread _thread;
+    std::vector<std::tr1::shared_ptr<epics::pvData::Thread> > _workers;
 
     /**
      * Initialize connection acception.
@@ -161,6 +236,22 @@ private:
      */
     int initialize();
 
+    /**
+     * Initialize accepting on local socket _path.
+     */
+    void initializeLocal();
+
+    /**
+     * Start worker threads calling accept() on _serverSocketChannel.
+     */
+    void startWorkers(const char *prefix, unsigned nthreads);
+
+    /**
+     * Wait until a new connection may be started.
+     * @return false if destroyed.
+     */
+    bool admit();
+
     /**
      * Validate connection by sending a validation message request.
      * @return <code>true</code> on success.
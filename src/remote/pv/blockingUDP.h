@@ -281,6 +281,12 @@ protected:
 private:
     bool processBuffer(Transport::shared_pointer const & transport, osiSockAddr& fromAddress, epics::pvData::ByteBuffer* receiveBuffer);
 
+    // receive loop using recvmmsg(), where available
+    void runBatched(Transport::shared_pointer const & transport);
+
+    void handleDatagram(Transport::shared_pointer const & transport, osiSockAddr& fromAddress,
+                        const char* data, size_t bytesRead);
+
     void close(bool waitForThreadToComplete);
 
     // Context only used for logging in this class
@@ -0,0 +1,97 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef CHANNELADDRESSCACHE_H
+#define CHANNELADDRESSCACHE_H
+
+#ifdef epicsExportSharedSymbols
+#   define channelAddressCacheEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <string>
+#include <map>
+
+#include <osiSock.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include <pv/sharedPtr.h>
+
+#ifdef channelAddressCacheEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#       undef channelAddressCacheEpicsExportSharedSymbols
+#endif
+
+#include <pv/pvaDefs.h>
+#include <pv/remote.h>
+
+namespace epics {
+namespace pvAccess {
+
+/** Remembers which server each channel was last connected to.
+ *
+ * Kept in a file so that a restarted client can try to connect
+ * directly, instead of searching.  A channel which is not found at
+ * its cached address is searched for as usual.
+ *
+ * The file has one line per channel: "<ip>:<port> <server GUID> <last seen> <channel name>",
+ * where last seen is seconds past the EPICS epoch.
+ */
+class epicsShareClass ChannelAddressCache
+{
+public:
+    POINTER_DEFINITIONS(ChannelAddressCache);
+
+    struct Entry {
+        osiSockAddr address;
+        ServerGUID guid;
+        //! seconds past EPICS epoch
+        epicsUInt32 lastSeen;
+    };
+
+    /**
+     * @param fname file name
+     * @param maxAge entries not seen for this many seconds are not loaded or saved.
+     */
+    ChannelAddressCache(const std::string& fname, double maxAge);
+    ~ChannelAddressCache();
+
+    //! Read entries from the file.  @returns false if the file can not be read.
+    bool load();
+    //! Write all entries to the file, if any have changed since load().  @returns false on error.
+    bool save();
+
+    bool lookup(const std::string& name, Entry& entry) const;
+    //! Record that a channel was connected to this server.
+    void update(const std::string& name, const osiSockAddr& address, const ServerGUID& guid);
+    void remove(const std::string& name);
+    //! Remove all entries of this server, eg. when it is restarted.  @returns number removed.
+    size_t invalidate(const ServerGUID& guid);
+
+    size_t size() const;
+
+    const std::string& getFileName() const { return _fname; }
+
+private:
+    typedef epicsGuard<epicsMutex> Guard;
+    typedef std::map<std::string, Entry> entries_t;
+
+    const std::string _fname;
+    const double _maxAge;
+
+    mutable epicsMutex _mutex;
+    entries_t _entries;
+    bool _dirty;
+
+    ChannelAddressCache(const ChannelAddressCache&);
+    ChannelAddressCache& operator=(const ChannelAddressCache&);
+};
+
+}
+}
+
+#endif // CHANNELADDRESSCACHE_H
@@ -12,7 +12,13 @@
 #   undef epicsExportSharedSymbols
 #endif
 
+#include <vector>
+#include <deque>
+
 #include <osiSock.h>
+#include <epicsEvent.h>
+
+#include <pv/thread.h>
 
 #ifdef channelSearchManagerEpicsExportSharedSymbols
 #   define epicsExportSharedSymbols
@@ -21,6 +27,7 @@
 
 #include <pv/pvaDefs.h>
 #include <pv/remote.h>
+#include <pv/inetAddressUtil.h>
 
 namespace epics {
 namespace pvAccess {
@@ -38,6 +45,7 @@ public:
 
     virtual const std::string& getSearchInstanceName() = 0;
 
+    //! Used by ChannelSearchManager to store the current search interval
     virtual int32_t& getUserValue() = 0;
 
     /**
@@ -51,6 +59,16 @@ public:
 };
 
 
+/** Schedules searches for registered channels.
+ *
+ * Each channel is searched at exponentially increasing intervals, from one to 128 periods.
+ * Channels are kept in a timer wheel, so each period only visits the channels due.
+ *
+ * The number of UDP frames sent per period adapts to the fraction of
+ * searches answered, doubling while most are answered, and halving
+ * (to a minimum) when few are.  Channels not sent due to this limit are
+ * sent first in the following period.
+ */
 class ChannelSearchManager :
         public epics::pvData::TimerCallback,
         public std::tr1::enable_shared_from_this<ChannelSearchManager>
@@ -106,6 +124,14 @@ public:
     ChannelSearchManager(Context::shared_pointer const & context);
     void activate();
 
+    /**
+     * Name servers are searched through a persistent TCP connection to each,
+     * in addition to any UDP search.  Must be called before activate().
+     * Connections are made by a dedicated thread, as connect() may block.
+     * @param addresses name server addresses.
+     */
+    void setNameServers(const InetAddrVector& addresses);
+
 private:
 
     bool generateSearchRequestMessage(SearchInstance::shared_pointer const & channel, bool allowNewFrame, bool flush);
@@ -118,7 +144,22 @@ private:
     void initializeSendBuffer();
     void flushSendBuffer();
 
-    static bool isPowerOfTwo(int32_t x);
+    struct Registration {
+        SearchInstance::weak_pointer instance;
+        // period when next searched, or BACKLOG_DUE
+        uint32_t due;
+    };
+    typedef std::map<pvAccessID,Registration> m_channels_t;
+
+    // call with m_channelMutex locked
+    void schedule(m_channels_t::iterator& it, uint32_t due);
+    void adjustWindow();
+
+    // only uses connections already made by nameServerConnector()
+    void searchNameServers(const std::vector<SearchInstance::shared_pointer>& toSend);
+
+    // body of m_nameServerThread
+    void nameServerConnector();
 
     /**
      * Context.
@@ -148,9 +189,35 @@ private:
     /**
      * Set of registered channels.
      */
-    typedef std::map<pvAccessID,SearchInstance::weak_pointer> m_channels_t;
     m_channels_t m_channels;
 
+    /**
+     * Timer wheel of channel IDs by period when next searched.
+     * Entries are only valid if m_channels[id].due matches.
+     */
+    std::vector<std::vector<pvAccessID> > m_wheel;
+
+    /**
+     * Channels which were due, but not sent due to m_window.
+     * Valid if m_channels[id].due==BACKLOG_DUE
+     */
+    std::deque<pvAccessID> m_backlog;
+
+    /**
+     * Current period number.
+     */
+    uint32_t m_tick;
+
+    /**
+     * Max. UDP frames sent per period.
+     */
+    int32_t m_window;
+
+    /**
+     * Channels searched in the last period, and search responses since.
+     */
+    size_t m_sentLast, m_responses;
+
     /**
      * Time of last frame send.
      */
@@ -170,6 +237,24 @@ private:
      * m_channels mutex.
      */
     epics::pvData::Mutex m_mutex;
+
+    struct NameServer {
+        osiSockAddr address;
+        Transport::shared_pointer transport;
+        int64_t lastAttempt; // time of last connect attempt (ms)
+    };
+    /**
+     * Name servers.  Entries guarded by m_nameServerMutex.
+     */
+    std::vector<NameServer> m_nameServers;
+    epics::pvData::Mutex m_nameServerMutex;
+
+    /**
+     * (Re)connects to name servers.  Started by activate() if there are any.
+     * Woken by the search timer when a connection is missing, and by cancel().
+     */
+    epics::auto_ptr<epics::pvData::Thread> m_nameServerThread;
+    epicsEvent m_nameServerWakeup;
 };
 
 }
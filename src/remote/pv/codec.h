@@ -10,6 +10,7 @@
 #include <set>
 #include <map>
 #include <deque>
+#include <vector>
 
 #include <shareLib.h>
 #include <osiSock.h>
@@ -31,6 +32,9 @@
 #include <pv/transportRegistry.h>
 #include <pv/introspectionRegistry.h>
 #include <pv/inetAddressUtil.h>
+#include <pv/transportReactor.h>
+#include <pv/slotTable.h>
+#include <pv/shmRing.h>
 
 /* C++11 keywords
  @code
@@ -155,6 +159,11 @@ public:
     virtual bool terminated() = 0;
     virtual int write(epics::pvData::ByteBuffer* src) = 0;
     virtual int read(epics::pvData::ByteBuffer* dst) = 0;
+    /** Write the remaining bytes of @p first followed by those of @p second,
+     * with a single system call where possible.
+     * Same return convention as write().  Default calls write() for each in turn.
+     */
+    virtual int writeGather(epics::pvData::ByteBuffer* first, epics::pvData::ByteBuffer* second);
     virtual bool isOpen() = 0;
 
 
@@ -177,6 +186,10 @@ public:
     void processWrite();
     void processRead();
     void processSendQueue();
+    /** Process senders already queued, but do not wait for more.
+     * @returns true if senders remain queued (MAX_MESSAGE_SEND reached)
+     */
+    bool processReadySenders();
     virtual void enqueueSendRequest(TransportSender::shared_pointer const & sender) OVERRIDE FINAL;
     void enqueueSendRequest(TransportSender::shared_pointer const & sender,
                             std::size_t requiredBufferSize);
@@ -210,7 +223,8 @@ protected:
 
     virtual void sendBufferFull(int tries) = 0;
     void send(epics::pvData::ByteBuffer *buffer);
-    void flushSendBuffer();
+    void send(epics::pvData::ByteBuffer *buffer, epics::pvData::ByteBuffer *payload);
+    void flushSendBuffer(epics::pvData::ByteBuffer *payload = 0);
 
     virtual void setRxTimeout(bool ena) {}
 
@@ -229,7 +243,7 @@ protected:
     epics::pvData::ByteBuffer _socketBuffer;
     epics::pvData::ByteBuffer _sendBuffer;
 
-    fair_queue<TransportSender> _sendQueue;
+    fair_queue_mpsc<TransportSender> _sendQueue;
 
 private:
 
@@ -239,6 +253,7 @@ private:
     void processReadSegmented();
     bool readToBuffer(std::size_t requiredBytes, bool persistent);
     void endMessage(bool hasMoreSegments);
+    bool processSendQueue(bool wait);
     void processSender(
         epics::pvAccess::TransportSender::shared_pointer const & sender);
 
@@ -266,6 +281,7 @@ public:
 class BlockingTCPTransportCodec:
     public AbstractCodec,
     public AuthenticationPluginControl,
+    public TransportReactor::Handler,
     public std::tr1::enable_shared_from_this<BlockingTCPTransportCodec>
 {
 
@@ -274,6 +290,8 @@ public:
     POINTER_DEFINITIONS(BlockingTCPTransportCodec);
 
     static size_t num_instances;
+    //! local (unix) socket connections ever made, to generate registry keys
+    static int num_local;
 
     BlockingTCPTransportCodec(
             bool serverFlag,
@@ -287,7 +305,7 @@ public:
 
     virtual void readPollOne() OVERRIDE FINAL;
     virtual void writePollOne() OVERRIDE FINAL;
-    virtual void scheduleSend() OVERRIDE FINAL {}
+    virtual void scheduleSend() OVERRIDE FINAL;
     virtual void sendCompleted() OVERRIDE FINAL {}
     virtual void close() OVERRIDE FINAL;
     virtual void waitJoin() OVERRIDE FINAL;
@@ -297,6 +315,7 @@ public:
 
     virtual int read(epics::pvData::ByteBuffer* dst) OVERRIDE FINAL;
     virtual int write(epics::pvData::ByteBuffer* src) OVERRIDE FINAL;
+    virtual int writeGather(epics::pvData::ByteBuffer* first, epics::pvData::ByteBuffer* second) OVERRIDE FINAL;
     virtual const osiSockAddr* getLastReadBufferSocketAddress() OVERRIDE FINAL  {
         return &_socketAddress;
     }
@@ -306,13 +325,7 @@ public:
         return std::string("tcp");
     }
 
-    virtual void processControlMessage() OVERRIDE FINAL {
-        if (_command == CMD_SET_ENDIANESS)
-        {
-            // check 7-th bit
-            setByteOrder(_flags < 0 ? EPICS_ENDIAN_BIG : EPICS_ENDIAN_LITTLE);
-        }
-    }
+    virtual void processControlMessage() OVERRIDE FINAL;
 
 
     virtual void processApplicationMessage() OVERRIDE FINAL {
@@ -390,10 +403,32 @@ public:
 
     virtual void sendSecurityPluginMessage(epics::pvData::PVStructure::const_shared_pointer const & data) OVERRIDE FINAL;
 
+    // TransportReactor::Handler, when using the shared I/O threads
+    virtual void readReady() OVERRIDE FINAL;
+    virtual void writeReady() OVERRIDE FINAL;
+    virtual void periodic() OVERRIDE FINAL;
+
 private:
     void receiveThread();
     void sendThread();
 
+    //! With _reactor.  Move received bytes to _rxStage.  @returns false on connection loss
+    bool rxFill();
+    //! With _reactor.  Send from _txPending.  @returns false on connection loss
+    bool txDrain();
+    //! With _reactor.  Take the unsent remainder of first and second into _txPending.
+    int txDefer(epics::pvData::ByteBuffer* first, epics::pvData::ByteBuffer* second);
+
+    struct ShmControlSender;
+    void enqueueShmControl(epics::pvData::int8 command, epics::pvData::int32 data);
+    void sendShmControl(epics::pvData::int8 command, epics::pvData::int32 data);
+    int shmWrite(epics::pvData::ByteBuffer* first, epics::pvData::ByteBuffer* second);
+    bool isLocalPeer() const;
+
+protected:
+    //! Client side.  Offer to move this connection to shared memory, if the server is on this host.
+    void shmOffer();
+
 protected:
     virtual void setRxTimeout(bool ena) OVERRIDE FINAL;
 
@@ -407,11 +442,45 @@ protected:
 
 private:
     AtomicValue<bool> _isOpen;
-    epics::pvData::Thread _readThread, _sendThread;
+    // NULL when using _reactor
+    epics::auto_ptr<epics::pvData::Thread> _readThread, _sendThread;
+    const TransportReactor::shared_pointer _reactor;
+    // inactivity timeout in seconds, or 0
+    double _rxTimeout;
+
+    /* With _reactor, an I/O thread must never wait for the socket.
+     * Received bytes are staged until a whole message (all segments) has arrived,
+     * so processRead() never needs more than read() returns.
+     * Bytes which the socket does not accept are kept until writeReady().
+     * Only accessed from the I/O thread servicing this transport.
+     */
+    std::vector<char> _rxStage;
+    size_t _rxPos;      // next byte of _rxStage for read()
+    size_t _rxComplete; // end of whole messages in _rxStage
+    size_t _rxScan;     // next message header in _rxStage
+    bool _rxSegmented;  // _rxScan is in the middle of a segmented message
+    const size_t _rxMax; // limit on staged bytes of an incomplete message
+    epicsTimeStamp _lastRx; // for _rxTimeout
+    std::vector<char> _txPending;
+    size_t _txPos;      // next byte of _txPending to send
     const SOCKET _channel;
+
+    /* Same host shared memory.  Once switched, message bytes move through _shm
+     * and the socket only carries one byte "doorbells" to wake the reader.
+     * _shm is set by the receive thread before the control message which
+     * switches the send thread is queued.
+     */
+    const size_t _shmSize; // client: ring capacity to offer, 0 to disable
+    const bool _shmAllowed; // server: accept offers
+    ShmRing::shared_pointer _shm;
+    bool _shmTx; // send thread only
+    bool _shmRx; // receive thread only
+    bool _shmOffered; // server: an offer was received.  receive thread only
 protected:
     osiSockAddr _socketAddress;
     std::string _socketName;
+    // connected through a local (unix) socket.  _socketAddress is only a registry key
+    bool _localSocket;
 protected:
     Context::shared_pointer _context;
 
@@ -479,7 +548,7 @@ public:
 
     pvAccessID preallocateChannelSID();
 
-    void depreallocateChannelSID(pvAccessID /*sid*/) {}
+    void depreallocateChannelSID(pvAccessID sid);
 
     void registerChannel(
             pvAccessID sid,
@@ -489,8 +558,10 @@ public:
 
     std::tr1::shared_ptr<ServerChannel> getChannel(pvAccessID sid);
 
+    //! Append registered channels.  Excludes SIDs only preallocated.
     void getChannels(std::vector<std::tr1::shared_ptr<ServerChannel> >& channels) const;
 
+    //! Number of registered channels.  Excludes SIDs only preallocated.
     size_t getChannelCount() const;
 
     virtual bool verify(epics::pvData::int32 timeoutMs) OVERRIDE FINAL {
@@ -532,18 +603,14 @@ protected:
 
 private:
 
-    /**
-    * Last SID cache.
-    */
-    pvAccessID _lastChannelSID;
-
-    typedef std::map<pvAccessID, std::tr1::shared_ptr<ServerChannel> > _channels_t;
+    typedef slot_table<std::tr1::shared_ptr<ServerChannel> > _channels_t;
     /**
     * Channel table (SID -> channel mapping).
+    * getChannel() is called for each request message, and only takes a slot stripe lock.
     */
     _channels_t _channels;
-
-    mutable epics::pvData::Mutex _channelsMutex;
+    // channels registered in _channels, excluding preallocated SIDs.  atomic
+    int _channelCount;
 
     epics::pvData::Status _verificationStatus;
 
@@ -571,7 +638,8 @@ protected:
         std::tr1::shared_ptr<ClientChannelImpl> const & client,
         epics::pvData::int8 remoteTransportRevision,
         float heartbeatInterval,
-        int16_t priority);
+        int16_t priority,
+        const osiSockAddr* serverAddress);
 
 public:
     static shared_pointer create(
@@ -583,14 +651,15 @@ public:
         std::tr1::shared_ptr<ClientChannelImpl> const & client,
         int8_t remoteTransportRevision,
         float heartbeatInterval,
-        int16_t priority )
+        int16_t priority,
+        const osiSockAddr* serverAddress = 0) //!< Registry key when 'channel' is a local (unix) socket
     {
         shared_pointer thisPointer(
             new BlockingClientTCPTransportCodec(
                 context, channel, responseHandler,
                 sendBufferSize, receiveBufferSize,
                 client, remoteTransportRevision,
-                heartbeatInterval, priority)
+                heartbeatInterval, priority, serverAddress)
         );
         thisPointer->activate();
         return thisPointer;
@@ -634,6 +703,12 @@ private:
     typedef std::map<pvAccessID, std::tr1::weak_ptr<ClientChannelImpl> > TransportClientMap_t;
     TransportClientMap_t _owners;
 
+    /**
+     * Acquired without a client (eg. for name server search),
+     * so not closed when the last client is released.
+     */
+    bool _pinned;
+
     /**
      * Connection timeout (no-traffic) flag.
      */
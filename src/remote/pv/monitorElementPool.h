@@ -0,0 +1,113 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef MONITORELEMENTPOOL_H
+#define MONITORELEMENTPOOL_H
+
+#ifdef epicsExportSharedSymbols
+#   define monitorElementPoolEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <map>
+#include <vector>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include <pv/sharedPtr.h>
+#include <pv/pvData.h>
+
+#ifdef monitorElementPoolEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#       undef monitorElementPoolEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+
+/** Unused monitor queue storage, shared by the monitors of one client context.
+ *
+ * A client monitor queue keeps one PVStructure for each slot.
+ * When a monitor is destroyed, or re-connects with a different type,
+ * its structures are put() here instead of being freed, and re-used by
+ * the next monitor of the same type, instead of being created.
+ *
+ * Structures are pooled by the identity of their type.  Types received through
+ * different connections are different instances, so monitors should first
+ * find the canonical() instance of an equal type.
+ * Types are remembered while some monitor, or pooled structure, still uses them.
+ */
+class epicsShareClass MonitorElementPool
+{
+public:
+    POINTER_DEFINITIONS(MonitorElementPool);
+
+    struct Stats {
+        size_t ntypes;   //!< distinct types in use
+        size_t npooled;  //!< structures currently unused
+        size_t nreused;  //!< get() which found an unused structure
+        size_t ncreated; //!< get() which created a new structure
+        Stats() :ntypes(0u), npooled(0u), nreused(0u), ncreated(0u) {}
+    };
+
+    /** @param maxPerType unused structures kept for each type.  0 disables pooling.
+     *  @param maxTotal unused structures kept for all types.
+     */
+    MonitorElementPool(size_t maxPerType, size_t maxTotal);
+    ~MonitorElementPool();
+
+    /** Find a previously seen type which is equal (Field::operator==) to 'type'.
+     * @returns the previously seen instance, or 'type' which is then remembered.
+     */
+    epics::pvData::StructureConstPtr canonical(const epics::pvData::StructureConstPtr& type);
+
+    //! An unused structure of this type, or a new one.  Either way, with default values.
+    epics::pvData::PVStructurePtr get(const epics::pvData::StructureConstPtr& type);
+
+    /** Give back a structure.  Ignored if referenced elsewhere (!unique()),
+     *  if its type was not canonical(), or if the pool of its type is full.
+     *  Pooled structures are reset to default values, which releases array storage.
+     */
+    void put(const epics::pvData::PVStructurePtr& pvStructure);
+
+    void stats(Stats& ret) const;
+
+private:
+    typedef epicsGuard<epicsMutex> Guard;
+
+    // forget types no longer used.  call with _mutex locked
+    void prune();
+
+    struct Entry {
+        // not kept alive by the pool, except through unused and empty
+        std::tr1::weak_ptr<const epics::pvData::Structure> type;
+        size_t hash;
+        std::vector<epics::pvData::PVStructurePtr> unused;
+        // default values, copied into structures before they are pooled
+        epics::pvData::PVStructurePtr empty;
+    };
+    typedef std::map<const epics::pvData::Structure*, Entry> entries_t;
+    // structural hash -> type
+    typedef std::multimap<size_t, const epics::pvData::Structure*> types_t;
+
+    const size_t _maxPerType, _maxTotal;
+
+    mutable epicsMutex _mutex;
+    entries_t _entries;
+    types_t _types;
+    Stats _stats;
+
+    MonitorElementPool(const MonitorElementPool&);
+    MonitorElementPool& operator=(const MonitorElementPool&);
+};
+
+}
+}
+
+#endif // MONITORELEMENTPOOL_H
@@ -111,7 +111,12 @@ enum ApplicationCommands {
 enum ControlCommands {
     CMD_SET_MARKER = 0,
     CMD_ACK_MARKER = 1,
-    CMD_SET_ENDIANESS = 2
+    CMD_SET_ENDIANESS = 2,
+    // switch a same host connection to shared memory.  cf. ShmRing
+    CMD_SHM_OFFER = 0x10,  // client to server, data is segment token
+    CMD_SHM_ACCEPT = 0x11, // server to client, server now writes to shared memory
+    CMD_SHM_REJECT = 0x12, // server to client
+    CMD_SHM_SWITCH = 0x13  // client to server, client now writes to shared memory
 };
 
 void hackAroundRTEMSSocketInterrupt();
@@ -136,7 +141,7 @@ public:
 /**
  * Interface defining transport sender (instance sending data over transport).
  */
-class TransportSender : public Lockable, public fair_queue<TransportSender>::entry {
+class TransportSender : public Lockable, public fair_queue_mpsc<TransportSender>::entry {
 public:
     POINTER_DEFINITIONS(TransportSender);
 
@@ -278,6 +283,7 @@ public:
 class Channel;
 class SecurityPlugin;
 class AuthenticationRegistry;
+class TransportReactor;
 
 /**
  * Not public IF, used by Transports, etc.
@@ -297,12 +303,22 @@ public:
 
     virtual Configuration::const_shared_pointer getConfiguration() = 0;
 
+    /** I/O thread pool shared by the TCP transports of this context.
+     * NULL (the default) when each transport runs its own receive and send threads.
+     */
+    virtual std::tr1::shared_ptr<TransportReactor> getTransportReactor() {
+        return std::tr1::shared_ptr<TransportReactor>();
+    }
+
     ///
     /// due to ClientContextImpl
     ///
 
     virtual void newServerDetected() = 0;
 
+    //! A beacon shows that the server with GUID 'previous' has been replaced, eg. restarted.
+    virtual void serverRestarted(ServerGUID const & /*previous*/) {}
+
     virtual std::tr1::shared_ptr<Channel> getChannel(pvAccessID id) = 0;
     virtual Transport::shared_pointer getSearchTransport() = 0;
 };
@@ -0,0 +1,113 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#ifdef epicsExportSharedSymbols
+#   define shmRingEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <string>
+
+#include <epicsTypes.h>
+
+#include <pv/sharedPtr.h>
+
+#ifdef shmRingEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#       undef shmRingEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+
+/** A pair of single producer, single consumer byte rings in a shared memory segment.
+ *
+ * Used by a client and server on the same host to move message bytes
+ * without copying them through the kernel socket buffers.
+ * One ring for each direction.  Each ring has exactly one writing and
+ * one reading thread, so the read and write positions are updated
+ * without locking.
+ *
+ * The segment is created by the client, and named by a random 32-bit token
+ * which is passed to the server.  The server open()s it by this token.
+ * The creator should unlink() the name once the peer has opened it.
+ * The mapping remains valid until both sides are destroyed.
+ *
+ * Only available where POSIX shared memory is (see supported()).
+ * Elsewhere create() and open() always return NULL.
+ */
+class epicsShareClass ShmRing
+{
+public:
+    POINTER_DEFINITIONS(ShmRing);
+
+    enum Direction {
+        ClientToServer = 0,
+        ServerToClient = 1
+    };
+
+    //! Is shared memory available on this target?
+    static bool supported();
+
+    /** Create a new, uniquely named, segment.
+     * @param capacity bytes in each direction.  Rounded up to a power of two.
+     * @returns NULL on failure.
+     */
+    static shared_pointer create(size_t capacity);
+
+    /** Map a segment previously create()d by another process.
+     * @param error If not NULL, set on failure to an errno value.
+     *        EACCES if it exists but belongs to another user, EINVAL if it is not valid.
+     * @returns NULL if it does not exist, or is not accessible.
+     */
+    static shared_pointer open(epicsUInt32 token, int *error = 0);
+
+    ~ShmRing();
+
+    epicsUInt32 token() const { return _token; }
+    const std::string& name() const { return _name; }
+    //! bytes in each direction
+    size_t capacity() const { return _capacity; }
+
+    //! Remove the segment name.  Existing mappings are not affected.
+    void unlink();
+
+    //! Returned by read() and write() when the positions are inconsistent, eg. overwritten by the peer.
+    static const size_t corrupt = size_t(-1);
+
+    //! Copy in as much of buf[0:len] as will fit.  @returns number of bytes copied, or corrupt.
+    size_t write(Direction dir, const char *buf, size_t len);
+    //! Copy out up to len bytes.  @returns number of bytes copied, 0 if the ring is empty, or corrupt.
+    size_t read(Direction dir, char *buf, size_t len);
+    //! Bytes which could currently be read.
+    size_t readable(Direction dir) const;
+
+    struct Layout;
+private:
+    ShmRing(epicsUInt32 token, const std::string& name, void *base, size_t size, bool owner);
+
+    const epicsUInt32 _token;
+    const std::string _name;
+    void * const _base;
+    const size_t _size;
+    size_t _capacity;
+    Layout *_layout;
+    char *_data[2];
+    bool _linked;
+
+    ShmRing(const ShmRing&);
+    ShmRing& operator=(const ShmRing&);
+};
+
+}
+}
+
+#endif // SHMRING_H
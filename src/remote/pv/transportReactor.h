@@ -0,0 +1,126 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef TRANSPORTREACTOR_H_
+#define TRANSPORTREACTOR_H_
+
+#include <map>
+#include <vector>
+#include <string>
+
+#ifdef epicsExportSharedSymbols
+#   define transportReactorEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <osiSock.h>
+#include <epicsTime.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include <pv/sharedPtr.h>
+#include <pv/thread.h>
+
+#ifdef transportReactorEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#       undef transportReactorEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+
+/** @brief A small, fixed pool of I/O threads multiplexing many TCP sockets.
+ *
+ * Used in place of the receive/send thread pair which each
+ * BlockingTCPTransportCodec otherwise starts.
+ * Each registered socket is armed "one shot", so at most one I/O thread
+ * is calling a given Handler at any time, including Handler::periodic().
+ * The socket is re-armed after the Handler callback returns.
+ *
+ * Enabled by setting $EPICS_PVA_IO_THREADS (client) or $EPICS_PVAS_IO_THREADS (server)
+ * to a positive number.  Only available where isSupported() is true (currently Linux/epoll),
+ * elsewhere the thread pair per connection is used.
+ */
+class epicsShareClass TransportReactor
+{
+public:
+    POINTER_DEFINITIONS(TransportReactor);
+
+    //! Readiness callbacks, invoked from an I/O thread.
+    class Handler {
+    public:
+        POINTER_DEFINITIONS(Handler);
+        virtual ~Handler() {}
+        //! Socket is readable, or has an error or hangup pending.
+        virtual void readReady() = 0;
+        //! Socket is writable following a call to requestWrite()
+        virtual void writeReady() = 0;
+        //! Called about once a second, eg. to check for inactivity
+        virtual void periodic() {}
+    };
+
+    static size_t num_instances;
+
+    //! true if this target has an implementation
+    static bool isSupported();
+
+    TransportReactor(unsigned nthreads, const std::string& name);
+    ~TransportReactor();
+
+    /** Start watching a socket.
+     * The socket should already be in non-blocking mode.
+     * A reference to the handler is kept until remove() or close()
+     */
+    void add(SOCKET sock, const Handler::shared_pointer& handler);
+    /** Stop watching a socket.  Must be called before the socket is closed.
+     * An in-progress Handler callback is allowed to complete.
+     */
+    void remove(SOCKET sock);
+    //! Request a (single) call to Handler::writeReady()
+    void requestWrite(SOCKET sock);
+
+    /** Stop and join I/O threads, and release all Handlers.
+     * Must not be called from an I/O thread.
+     */
+    void close();
+
+    //! Number of registered sockets
+    size_t size() const;
+    size_t numThreads() const { return _workers.size(); }
+
+private:
+    struct Entry;
+    typedef std::tr1::shared_ptr<Entry> entry_ptr;
+    typedef std::map<SOCKET, entry_ptr> entries_t;
+
+    void run();
+    void dispatch(const entry_ptr& ent, unsigned events);
+    void rearm(Entry& ent);
+    void tick();
+
+    typedef epicsGuard<epicsMutex> Guard;
+    mutable epicsMutex _mutex;
+
+    int _epfd;
+    int _wakefd;
+    bool _closed;
+    // last call of Handler::periodic()
+    epicsTimeStamp _lastTick;
+
+    entries_t _entries;
+
+    std::vector<std::tr1::shared_ptr<epics::pvData::Thread> > _workers;
+
+    TransportReactor(const TransportReactor&);
+    TransportReactor& operator=(const TransportReactor&);
+};
+
+}
+}
+
+#endif /* TRANSPORTREACTOR_H_ */
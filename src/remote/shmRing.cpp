@@ -0,0 +1,285 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <algorithm>
+
+#if !defined(_WIN32)
+#  include <unistd.h>
+#endif
+
+#if (defined(_POSIX_SHARED_MEMORY_OBJECTS) && _POSIX_SHARED_MEMORY_OBJECTS>0) || defined(__APPLE__)
+#  if !defined(__rtems__) && !defined(vxWorks)
+#    define HAVE_SHM
+#  endif
+#endif
+
+#ifdef HAVE_SHM
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+#include <epicsStdio.h>
+#include <epicsAtomic.h>
+
+#define epicsExportSharedSymbols
+#include <pv/shmRing.h>
+#include <pv/logger.h>
+
+namespace epics {
+namespace pvAccess {
+
+// Shared between processes, so only fixed size types.
+// Positions are free running byte counters, modulo 2**32.
+struct ShmRing::Layout {
+    epicsUInt32 magic;
+    epicsUInt32 capacity;
+    char pad0[56];
+    struct Index {
+        int head; // only changed by the writer
+        char pad1[60];
+        int tail; // only changed by the reader
+        char pad2[60];
+    } index[2];
+};
+
+namespace {
+const epicsUInt32 shmMagic = 0x50564132; // "PVA2"
+const size_t minCapacity = 4096u;
+const size_t maxCapacity = size_t(1u)<<30;
+
+// random, so that the name of another client's segment can't be guessed
+epicsUInt32 shmToken()
+{
+    epicsUInt32 token = 0u;
+    FILE *fp = fopen("/dev/urandom", "rb");
+    if(fp) {
+        size_t n = fread(&token, sizeof(token), 1u, fp);
+        fclose(fp);
+        if(n==1u)
+            return token;
+    }
+    return 0u; // not available
+}
+
+std::string shmName(epicsUInt32 token)
+{
+    char buf[24];
+    epicsSnprintf(buf, sizeof(buf), "/pvAccess-%08x", unsigned(token));
+    buf[sizeof(buf)-1] = '\0';
+    return buf;
+}
+
+}
+
+bool ShmRing::supported()
+{
+#ifdef HAVE_SHM
+    return true;
+#else
+    return false;
+#endif
+}
+
+ShmRing::shared_pointer ShmRing::create(size_t request)
+{
+#ifdef HAVE_SHM
+    size_t capacity = minCapacity;
+    while(capacity < request && capacity < maxCapacity)
+        capacity <<= 1u;
+    const size_t size = sizeof(Layout) + 2u*capacity;
+
+    for(unsigned attempt=0u; attempt<16u; attempt++) {
+        const epicsUInt32 token = shmToken();
+        if(!token) {
+            LOG(logLevelDebug, "No random source for shared memory name");
+            return shared_pointer();
+        }
+        const std::string name(shmName(token));
+
+        // only the same user may open
+        int fd = shm_open(name.c_str(), O_RDWR|O_CREAT|O_EXCL, 0600);
+        if(fd<0 && errno==EEXIST) {
+            continue;
+        } else if(fd<0) {
+            LOG(logLevelDebug, "Unable to create shared memory %s : %d", name.c_str(), errno);
+            return shared_pointer();
+        }
+
+        void *base = MAP_FAILED;
+        if(ftruncate(fd, size)==0)
+            base = mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(base==MAP_FAILED) {
+            LOG(logLevelDebug, "Unable to map shared memory %s : %d", name.c_str(), errno);
+            shm_unlink(name.c_str());
+            return shared_pointer();
+        }
+
+        Layout *layout = static_cast<Layout*>(base);
+        memset(layout, 0, sizeof(*layout));
+        layout->capacity = epicsUInt32(capacity);
+        // magic last, so open() never sees a partially initialized header
+        epicsAtomicWriteMemoryBarrier();
+        layout->magic = shmMagic;
+
+        return shared_pointer(new ShmRing(token, name, base, size, true));
+    }
+    LOG(logLevelDebug, "Unable to find an unused shared memory name");
+#else
+    (void)request;
+#endif
+    return shared_pointer();
+}
+
+ShmRing::shared_pointer ShmRing::open(epicsUInt32 token, int *error)
+{
+    int dummy;
+    if(!error)
+        error = &dummy;
+    *error = 0;
+#ifdef HAVE_SHM
+    const std::string name(shmName(token));
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if(fd<0) {
+        *error = errno;
+        LOG(logLevelDebug, "Unable to open shared memory %s : %d", name.c_str(), errno);
+        return shared_pointer();
+    }
+
+    struct stat info;
+    void *base = MAP_FAILED;
+    size_t size = 0u;
+    if(fstat(fd, &info)==0 && size_t(info.st_size)>=sizeof(Layout)) {
+        size = info.st_size;
+        base = mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if(base==MAP_FAILED) {
+        *error = EINVAL;
+        LOG(logLevelDebug, "Unable to map shared memory %s : %d", name.c_str(), errno);
+        return shared_pointer();
+    }
+
+    const Layout *layout = static_cast<const Layout*>(base);
+    const size_t capacity = layout->capacity;
+    epicsAtomicReadMemoryBarrier();
+    if(layout->magic!=shmMagic || capacity<minCapacity || capacity>maxCapacity
+            || (capacity&(capacity-1u)) || size!=sizeof(Layout)+2u*capacity) {
+        *error = EINVAL;
+        LOG(logLevelDebug, "Invalid shared memory segment %s", name.c_str());
+        munmap(base, size);
+        return shared_pointer();
+    }
+
+    return shared_pointer(new ShmRing(token, name, base, size, false));
+#else
+    (void)token;
+    *error = ENOSYS;
+    return shared_pointer();
+#endif
+}
+
+ShmRing::ShmRing(epicsUInt32 token, const std::string& name, void *base, size_t size, bool owner)
+    :_token(token)
+    ,_name(name)
+    ,_base(base)
+    ,_size(size)
+    ,_layout(static_cast<Layout*>(base))
+    ,_linked(owner)
+{
+    _capacity = _layout->capacity;
+    _data[0] = static_cast<char*>(base) + sizeof(Layout);
+    _data[1] = _data[0] + _capacity;
+}
+
+ShmRing::~ShmRing()
+{
+    unlink();
+#ifdef HAVE_SHM
+    munmap(_base, _size);
+#endif
+}
+
+void ShmRing::unlink()
+{
+#ifdef HAVE_SHM
+    if(_linked)
+        shm_unlink(_name.c_str());
+#endif
+    _linked = false;
+}
+
+const size_t ShmRing::corrupt;
+
+size_t ShmRing::write(Direction dir, const char *buf, size_t len)
+{
+    Layout::Index& idx = _layout->index[dir];
+    const epicsUInt32 head = epics::atomic::get(idx.head),
+                      tail = epics::atomic::get(idx.tail);
+    epicsAtomicReadMemoryBarrier();
+
+    // positions are in memory which the peer can write
+    const size_t used = head - tail;
+    if(used > _capacity)
+        return corrupt;
+
+    const size_t n = std::min(std::min(len, _capacity), _capacity - used);
+    if(n==0u)
+        return 0u;
+
+    const size_t start = head & (_capacity-1u),
+                 first = std::min(n, _capacity - start);
+    memcpy(_data[dir]+start, buf, first);
+    memcpy(_data[dir], buf+first, n-first);
+
+    // data before position
+    epicsAtomicWriteMemoryBarrier();
+    epics::atomic::set(idx.head, int(head + epicsUInt32(n)));
+    return n;
+}
+
+size_t ShmRing::read(Direction dir, char *buf, size_t len)
+{
+    Layout::Index& idx = _layout->index[dir];
+    const epicsUInt32 head = epics::atomic::get(idx.head),
+                      tail = epics::atomic::get(idx.tail);
+    // position before data
+    epicsAtomicReadMemoryBarrier();
+
+    const size_t used = head - tail;
+    if(used > _capacity)
+        return corrupt;
+
+    const size_t n = std::min(len, used);
+    if(n==0u)
+        return 0u;
+
+    const size_t start = tail & (_capacity-1u),
+                 first = std::min(n, _capacity - start);
+    memcpy(buf, _data[dir]+start, first);
+    memcpy(buf+first, _data[dir], n-first);
+
+    // finish copying out before the writer may overwrite
+    epicsAtomicReadMemoryBarrier();
+    epicsAtomicWriteMemoryBarrier();
+    epics::atomic::set(idx.tail, int(tail + epicsUInt32(n)));
+    return n;
+}
+
+size_t ShmRing::readable(Direction dir) const
+{
+    const Layout::Index& idx = _layout->index[dir];
+    const size_t used = epicsUInt32(epics::atomic::get(idx.head)) - epicsUInt32(epics::atomic::get(idx.tail));
+    return std::min(used, _capacity);
+}
+
+}
+}
@@ -0,0 +1,327 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdexcept>
+#include <sstream>
+
+#if defined(__linux__)
+#  include <errno.h>
+#  include <unistd.h>
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#  define HAVE_EPOLL
+#endif
+
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <dbDefs.h>
+
+#include <pv/reftrack.h>
+
+#define epicsExportSharedSymbols
+#include <pv/transportReactor.h>
+#include <pv/logger.h>
+
+namespace epics {
+namespace pvAccess {
+
+struct TransportReactor::Entry {
+    SOCKET sock;
+    Handler::shared_pointer handler;
+    // a Handler callback is in progress
+    bool busy;
+    // wait for writable as well as readable
+    bool wantWrite;
+    // remove() called
+    bool removed;
+    Entry(SOCKET sock, const Handler::shared_pointer& handler)
+        :sock(sock), handler(handler), busy(false), wantWrite(false), removed(false)
+    {}
+};
+
+size_t TransportReactor::num_instances;
+
+#ifdef HAVE_EPOLL
+
+bool TransportReactor::isSupported() { return true; }
+
+TransportReactor::TransportReactor(unsigned nthreads, const std::string& name)
+    :_epfd(-1)
+    ,_wakefd(-1)
+    ,_closed(false)
+{
+    if(nthreads==0)
+        nthreads = 1;
+
+    epicsTimeGetCurrent(&_lastTick);
+
+    _epfd = epoll_create(64);
+    if(_epfd<0)
+        throw std::runtime_error("TransportReactor unable to create epoll instance");
+
+    _wakefd = eventfd(0, 0);
+    if(_wakefd<0) {
+        ::close(_epfd);
+        throw std::runtime_error("TransportReactor unable to create eventfd");
+    }
+
+    {
+        epoll_event ev = epoll_event();
+        ev.events = EPOLLIN; // level triggered, so every worker sees it.
+        ev.data.fd = _wakefd;
+        if(epoll_ctl(_epfd, EPOLL_CTL_ADD, _wakefd, &ev)) {
+            ::close(_wakefd);
+            ::close(_epfd);
+            throw std::runtime_error("TransportReactor unable to watch eventfd");
+        }
+    }
+
+    _workers.reserve(nthreads);
+    for(unsigned i=0; i<nthreads; i++) {
+        std::ostringstream tname;
+        tname<<name<<"-"<<i;
+        std::tr1::shared_ptr<epics::pvData::Thread> worker(new epics::pvData::Thread(
+                    epics::pvData::Thread::Config(this, &TransportReactor::run)
+                        .prio(epicsThreadPriorityCAServerLow)
+                        .name(tname.str())
+                        .stack(epicsThreadStackBig)
+                        .autostart(false)));
+        _workers.push_back(worker);
+    }
+    for(size_t i=0; i<_workers.size(); i++)
+        _workers[i]->start();
+
+    REFTRACE_INCREMENT(num_instances);
+}
+
+TransportReactor::~TransportReactor()
+{
+    close();
+    ::close(_wakefd);
+    ::close(_epfd);
+    REFTRACE_DECREMENT(num_instances);
+}
+
+void TransportReactor::add(SOCKET sock, const Handler::shared_pointer& handler)
+{
+    entry_ptr ent(new Entry(sock, handler));
+
+    Guard G(_mutex);
+    if(_closed)
+        throw std::logic_error("TransportReactor closed");
+    if(_entries.find(sock)!=_entries.end())
+        throw std::logic_error("TransportReactor socket already registered");
+
+    epoll_event ev = epoll_event();
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.fd = sock;
+    if(epoll_ctl(_epfd, EPOLL_CTL_ADD, sock, &ev)) {
+        std::ostringstream msg;
+        msg<<"TransportReactor unable to watch socket: "<<errno;
+        throw std::runtime_error(msg.str());
+    }
+
+    _entries[sock] = ent;
+}
+
+void TransportReactor::remove(SOCKET sock)
+{
+    // release handler after unlock
+    entry_ptr victim;
+    {
+        Guard G(_mutex);
+        entries_t::iterator it(_entries.find(sock));
+        if(it==_entries.end())
+            return;
+
+        victim = it->second;
+        victim->removed = true;
+        _entries.erase(it);
+
+        epoll_event ev = epoll_event(); // ignored, but must be non-NULL for linux < 2.6.9
+        (void)epoll_ctl(_epfd, EPOLL_CTL_DEL, sock, &ev);
+    }
+}
+
+void TransportReactor::requestWrite(SOCKET sock)
+{
+    Guard G(_mutex);
+    entries_t::iterator it(_entries.find(sock));
+    if(it==_entries.end())
+        return;
+
+    Entry& ent = *it->second;
+    if(ent.wantWrite)
+        return;
+    ent.wantWrite = true;
+    // when busy, re-armed by dispatch()
+    if(!ent.busy)
+        rearm(ent);
+}
+
+// call with _mutex locked
+void TransportReactor::rearm(Entry& ent)
+{
+    epoll_event ev = epoll_event();
+    ev.events = EPOLLIN | EPOLLONESHOT | (ent.wantWrite ? unsigned(EPOLLOUT) : 0u);
+    ev.data.fd = ent.sock;
+    if(epoll_ctl(_epfd, EPOLL_CTL_MOD, ent.sock, &ev)) {
+        LOG(logLevelError, "TransportReactor unable to re-arm socket: %d", errno);
+    }
+}
+
+void TransportReactor::close()
+{
+    entries_t victims;
+    {
+        Guard G(_mutex);
+        if(_closed)
+            return;
+        _closed = true;
+    }
+
+    uint64_t one = 1;
+    if(::write(_wakefd, &one, sizeof(one))!=sizeof(one))
+        LOG(logLevelError, "TransportReactor unable to wakeup workers: %d", errno);
+
+    for(size_t i=0; i<_workers.size(); i++)
+        _workers[i]->exitWait();
+
+    {
+        Guard G(_mutex);
+        victims.swap(_entries);
+        for(entries_t::iterator it(victims.begin()), end(victims.end()); it!=end; ++it) {
+            it->second->removed = true;
+            epoll_event ev = epoll_event();
+            (void)epoll_ctl(_epfd, EPOLL_CTL_DEL, it->first, &ev);
+        }
+    }
+}
+
+void TransportReactor::run()
+{
+    epoll_event events[16];
+
+    while(true) {
+        // wake at least once a second for tick()
+        int nevt = epoll_wait(_epfd, events, NELEMENTS(events), 1000);
+        if(nevt<0) {
+            if(errno==EINTR)
+                continue;
+            LOG(logLevelError, "TransportReactor epoll_wait() error: %d", errno);
+            break;
+        }
+
+        for(int i=0; i<nevt; i++) {
+            if(events[i].data.fd==_wakefd)
+                return; // closing
+
+            entry_ptr ent;
+            {
+                Guard G(_mutex);
+                entries_t::iterator it(_entries.find(events[i].data.fd));
+                // a stale event, or being handled by another worker which will re-arm.
+                if(it==_entries.end() || it->second->busy)
+                    continue;
+                ent = it->second;
+                ent->busy = true;
+                if(events[i].events & EPOLLOUT)
+                    ent->wantWrite = false;
+            }
+
+            dispatch(ent, events[i].events);
+        }
+
+        tick();
+    }
+}
+
+void TransportReactor::tick()
+{
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+
+    std::vector<entry_ptr> idle;
+    {
+        Guard G(_mutex);
+        // one worker each second
+        if(epicsTimeDiffInSeconds(&now, &_lastTick) < 1.0)
+            return;
+        _lastTick = now;
+
+        idle.reserve(_entries.size());
+        for(entries_t::iterator it(_entries.begin()), end(_entries.end()); it!=end; ++it) {
+            // skip if busy.  A Handler being called now isn't idle anyway.
+            if(it->second->busy)
+                continue;
+            it->second->busy = true;
+            idle.push_back(it->second);
+        }
+    }
+
+    for(size_t i=0; i<idle.size(); i++)
+        dispatch(idle[i], 0u);
+}
+
+void TransportReactor::dispatch(const entry_ptr& ent, unsigned events)
+{
+    try {
+        if(events & (EPOLLIN|EPOLLERR|EPOLLHUP))
+            ent->handler->readReady();
+        if(events & EPOLLOUT)
+            ent->handler->writeReady();
+        if(!events) // from tick()
+            ent->handler->periodic();
+    } catch(std::exception& e) {
+        LOG(logLevelError, "Unhandled exception caught from TransportReactor handler: %s", e.what());
+    } catch(...) {
+        LOG(logLevelError, "Unhandled exception caught from TransportReactor handler");
+    }
+
+    Guard G(_mutex);
+    ent->busy = false;
+    if(!ent->removed)
+        rearm(*ent);
+}
+
+size_t TransportReactor::size() const
+{
+    Guard G(_mutex);
+    return _entries.size();
+}
+
+#else /* HAVE_EPOLL */
+
+bool TransportReactor::isSupported() { return false; }
+
+TransportReactor::TransportReactor(unsigned nthreads, const std::string& name)
+    :_epfd(-1)
+    ,_wakefd(-1)
+    ,_closed(true)
+{
+    throw std::logic_error("TransportReactor not supported on this target");
+}
+
+TransportReactor::~TransportReactor() {}
+
+void TransportReactor::add(SOCKET sock, const Handler::shared_pointer& handler)
+{
+    throw std::logic_error("TransportReactor not supported on this target");
+}
+
+void TransportReactor::remove(SOCKET sock) {}
+void TransportReactor::requestWrite(SOCKET sock) {}
+void TransportReactor::close() {}
+void TransportReactor::run() {}
+void TransportReactor::dispatch(const entry_ptr& ent, unsigned events) {}
+void TransportReactor::rearm(Entry& ent) {}
+void TransportReactor::tick() {}
+size_t TransportReactor::size() const { return 0u; }
+
+#endif /* HAVE_EPOLL */
+
+}
+}
@@ -8,15 +8,18 @@
 #include <sstream>
 #include <memory>
 #include <queue>
+#include <deque>
 #include <stdexcept>
 
 #include <osiSock.h>
 #include <epicsGuard.h>
+#include <epicsEvent.h>
 #include <epicsAssert.h>
 #include <epicsAtomic.h>
 
 #include <pv/lock.h>
 #include <pv/timer.h>
+#include <pv/thread.h>
 #include <pv/bitSetUtil.h>
 #include <pv/standardPVField.h>
 #include <pv/reftrack.h>
@@ -30,10 +33,14 @@
 #include <pv/hexDump.h>
 #include <pv/remote.h>
 #include <pv/codec.h>
+#include <pv/transportReactor.h>
 #include <pv/channelSearchManager.h>
+#include <pv/channelAddressCache.h>
+#include <pv/monitorElementPool.h>
 #include <pv/serializationHelper.h>
 #include <pv/channelSearchManager.h>
 #include <pv/clientContextImpl.h>
+#include <pv/slotTable.h>
 #include <pv/configuration.h>
 #include <pv/beaconHandler.h>
 #include <pv/logger.h>
@@ -1850,7 +1857,8 @@ public:
 class MonitorStrategy : public Monitor {
 public:
     virtual ~MonitorStrategy() {};
-    virtual void init(StructureConstPtr const & structure) = 0;
+    //! @returns the type which will be delivered, which may be a different instance equal to 'structure'
+    virtual StructureConstPtr init(StructureConstPtr const & structure) = 0;
     virtual void response(Transport::shared_pointer const & transport, ByteBuffer* payloadBuffer) = 0;
     virtual void unlisten() = 0;
 };
@@ -1858,6 +1866,15 @@ public:
 typedef vector<MonitorElement::shared_pointer> FreeElementQueue;
 typedef queue<MonitorElement::shared_pointer> MonitorElementQueue;
 
+/* Elements are created as needed, up to m_queueSize, with structures taken
+ * from the context MonitorElementPool, and returned there when the type changes.
+ *
+ * Each update is numbered (m_seq) and its changed fields kept for
+ * the last historyLength updates.  An element re-used soon enough
+ * only needs the fields changed since it was last filled to be copied
+ * from m_up2datePVStructure.  Otherwise all fields not about to be deserialized are copied.
+ * (as with m_up2datePVStructure itself, clients must not modify elements)
+ */
 
 class MonitorStrategyQueue :
     public MonitorStrategy,
@@ -1868,9 +1885,25 @@ private:
 
     const int32 m_queueSize;
 
+    const MonitorElementPool::shared_pointer m_pool;
+
     StructureConstPtr m_lastStructure;
     FreeElementQueue m_freeQueue;
     MonitorElementQueue m_monitorQueue;
+    // elements of m_lastStructure created
+    int32 m_allocated;
+
+    static const uint32 historyLength = 16u;
+    // number of the latest update
+    uint32 m_seq;
+    // changed fields of the last historyLength updates
+    BitSet m_history[historyLength];
+    // update last deserialized into each of our structures.  0 if unknown.
+    // Consumers must not modify a structure returned by poll(), as re-use only
+    // copies fields changed by the updates it missed.  cf. Monitor::poll()
+    typedef std::map<const PVStructure*, uint32> filled_t;
+    filled_t m_filled;
+    BitSet m_missed;
 
 
     const MonitorRequester::weak_pointer m_callback;
@@ -1901,10 +1934,13 @@ public:
     MonitorStrategyQueue(ClientChannelImpl::shared_pointer channel, pvAccessID ioid,
                          MonitorRequester::weak_pointer const & callback,
                          int32 queueSize,
-                         bool pipeline, int32 ackAny) :
-        m_queueSize(queueSize), m_lastStructure(),
+                         bool pipeline, int32 ackAny,
+                         MonitorElementPool::shared_pointer const & pool) :
+        m_queueSize(queueSize), m_pool(pool), m_lastStructure(),
         m_freeQueue(),
         m_monitorQueue(),
+        m_allocated(0),
+        m_seq(0u),
         m_callback(callback), m_mutex(),
         m_bitSet1(), m_bitSet2(), m_overrunInProgress(false),
         m_releasedCount(0),
@@ -1921,33 +1957,103 @@ public:
         //m_monitorQueue.reserve(m_queueSize);
     }
 
-    virtual ~MonitorStrategyQueue() {}
+    virtual ~MonitorStrategyQueue()
+    {
+        m_up2datePVStructure.reset();
+        reclaim();
+        for (size_t i = 0; i < m_freeQueue.size(); i++)
+            recycle(m_freeQueue[i]);
+    }
+
+    virtual StructureConstPtr init(StructureConstPtr const & structure) OVERRIDE FINAL {
+        // share elements with other monitors of an equal type
+        StructureConstPtr type(m_pool ? m_pool->canonical(structure) : structure);
 
-    virtual void init(StructureConstPtr const & structure) OVERRIDE FINAL {
         Lock guard(m_mutex);
 
         m_releasedCount = 0;
         m_reportQueueStateInProgress = false;
 
         {
-            while (!m_monitorQueue.empty())
-                m_monitorQueue.pop();
-
-            m_freeQueue.clear();
+            reclaim();
 
             m_up2datePVStructure.reset();
+            // anything filled before now is refilled completely
+            m_seq += historyLength;
 
-            for (int32 i = 0; i < m_queueSize; i++)
+            if (type.get() != m_lastStructure.get())
             {
-                PVStructure::shared_pointer pvStructure = getPVDataCreate()->createPVStructure(structure);
-                MonitorElement::shared_pointer monitorElement(new MonitorElement(pvStructure));
-                m_freeQueue.push_back(monitorElement);
+                // elements still held by the client are dropped by release()
+                for (size_t i = 0; i < m_freeQueue.size(); i++)
+                    recycle(m_freeQueue[i]);
+                m_freeQueue.clear();
+                m_filled.clear();
+                m_allocated = 0;
+
+                m_lastStructure = type;
             }
+        }
+        return type;
+    }
 
-            m_lastStructure = structure;
+private:
+    // move queued, never delivered, elements to m_freeQueue.  call with m_mutex locked
+    void reclaim()
+    {
+        while (!m_monitorQueue.empty())
+        {
+            m_freeQueue.push_back(m_monitorQueue.front());
+            m_monitorQueue.pop();
         }
+        if (m_overrunElement)
+        {
+            m_freeQueue.push_back(m_overrunElement);
+            m_overrunElement.reset();
+        }
+        m_overrunInProgress = false;
     }
 
+    // give up an element, returning its structure to m_pool.  call with m_mutex locked
+    void recycle(MonitorElement::shared_pointer& element)
+    {
+        if (!element)
+            return;
+        // the pool may give this structure to another monitor
+        m_filled.erase(element->pvStructurePtr.get());
+
+        // pvStructurePtr is const.  Copy, then release the element, so that
+        // the pool only takes the structure if no other reference remains.
+        PVStructure::shared_pointer pvStructure;
+        if (m_pool && element.unique())
+            pvStructure = element->pvStructurePtr;
+        element.reset();
+        if (pvStructure)
+            m_pool->put(pvStructure);
+    }
+
+    // call with m_mutex locked, and m_allocated < m_queueSize
+    MonitorElement::shared_pointer allocate()
+    {
+        PVStructure::shared_pointer pvStructure(m_pool ? m_pool->get(m_lastStructure)
+                                                       : getPVDataCreate()->createPVStructure(m_lastStructure));
+        m_allocated++;
+        // default values.  Not filled by any update
+        m_filled[pvStructure.get()] = 0u;
+        return MonitorElement::shared_pointer(new MonitorElement(pvStructure));
+    }
+
+    // number, and remember changed fields of, a new update
+    uint32 filled(const PVStructure* pvStructure, const BitSet& changed)
+    {
+        if (++m_seq == 0u)
+            m_seq = historyLength; // wrapped, so anything filled before is too old
+        m_history[m_seq % historyLength] = changed;
+        m_filled[pvStructure] = m_seq;
+        return m_seq;
+    }
+
+public:
+
 
     virtual void response(Transport::shared_pointer const & transport, ByteBuffer* payloadBuffer) OVERRIDE FINAL {
 
@@ -1977,14 +2083,23 @@ public:
                 *(overrunBitSet.get()) |= m_bitSet2;
 
                 // m_up2datePVStructure is already set
+                filled(pvStructure.get(), m_bitSet1);
 
                 return;
             }
 
-            MonitorElementPtr newElement = m_freeQueue.back();
-            m_freeQueue.pop_back();
+            MonitorElementPtr newElement;
+            if (!m_freeQueue.empty())
+            {
+                newElement = m_freeQueue.back();
+                m_freeQueue.pop_back();
+            }
+            else
+            {
+                newElement = allocate();
+            }
 
-            if (m_freeQueue.empty())
+            if (m_freeQueue.empty() && m_allocated >= m_queueSize)
             {
                 m_overrunInProgress = true;
                 m_overrunElement = newElement;
@@ -1999,11 +2114,28 @@ public:
             changedBitSet->deserialize(payloadBuffer, transport.get());
             if (m_up2datePVStructure && m_up2datePVStructure.get() != pvStructure.get()) {
                 assert(pvStructure->getStructure().get()==m_up2datePVStructure->getStructure().get());
-                pvStructure->copyUnchecked(*m_up2datePVStructure, *changedBitSet, true);
+
+                filled_t::const_iterator it(m_filled.find(pvStructure.get()));
+                const uint32 seq = it==m_filled.end() ? 0u : it->second;
+
+                if (seq != 0u && m_seq - seq < historyLength)
+                {
+                    // only fields changed by the updates this element missed
+                    m_missed.clear();
+                    for (uint32 i = seq + 1u; i != m_seq + 1u; i++)
+                        m_missed |= m_history[i % historyLength];
+                    pvStructure->copyUnchecked(*m_up2datePVStructure, m_missed);
+                }
+                else
+                {
+                    pvStructure->copyUnchecked(*m_up2datePVStructure, *changedBitSet, true);
+                }
             }
             pvStructure->deserialize(payloadBuffer, transport.get(), changedBitSet.get());
             overrunBitSet->deserialize(payloadBuffer, transport.get());
 
+            filled(pvStructure.get(), *changedBitSet);
+
             m_up2datePVStructure = pvStructure;
 
             if (!m_overrunInProgress)
@@ -2126,17 +2258,7 @@ public:
 
     Status start() OVERRIDE FINAL {
         Lock guard(m_mutex);
-        while (!m_monitorQueue.empty())
-        {
-            m_freeQueue.push_back(m_monitorQueue.front());
-            m_monitorQueue.pop();
-        }
-        if (m_overrunElement)
-        {
-            m_freeQueue.push_back(m_overrunElement);
-            m_overrunElement.reset();
-        }
-        m_overrunInProgress = false;
+        reclaim();
         return Status::Ok;
     }
 
@@ -2261,7 +2383,8 @@ public:
 
         std::tr1::shared_ptr<MonitorStrategyQueue> tp(
             new MonitorStrategyQueue(m_channel, m_ioid, m_callback, m_queueSize,
-                                     m_pipeline, m_ackAny)
+                                     m_pipeline, m_ackAny,
+                                     m_channel->getContext()->getMonitorElementPool())
         );
         m_monitorStrategy = tp;
 
@@ -2334,7 +2457,7 @@ public:
             );
         if(!structure)
             throw std::runtime_error("initResponse() w/o Structure");
-        m_monitorStrategy->init(structure);
+        structure = m_monitorStrategy->init(structure);
 
         bool restoreStartedState = m_started;
 
@@ -3267,6 +3390,13 @@ private:
          */
         ServerGUID m_guid;
 
+        /**
+         * Address cache entry, when a direct connection is attempted
+         * before the first search.
+         */
+        ChannelAddressCache::Entry m_cached;
+        bool m_cacheTried, m_cachePending;
+
     public:
         static size_t num_instances;
         static size_t num_active;
@@ -3297,7 +3427,9 @@ private:
             m_needSubscriptionUpdate(false),
             m_allowCreation(true),
             m_serverChannelID(0xFFFFFFFF),
-            m_issueCreateMessage(true)
+            m_issueCreateMessage(true),
+            m_cacheTried(false),
+            m_cachePending(false)
         {
             REFTRACE_INCREMENT(num_instances);
         }
@@ -3513,6 +3645,21 @@ public:
                 old_transport.swap(m_transport);
             }
 
+            if (m_cachePending)
+            {
+                // not at the cached address, forget it and search without penalty
+                m_cachePending = false;
+                if (ChannelAddressCache::shared_pointer cache = m_context->getAddressCache())
+                {
+                    if (old_transport)
+                        cache->remove(m_name); // server does not have this channel
+                    else
+                        cache->invalidate(m_cached.guid); // server not reachable
+                }
+                initiateSearch();
+                return;
+            }
+
             // ... and search again, with penalty
             initiateSearch(true);
         }
@@ -3542,6 +3689,13 @@ public:
 
                     m_addressIndex = 0; // reset
 
+                    m_cachePending = false;
+                    if (m_addresses.empty() && m_transport)
+                    {
+                        if (ChannelAddressCache::shared_pointer cache = m_context->getAddressCache())
+                            cache->update(m_name, m_transport->getRemoteAddress(), m_guid);
+                    }
+
                     // user might create monitors in listeners, so this has to be done before this can happen
                     // however, it would not be nice if events would come before connection event is fired
                     // but this cannot happen since transport (TCP) is serving in this thread
@@ -3619,8 +3773,20 @@ public:
 
             m_allowCreation = true;
 
-            if (m_addresses.empty())
+            ChannelAddressCache::shared_pointer cache;
+            if (m_addresses.empty() && !m_cacheTried)
+                cache = m_context->getAddressCache();
+
+            if (cache && cache->lookup(m_name, m_cached))
+            {
+                // first connection attempt, try where this channel was last seen.
+                // connecting may block, so not from the timer thread
+                m_cacheTried = m_cachePending = true;
+                m_context->queueCachedConnect(internal_from_this());
+            }
+            else if (m_addresses.empty())
             {
+                m_cacheTried = true;
                 m_context->getChannelSearchManager()->registerSearchInstance(internal_from_this(), penalize);
             }
             else
@@ -3630,10 +3796,39 @@ public:
             }
         }
 
+        /**
+         * Connect to the address cache entry found by initiateSearch().
+         * Called from the address cache thread.
+         */
+        void connectCached()
+        {
+            osiSockAddr address;
+            ServerGUID guid;
+            {
+                Lock guard(m_channelMutex);
+                if (!m_cachePending || m_connectionState == DESTROYED)
+                    return;
+                address = m_cached.address;
+                guid = m_cached.guid;
+            }
+
+            // entry is removed if another channel found this server unreachable
+            ChannelAddressCache::Entry entry;
+            ChannelAddressCache::shared_pointer cache(m_context->getAddressCache());
+            if (!cache || !cache->lookup(m_name, entry))
+                createChannelFailed();
+            else
+                // NOTE: calls channelConnectFailed() on failure
+                searchResponse(guid, PVA_CLIENT_PROTOCOL_REVISION, &address);
+        }
+
         virtual void callback() OVERRIDE FINAL {
             // TODO cancellaction?!
             // TODO not in this timer thread !!!
             // TODO boost when a server (from address list) is started!!! IP vs address !!!
+            if (m_addresses.empty())
+                return;
+
             int ix = m_addressIndex % m_addresses.size();
             m_addressIndex++;
             if (m_addressIndex >= static_cast<int>(m_addresses.size()*(STATIC_SEARCH_MAX_MULTIPLIER+1)))
@@ -3840,9 +4035,8 @@ public:
                 // array of CIDs and names
                 buffer->putInt(m_channelID);
                 SerializeHelper::serializeString(m_name, buffer, control);
-                // send immediately
-                // TODO
-                control->flush(true);
+                // no explicit flush.  the send queue is flushed once empty,
+                // so many channels created together share TCP messages.
             }
             else
             {
@@ -3854,9 +4048,7 @@ public:
                 buffer->putInt(sid);
                 // CID
                 buffer->putInt(m_channelID);
-                // send immediately
-                // TODO
-                control->flush(true);
+                // flushed with the rest of the send queue
             }
         }
 
@@ -3999,10 +4191,10 @@ public:
     static size_t num_instances;
 
     InternalClientContextImpl(const Configuration::shared_pointer& conf) :
-        m_addressList(""), m_autoAddressList(true), m_connectionTimeout(30.0f), m_beaconPeriod(15.0f),
+        m_addressList(""), m_autoAddressList(true), m_nameServers(""), m_addressCacheMaxAge(86400.0), m_addressCacheStop(false), m_connectionTimeout(30.0f), m_beaconPeriod(15.0f),
         m_broadcastPort(PVA_BROADCAST_PORT), m_receiveBufferSize(MAX_TCP_RECV),
-        m_lastCID(0x10203040),
-        m_lastIOID(0x80706050),
+        m_ioThreads(0),
+        m_monitorPoolSize(1024),
         m_version("pvAccess Client", "cpp",
                   EPICS_PVA_MAJOR_VERSION,
                   EPICS_PVA_MINOR_VERSION,
@@ -4041,6 +4233,11 @@ public:
         return m_searchTransport;
     }
 
+    virtual TransportReactor::shared_pointer getTransportReactor() OVERRIDE FINAL
+    {
+        return m_reactor;
+    }
+
     virtual void initialize() OVERRIDE FINAL {
         Lock lock(m_contextMutex);
 
@@ -4061,10 +4258,14 @@ public:
         out << "VERSION            : " << m_version.getVersionString() << std::endl;
         out << "ADDR_LIST          : " << m_addressList << std::endl;
         out << "AUTO_ADDR_LIST     : " << (m_autoAddressList ? "true" : "false") << std::endl;
+        out << "NAME_SERVERS       : " << m_nameServers << std::endl;
+        out << "ADDR_CACHE         : " << m_addressCacheFile << std::endl;
         out << "CONNECTION_TIMEOUT : " << m_connectionTimeout << std::endl;
         out << "BEACON_PERIOD      : " << m_beaconPeriod << std::endl;
         out << "BROADCAST_PORT     : " << m_broadcastPort << std::endl;;
         out << "RCV_BUFFER_SIZE    : " << m_receiveBufferSize << std::endl;
+        out << "IO_THREADS         : " << m_ioThreads << std::endl;
+        out << "MONITOR_POOL       : " << m_monitorPoolSize << std::endl;
         out << "STATE              : ";
         switch (m_contextState)
         {
@@ -4100,6 +4301,19 @@ public:
 
         m_timer->close();
 
+        // may wait for a connect() in progress
+        if (m_addressCacheThread.get())
+        {
+            {
+                Lock guard(m_addressCacheMutex);
+                m_addressCacheStop = true;
+                m_addressCacheConnects.clear();
+            }
+            m_addressCacheWakeup.signal();
+            // joins thread
+            m_addressCacheThread.reset();
+        }
+
         // Remove all beacons
         {
             Lock guard(m_beaconMapMutex);
@@ -4129,6 +4343,13 @@ public:
 
         if (transportCount)
             LOG(logLevelDebug, "PVA client context destroyed with %u transport(s) active.", (unsigned)transportCount);
+
+        if (m_addressCache)
+            m_addressCache->save();
+
+        // join shared I/O threads
+        if (m_reactor)
+            m_reactor->close();
     }
 
     virtual ~InternalClientContextImpl()
@@ -4154,10 +4375,23 @@ private:
 
         m_addressList = m_configuration->getPropertyAsString("EPICS_PVA_ADDR_LIST", m_addressList);
         m_autoAddressList = m_configuration->getPropertyAsBoolean("EPICS_PVA_AUTO_ADDR_LIST", m_autoAddressList);
+        m_nameServers = m_configuration->getPropertyAsString("EPICS_PVA_NAME_SERVERS", m_nameServers);
+        m_addressCacheFile = m_configuration->getPropertyAsString("EPICS_PVA_ADDR_CACHE", m_addressCacheFile);
+        m_addressCacheMaxAge = m_configuration->getPropertyAsDouble("EPICS_PVA_ADDR_CACHE_TMO", m_addressCacheMaxAge);
         m_connectionTimeout = m_configuration->getPropertyAsFloat("EPICS_PVA_CONN_TMO", m_connectionTimeout);
         m_beaconPeriod = m_configuration->getPropertyAsFloat("EPICS_PVA_BEACON_PERIOD", m_beaconPeriod);
         m_broadcastPort = m_configuration->getPropertyAsInteger("EPICS_PVA_BROADCAST_PORT", m_broadcastPort);
         m_receiveBufferSize = m_configuration->getPropertyAsInteger("EPICS_PVA_MAX_ARRAY_BYTES", m_receiveBufferSize);
+        m_ioThreads = m_configuration->getPropertyAsInteger("EPICS_PVA_IO_THREADS", m_ioThreads);
+        if (m_ioThreads < 0)
+            m_ioThreads = 0;
+        if (m_ioThreads > 0 && !TransportReactor::isSupported()) {
+            LOG(logLevelWarn, "EPICS_PVA_IO_THREADS not supported on this target.  Using thread per connection.");
+            m_ioThreads = 0;
+        }
+        m_monitorPoolSize = m_configuration->getPropertyAsInteger("EPICS_PVA_MONITOR_POOL", m_monitorPoolSize);
+        if (m_monitorPoolSize < 0)
+            m_monitorPoolSize = 0;
     }
 
     void internalInitialize() {
@@ -4165,6 +4399,10 @@ private:
         osiSockAttach();
         m_timer.reset(new Timer("pvAccess-client timer", lowPriority));
         InternalClientContextImpl::shared_pointer thisPointer(internal_from_this());
+
+        if (m_ioThreads > 0)
+            m_reactor.reset(new TransportReactor(m_ioThreads, "PVAC-io"));
+
         // stores weak_ptr
         m_connector.reset(new BlockingTCPConnector(thisPointer, m_receiveBufferSize, m_connectionTimeout));
 
@@ -4173,6 +4411,31 @@ private:
 
         m_channelSearchManager.reset(new ChannelSearchManager(thisPointer));
 
+        if (!m_nameServers.empty())
+        {
+            InetAddrVector nameServers;
+            getSocketAddressList(nameServers, m_nameServers,
+                                 m_configuration->getPropertyAsInteger("EPICS_PVA_SERVER_PORT", PVA_SERVER_PORT));
+            m_channelSearchManager->setNameServers(nameServers);
+        }
+
+        if (!m_addressCacheFile.empty())
+        {
+            m_addressCache.reset(new ChannelAddressCache(m_addressCacheFile, m_addressCacheMaxAge));
+            if (!m_addressCache->load())
+                LOG(logLevelDebug, "No channel address cache '%s', will be created", m_addressCacheFile.c_str());
+
+            m_addressCacheThread.reset(new epics::pvData::Thread(
+                                           epics::pvData::Thread::Config(this, &InternalClientContextImpl::addressCacheWorker)
+                                               .prio(epicsThreadPriorityLow)
+                                               .name("PVA addr cache")
+                                               .stack(epicsThreadStackBig)));
+        }
+
+        // limit for all types is a few busy types worth
+        if (m_monitorPoolSize > 0)
+            m_monitorPool.reset(new MonitorElementPool(m_monitorPoolSize, 4u*size_t(m_monitorPoolSize)));
+
         // TODO put memory barrier here... (if not already called within a lock?)
 
         // setup UDP transport
@@ -4205,22 +4468,11 @@ private:
     }
 
     void destroyAllChannels() {
-        Lock guard(m_cidMapMutex);
-
-        int count = 0;
-        std::vector<ClientChannelImpl::weak_pointer> channels(m_channelsByCID.size());
-        for (CIDChannelMap::iterator iter = m_channelsByCID.begin();
-                iter != m_channelsByCID.end();
-                iter++)
-        {
-            channels[count++] = iter->second;
-        }
-
-        guard.unlock();
-
+        std::vector<ClientChannelImpl::weak_pointer> channels;
+        m_channelsByCID.values(channels);
 
         ClientChannelImpl::shared_pointer ptr;
-        for (int i = 0; i < count; i++)
+        for (size_t i = 0; i < channels.size(); i++)
         {
             ptr = channels[i].lock();
             if (ptr)
@@ -4258,8 +4510,8 @@ private:
      */
     void registerChannel(ClientChannelImpl::shared_pointer const & channel) OVERRIDE FINAL
     {
-        Lock guard(m_cidMapMutex);
-        m_channelsByCID[channel->getChannelID()] = ClientChannelImpl::weak_pointer(channel);
+        // CID reserved by generateCID()
+        m_channelsByCID.set(channel->getChannelID(), ClientChannelImpl::weak_pointer(channel));
     }
 
     /**
@@ -4268,8 +4520,7 @@ private:
      */
     void unregisterChannel(ClientChannelImpl::shared_pointer const & channel) OVERRIDE FINAL
     {
-        Lock guard(m_cidMapMutex);
-        m_channelsByCID.erase(channel->getChannelID());
+        m_channelsByCID.remove(channel->getChannelID());
     }
 
     /**
@@ -4279,9 +4530,9 @@ private:
      */
     Channel::shared_pointer getChannel(pvAccessID channelID) OVERRIDE FINAL
     {
-        Lock guard(m_cidMapMutex);
-        CIDChannelMap::iterator it = m_channelsByCID.find(channelID);
-        return (it == m_channelsByCID.end() ? Channel::shared_pointer() : static_pointer_cast<Channel>(it->second.lock()));
+        ClientChannelImpl::weak_pointer channel;
+        m_channelsByCID.find(channelID, channel);
+        return static_pointer_cast<Channel>(channel.lock());
     }
 
     /**
@@ -4290,13 +4541,8 @@ private:
      */
     pvAccessID generateCID()
     {
-        Lock guard(m_cidMapMutex);
-
-        // search first free (theoretically possible loop of death)
-        while (m_channelsByCID.find(++m_lastCID) != m_channelsByCID.end()) ;
         // reserve CID
-        m_channelsByCID[m_lastCID].reset();
-        return m_lastCID;
+        return m_channelsByCID.allocate();
     }
 
     /**
@@ -4304,8 +4550,7 @@ private:
      */
     void freeCID(int cid)
     {
-        Lock guard(m_cidMapMutex);
-        m_channelsByCID.erase(cid);
+        m_channelsByCID.remove(cid);
     }
 
 
@@ -4316,10 +4561,9 @@ private:
      */
     ResponseRequest::shared_pointer getResponseRequest(pvAccessID ioid) OVERRIDE FINAL
     {
-        Lock guard(m_ioidMapMutex);
-        IOIDResponseRequestMap::iterator it = m_pendingResponseRequests.find(ioid);
-        if (it == m_pendingResponseRequests.end()) return ResponseRequest::shared_pointer();
-        return it->second.lock();
+        ResponseRequest::weak_pointer request;
+        m_pendingResponseRequests.find(ioid, request);
+        return request.lock();
     }
 
     /**
@@ -4329,10 +4573,7 @@ private:
      */
     pvAccessID registerResponseRequest(ResponseRequest::shared_pointer const & request) OVERRIDE FINAL
     {
-        Lock guard(m_ioidMapMutex);
-        pvAccessID ioid = generateIOID();
-        m_pendingResponseRequests[ioid] = ResponseRequest::weak_pointer(request);
-        return ioid;
+        return m_pendingResponseRequests.insert(ResponseRequest::weak_pointer(request));
     }
 
     /**
@@ -4344,41 +4585,94 @@ private:
     {
         if (ioid == INVALID_IOID) return ResponseRequest::shared_pointer();
 
-        Lock guard(m_ioidMapMutex);
-        IOIDResponseRequestMap::iterator it = m_pendingResponseRequests.find(ioid);
-        if (it == m_pendingResponseRequests.end())
-            return ResponseRequest::shared_pointer();
-
-        ResponseRequest::shared_pointer retVal = it->second.lock();
-        m_pendingResponseRequests.erase(it);
-        return retVal;
+        ResponseRequest::weak_pointer request;
+        m_pendingResponseRequests.remove(ioid, request);
+        return request.lock();
     }
 
     /**
-     * Generate IOID.
-     * @return IOID.
+     * Called each time beacon anomaly is detected.
      */
-    pvAccessID generateIOID()
+    virtual void newServerDetected() OVERRIDE FINAL
     {
-        Lock guard(m_ioidMapMutex);
+        if (m_channelSearchManager)
+            m_channelSearchManager->newServerDetected();
+    }
 
-        // search first free (theoretically possible loop of death)
-        do {
-            while (m_pendingResponseRequests.find(++m_lastIOID) != m_pendingResponseRequests.end()) ;
-        } while (m_lastIOID == INVALID_IOID);
+    /**
+     * Channels of a restarted server may now be elsewhere.
+     */
+    virtual void serverRestarted(ServerGUID const & previous) OVERRIDE FINAL
+    {
+        if (m_addressCache)
+            m_addressCache->invalidate(previous);
+    }
 
-        // reserve IOID
-        m_pendingResponseRequests[m_lastIOID].reset();
-        return m_lastIOID;
+    /**
+     * Channel address cache, or NULL if not enabled.
+     */
+    const ChannelAddressCache::shared_pointer& getAddressCache() const
+    {
+        return m_addressCache;
     }
 
     /**
-     * Called each time beacon anomaly is detected.
+     * Have the address cache thread call InternalChannelImpl::connectCached().
      */
-    virtual void newServerDetected() OVERRIDE FINAL
+    void queueCachedConnect(const InternalChannelImpl::shared_pointer& channel)
     {
-        if (m_channelSearchManager)
-            m_channelSearchManager->newServerDetected();
+        {
+            Lock guard(m_addressCacheMutex);
+            if (m_addressCacheStop)
+                return;
+            m_addressCacheConnects.push_back(channel);
+        }
+        m_addressCacheWakeup.signal();
+    }
+
+    // body of m_addressCacheThread
+    void addressCacheWorker()
+    {
+        while (true)
+        {
+            std::deque<InternalChannelImpl::weak_pointer> connects;
+            {
+                Lock guard(m_addressCacheMutex);
+                if (m_addressCacheStop)
+                    break;
+                connects.swap(m_addressCacheConnects);
+            }
+
+            for (size_t i=0; i<connects.size(); i++)
+            {
+                InternalChannelImpl::shared_pointer channel(connects[i].lock());
+                if (!channel)
+                    continue;
+                try
+                {
+                    // may block until the connection timeout
+                    channel->connectCached();
+                }
+                catch (std::exception& e)
+                {
+                    LOG(logLevelError, "Unhandled exception connecting cached channel address: %s", e.what());
+                }
+            }
+
+            // only writes if an entry has changed
+            m_addressCache->save();
+
+            if (connects.empty())
+                m_addressCacheWakeup.wait(ADDRESS_CACHE_SAVE_PERIOD);
+        }
+    }
+
+    // seconds between saves of a changed address cache
+    static const double ADDRESS_CACHE_SAVE_PERIOD;
+
+    virtual MonitorElementPool::shared_pointer getMonitorElementPool() OVERRIDE FINAL
+    {
+        return m_monitorPool;
     }
 
     /**
@@ -4486,6 +4780,38 @@ private:
      */
     bool m_autoAddressList;
 
+    /**
+     * A space-separated list of name server addresses, searched through TCP.
+     * Each address must be of the form: ip.number:port or host.name:port
+     */
+    string m_nameServers;
+
+    /**
+     * File name of the channel address cache.  Empty to disable.
+     */
+    string m_addressCacheFile;
+
+    /**
+     * Entries not seen for this many seconds are discarded from the address cache.
+     */
+    double m_addressCacheMaxAge;
+
+    /**
+     * Channel address cache, NULL if disabled.
+     */
+    ChannelAddressCache::shared_pointer m_addressCache;
+
+    /**
+     * With m_addressCache, connects to cached addresses, and saves the cache when changed.
+     * Woken by queueCachedConnect() and destroy().
+     */
+    epics::auto_ptr<epics::pvData::Thread> m_addressCacheThread;
+    epicsEvent m_addressCacheWakeup;
+    epics::pvData::Mutex m_addressCacheMutex;
+    // guarded by m_addressCacheMutex
+    std::deque<InternalChannelImpl::weak_pointer> m_addressCacheConnects;
+    bool m_addressCacheStop;
+
     /**
      * If the context doesn't see a beacon from a server that it is connected to for
      * connectionTimeout seconds then a state-of-health message is sent to the server over TCP/IP.
@@ -4509,6 +4835,27 @@ private:
      */
     int m_receiveBufferSize;
 
+    /**
+     * Number of shared I/O threads serving all TCP connections.
+     * Zero to start a receive and send thread for each connection.
+     */
+    int32 m_ioThreads;
+
+    /**
+     * Shared I/O threads, when m_ioThreads>0
+     */
+    TransportReactor::shared_pointer m_reactor;
+
+    /**
+     * Max. unused monitor queue structures kept for each type.  Zero disables pooling.
+     */
+    int32 m_monitorPoolSize;
+
+    /**
+     * Monitor queue storage shared by all monitors, NULL if disabled.
+     */
+    MonitorElementPool::shared_pointer m_monitorPool;
+
     /**
      * Timer.
      */
@@ -4541,36 +4888,14 @@ private:
     ClientResponseHandler::shared_pointer m_responseHandler;
 
     /**
-     * Map of channels (keys are CIDs).
-     */
-    // TODO consider std::unordered_map
-    typedef std::map<pvAccessID, ClientChannelImpl::weak_pointer> CIDChannelMap;
-    CIDChannelMap m_channelsByCID;
-
-    /**
-     *  CIDChannelMap mutex.
-     */
-    Mutex m_cidMapMutex;
-
-    /**
-     * Last CID cache.
-     */
-    pvAccessID m_lastCID;
-
-    /**
-     * Map of pending response requests (keys are IOID).
-     */
-    IOIDResponseRequestMap m_pendingResponseRequests;
-
-    /**
-     *  IOIDResponseRequestMap mutex.
+     * Table of channels (keys are CIDs).
      */
-    Mutex m_ioidMapMutex;
+    slot_table<ClientChannelImpl::weak_pointer> m_channelsByCID;
 
     /**
-     * Last IOID cache.
+     * Table of pending response requests (keys are IOID).
      */
-    pvAccessID m_lastIOID;
+    slot_table<ResponseRequest::weak_pointer> m_pendingResponseRequests;
 
     /**
      * Channel search manager.
@@ -4617,6 +4942,7 @@ private:
 };
 
 size_t InternalClientContextImpl::num_instances;
+const double InternalClientContextImpl::ADDRESS_CACHE_SAVE_PERIOD = 10.0;
 size_t InternalClientContextImpl::InternalChannelImpl::num_instances;
 size_t InternalClientContextImpl::InternalChannelImpl::num_active;
 
@@ -31,6 +31,7 @@ namespace pvAccess {
 
 class BeaconHandler;
 class ClientContextImpl;
+class MonitorElementPool;
 
 class ClientChannelImpl :
     public Channel,
@@ -110,6 +111,12 @@ public:
 
     virtual std::tr1::shared_ptr<BeaconHandler> getBeaconHandler(osiSockAddr* responseFrom) = 0;
 
+    /**
+     * Storage for monitor queues, shared by all monitors of this context.
+     * @return NULL if pooling is disabled.
+     */
+    virtual std::tr1::shared_ptr<MonitorElementPool> getMonitorElementPool() = 0;
+
     virtual void destroy() = 0;
 };
 
@@ -31,7 +31,13 @@ namespace pvAccess {
 class ServerContext;
 class RPCChannelProvider;
 
-//! Serves (only) RPCServiceAsync and RPCService instances.
+/** @brief Serves (only) RPCServiceAsync and RPCService instances.
+ *
+ * By default, services are called from the server I/O thread which received the request.
+ * Setting $EPICS_PVAS_RPC_THREADS to a positive number instead dispatches requests
+ * to a pool of this many worker threads, with at most $EPICS_PVAS_RPC_QUEUE (default 1024)
+ * requests waiting.  Further requests fail immediately.
+ */
 class epicsShareClass RPCServer :
     public std::tr1::enable_shared_from_this<RPCServer>
 {
@@ -43,12 +49,32 @@ private:
 public:
     POINTER_DEFINITIONS(RPCServer);
 
+    //! Per-service statistics.  Only collected when a worker pool is used.
+    struct ServiceStats {
+        size_t nqueued;    //!< requests currently waiting for a worker
+        size_t nrunning;   //!< requests currently executing.  Until requestDone(), or the request is destroyed
+        size_t ncompleted; //!< requests completed (requestDone() called)
+        size_t nrejected;  //!< requests failed as the queue was full
+        double waitTotal,  //!< total seconds spent waiting for a worker
+               waitMax;
+        double execTotal,  //!< total seconds from start of execution until requestDone()
+               execMax;
+        ServiceStats();
+    };
+
     explicit RPCServer(const Configuration::const_shared_pointer& conf = Configuration::const_shared_pointer());
 
     virtual ~RPCServer();
 
     void registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service);
 
+    /** Register a service, allowing at most maxConcurrent requests to execute at once.
+     *  Until requestDone() is called, a request of an RPCServiceAsync counts as executing.
+     *  maxConcurrent==0 is unlimited.  Limits only apply when a worker pool is used.
+     */
+    void registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service,
+                         size_t maxConcurrent);
+
     void unregisterService(std::string const & serviceName);
 
     void run(int seconds = 0);
@@ -57,10 +83,17 @@ public:
     /// owned by a shared_ptr instance.
     void runInNewThread(int seconds = 0);
 
+    //! Stops the server, and any worker threads.  Do not call from a service.
     void destroy();
 
+    //! Number of worker threads.  0 when services are called from I/O threads.
+    size_t numWorkers() const;
+
+    //! @returns false if no service is registered with this name
+    bool getServiceStats(const std::string& serviceName, ServiceStats& stats) const;
+
     /**
-     * Display basic information about the context.
+     * Display basic information about the context, and statistics of each service.
      */
     void printInfo();
 
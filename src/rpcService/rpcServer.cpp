@@ -5,8 +5,16 @@
  */
 
 #include <stdexcept>
+#include <sstream>
 #include <vector>
+#include <deque>
 #include <utility>
+#include <algorithm>
+
+#include <epicsEvent.h>
+#include <epicsTime.h>
+#include <epicsThread.h>
+#include <pv/thread.h>
 
 #define epicsExportSharedSymbols
 #include <pv/rpcServer.h>
@@ -19,6 +27,81 @@ using std::string;
 namespace epics {
 namespace pvAccess {
 
+typedef epicsGuardRelease<epicsMutex> UnLock;
+
+RPCServer::ServiceStats::ServiceStats()
+    :nqueued(0u)
+    ,nrunning(0u)
+    ,ncompleted(0u)
+    ,nrejected(0u)
+    ,waitTotal(0.0)
+    ,waitMax(0.0)
+    ,execTotal(0.0)
+    ,execMax(0.0)
+{}
+
+struct RPCServiceEntry
+{
+    POINTER_DEFINITIONS(RPCServiceEntry);
+
+    const RPCServiceAsync::shared_pointer service;
+    const size_t maxConcurrent; // 0 is unlimited
+
+    // guarded by RPCWorkerPool::mutex
+    size_t running;
+    RPCServer::ServiceStats stats;
+
+    RPCServiceEntry(const RPCServiceAsync::shared_pointer& service, size_t maxConcurrent)
+        :service(service)
+        ,maxConcurrent(maxConcurrent)
+        ,running(0u)
+    {}
+};
+
+class ChannelRPCServiceImpl;
+
+// Executes requests away from the server I/O threads
+class RPCWorkerPool
+{
+public:
+    POINTER_DEFINITIONS(RPCWorkerPool);
+
+    RPCWorkerPool(size_t nworkers, size_t maxQueue);
+    ~RPCWorkerPool();
+
+    //! Queue request, or fail it immediately if the queue is full
+    void submit(const std::tr1::shared_ptr<ChannelRPCServiceImpl>& op,
+                const PVStructure::shared_pointer& args);
+    //! Called when the request of op is done
+    void completed(ChannelRPCServiceImpl& op);
+    //! Called when op is destroyed, maybe before its request is done
+    void abandoned(ChannelRPCServiceImpl& op);
+    //! Join workers, and fail any queued requests
+    void close();
+
+    size_t size() const { return workers.size(); }
+
+    // also guards RPCServiceEntry::running and stats,
+    // and ChannelRPCServiceImpl::m_executing and m_started
+    mutable Mutex mutex;
+
+private:
+    void run();
+
+    struct Job {
+        std::tr1::shared_ptr<ChannelRPCServiceImpl> op;
+        PVStructure::shared_pointer args;
+        epicsTimeStamp queued;
+    };
+    typedef std::deque<Job> jobs_t;
+    jobs_t jobs;
+
+    epicsEvent wakeup;
+    bool closing;
+    const size_t maxQueue;
+
+    std::vector<std::tr1::shared_ptr<epics::pvData::Thread> > workers;
+};
 
 class ChannelRPCServiceImpl :
     public ChannelRPC,
@@ -28,18 +111,28 @@ class ChannelRPCServiceImpl :
 private:
     Channel::shared_pointer m_channel;
     ChannelRPCRequester::shared_pointer m_channelRPCRequester;
-    RPCServiceAsync::shared_pointer m_rpcService;
     AtomicBoolean m_lastRequest;
 
 public:
+    const RPCServiceEntry::shared_pointer m_entry;
+    // NULL to call service directly
+    const RPCWorkerPool::shared_pointer m_pool;
+
+    // guarded by m_pool->mutex
+    bool m_executing;
+    epicsTimeStamp m_started;
+
     ChannelRPCServiceImpl(
         Channel::shared_pointer const & channel,
         ChannelRPCRequester::shared_pointer const & channelRPCRequester,
-        RPCServiceAsync::shared_pointer const & rpcService) :
+        RPCServiceEntry::shared_pointer const & entry,
+        RPCWorkerPool::shared_pointer const & pool) :
         m_channel(channel),
         m_channelRPCRequester(channelRPCRequester),
-        m_rpcService(rpcService),
-        m_lastRequest()
+        m_lastRequest(),
+        m_entry(entry),
+        m_pool(pool),
+        m_executing(false)
     {
     }
 
@@ -52,6 +145,18 @@ public:
         epics::pvData::Status const & status,
         epics::pvData::PVStructure::shared_pointer const & result
     )
+    {
+        if (m_pool)
+            m_pool->completed(*this);
+
+        respond(status, result);
+    }
+
+    // complete without accounting
+    void respond(
+        epics::pvData::Status const & status,
+        epics::pvData::PVStructure::shared_pointer const & result = PVStructure::shared_pointer()
+    )
     {
         m_channelRPCRequester->requestDone(status, shared_from_this(), result);
 
@@ -60,20 +165,25 @@ public:
     }
 
     virtual void request(epics::pvData::PVStructure::shared_pointer const & pvArgument)
+    {
+        if (m_pool)
+            m_pool->submit(shared_from_this(), pvArgument);
+        else
+            invoke(pvArgument);
+    }
+
+    void invoke(epics::pvData::PVStructure::shared_pointer const & pvArgument)
     {
         try
         {
-            m_rpcService->request(pvArgument, shared_from_this());
+            m_entry->service->request(pvArgument, shared_from_this());
         }
         catch (std::exception& ex)
         {
             // handle user unexpected errors
             Status errorStatus(Status::STATUSTYPE_FATAL, ex.what());
 
-            m_channelRPCRequester->requestDone(errorStatus, shared_from_this(), PVStructure::shared_pointer());
-
-            if (m_lastRequest.get())
-                destroy();
+            requestDone(errorStatus, PVStructure::shared_pointer());
         }
         catch (...)
         {
@@ -81,10 +191,7 @@ public:
             Status errorStatus(Status::STATUSTYPE_FATAL,
                                "Unexpected exception caught while calling RPCServiceAsync.request(PVStructure, RPCResponseCallback).");
 
-            m_channelRPCRequester->requestDone(errorStatus, shared_from_this(), PVStructure::shared_pointer());
-
-            if (m_lastRequest.get())
-                destroy();
+            requestDone(errorStatus, PVStructure::shared_pointer());
         }
 
         // we wait for callback to be called
@@ -107,11 +214,179 @@ public:
 
     virtual void destroy()
     {
-        // noop
+        // a service which never calls requestDone() must not hold a slot forever
+        if (m_pool)
+            m_pool->abandoned(*this);
     }
 };
 
+RPCWorkerPool::RPCWorkerPool(size_t nworkers, size_t maxQueue)
+    :closing(false)
+    ,maxQueue(maxQueue)
+{
+    workers.reserve(nworkers);
+    for(size_t i=0; i<nworkers; i++) {
+        std::ostringstream name;
+        name<<"RPCWorker-"<<i;
+        std::tr1::shared_ptr<epics::pvData::Thread> worker(new epics::pvData::Thread(
+                    epics::pvData::Thread::Config(this, &RPCWorkerPool::run)
+                        .prio(epicsThreadPriorityMedium)
+                        .name(name.str())
+                        .stack(epicsThreadStackBig)
+                        .autostart(false)));
+        workers.push_back(worker);
+    }
+    for(size_t i=0; i<workers.size(); i++)
+        workers[i]->start();
+}
 
+RPCWorkerPool::~RPCWorkerPool()
+{
+    close();
+}
+
+void RPCWorkerPool::submit(const std::tr1::shared_ptr<ChannelRPCServiceImpl>& op,
+                           const PVStructure::shared_pointer& args)
+{
+    bool full, closed;
+    {
+        Lock G(mutex);
+        closed = closing;
+        full = closing || jobs.size()>=maxQueue;
+        if(full) {
+            op->m_entry->stats.nrejected++;
+        } else {
+            Job job;
+            job.op = op;
+            job.args = args;
+            epicsTimeGetCurrent(&job.queued);
+            jobs.push_back(job);
+            op->m_entry->stats.nqueued++;
+        }
+    }
+    if(full)
+        op->respond(Status(Status::STATUSTYPE_ERROR, closed ? "RPC server shutting down" : "RPC request queue full"));
+    else
+        wakeup.signal();
+}
+
+void RPCWorkerPool::completed(ChannelRPCServiceImpl& op)
+{
+    bool blocked;
+    {
+        Lock G(mutex);
+        if(!op.m_executing)
+            return; // paranoia.  requestDone() called twice?
+        op.m_executing = false;
+
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
+        const double exec = epicsTimeDiffInSeconds(&now, &op.m_started);
+
+        RPCServiceEntry& ent = *op.m_entry;
+        ent.running--;
+        ent.stats.nrunning--;
+        ent.stats.ncompleted++;
+        ent.stats.execTotal += exec;
+        ent.stats.execMax = std::max(ent.stats.execMax, exec);
+
+        // a request waiting on this service's limit may now run
+        blocked = ent.maxConcurrent && !jobs.empty();
+    }
+    if(blocked)
+        wakeup.signal();
+}
+
+void RPCWorkerPool::abandoned(ChannelRPCServiceImpl& op)
+{
+    bool blocked;
+    {
+        Lock G(mutex);
+        if(!op.m_executing)
+            return; // not started, or already completed
+        op.m_executing = false;
+
+        // not counted as completed
+        RPCServiceEntry& ent = *op.m_entry;
+        ent.running--;
+        ent.stats.nrunning--;
+
+        blocked = ent.maxConcurrent && !jobs.empty();
+    }
+    if(blocked)
+        wakeup.signal();
+}
+
+void RPCWorkerPool::close()
+{
+    jobs_t pending;
+    {
+        Lock G(mutex);
+        if(closing)
+            return;
+        closing = true;
+        pending.swap(jobs);
+        for(jobs_t::iterator it(pending.begin()), end(pending.end()); it!=end; ++it)
+            it->op->m_entry->stats.nqueued--;
+    }
+
+    wakeup.signal();
+    for(size_t i=0; i<workers.size(); i++)
+        workers[i]->exitWait();
+
+    for(jobs_t::iterator it(pending.begin()), end(pending.end()); it!=end; ++it)
+        it->op->respond(Status(Status::STATUSTYPE_ERROR, "RPC server shutting down"));
+}
+
+void RPCWorkerPool::run()
+{
+    Lock G(mutex);
+
+    while(!closing) {
+        // oldest request which is not held back by its service's limit
+        jobs_t::iterator it(jobs.begin()), end(jobs.end());
+        for(; it!=end; ++it) {
+            const RPCServiceEntry& ent = *it->op->m_entry;
+            if(!ent.maxConcurrent || ent.running < ent.maxConcurrent)
+                break;
+        }
+
+        if(it==end) {
+            UnLock U(G);
+            wakeup.wait();
+            continue;
+        }
+
+        Job job(*it);
+        jobs.erase(it);
+        if(!jobs.empty())
+            wakeup.signal(); // maybe work for another worker
+
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
+        const double wait = epicsTimeDiffInSeconds(&now, &job.queued);
+
+        RPCServiceEntry& ent = *job.op->m_entry;
+        ent.running++;
+        ent.stats.nqueued--;
+        ent.stats.nrunning++;
+        ent.stats.waitTotal += wait;
+        ent.stats.waitMax = std::max(ent.stats.waitMax, wait);
+
+        job.op->m_executing = true;
+        job.op->m_started = now;
+
+        {
+            UnLock U(G);
+            job.op->invoke(job.args);
+            // release references without locking
+            job.op.reset();
+            job.args.reset();
+        }
+    }
+
+    wakeup.signal(); // wake the next worker to exit
+}
 
 
 class RPCChannel :
@@ -126,7 +401,8 @@ private:
     string m_channelName;
     ChannelRequester::shared_pointer m_channelRequester;
 
-    RPCServiceAsync::shared_pointer m_rpcService;
+    RPCServiceEntry::shared_pointer m_entry;
+    RPCWorkerPool::shared_pointer m_pool;
 
 public:
     POINTER_DEFINITIONS(RPCChannel);
@@ -135,11 +411,13 @@ public:
         ChannelProvider::shared_pointer const & provider,
         string const & channelName,
         ChannelRequester::shared_pointer const & channelRequester,
-        RPCServiceAsync::shared_pointer const & rpcService) :
+        RPCServiceEntry::shared_pointer const & entry,
+        RPCWorkerPool::shared_pointer const & pool = RPCWorkerPool::shared_pointer()) :
         m_provider(provider),
         m_channelName(channelName),
         m_channelRequester(channelRequester),
-        m_rpcService(rpcService)
+        m_entry(entry),
+        m_pool(pool)
     {
     }
 
@@ -199,7 +477,7 @@ public:
 
         // TODO use std::make_shared
         std::tr1::shared_ptr<ChannelRPCServiceImpl> tp(
-            new ChannelRPCServiceImpl(shared_from_this(), channelRPCRequester, m_rpcService)
+            new ChannelRPCServiceImpl(shared_from_this(), channelRPCRequester, m_entry, m_pool)
         );
         ChannelRPC::shared_pointer channelRPCImpl = tp;
         channelRPCRequester->channelRPCConnect(Status::Ok, channelRPCImpl);
@@ -232,8 +510,9 @@ Channel::shared_pointer createRPCChannel(ChannelProvider::shared_pointer const &
         RPCServiceAsync::shared_pointer const & rpcService)
 {
     // TODO use std::make_shared
+    RPCServiceEntry::shared_pointer entry(new RPCServiceEntry(rpcService, 0u));
     std::tr1::shared_ptr<RPCChannel> tp(
-        new RPCChannel(provider, channelName, channelRequester, rpcService)
+        new RPCChannel(provider, channelName, channelRequester, entry)
     );
     Channel::shared_pointer channel = tp;
     return channel;
@@ -252,9 +531,17 @@ public:
 
     static const Status noSuchChannelStatus;
 
-    // TODO thread pool support
+    explicit RPCChannelProvider(const Configuration::const_shared_pointer& conf)
+    {
+        Configuration::const_shared_pointer C(conf);
+        if(!C)
+            C = ConfigurationBuilder().push_env().build();
+
+        const int32 nworkers = C->getPropertyAsInteger("EPICS_PVAS_RPC_THREADS", 0);
+        const int32 maxQueue = C->getPropertyAsInteger("EPICS_PVAS_RPC_QUEUE", 1024);
 
-    RPCChannelProvider() {
+        if(nworkers>0)
+            m_pool.reset(new RPCWorkerPool(nworkers, std::max(maxQueue, int32(1))));
     }
 
     virtual string getProviderName() {
@@ -311,19 +598,18 @@ public:
         ChannelRequester::shared_pointer const & channelRequester,
         short /*priority*/)
     {
-        RPCServiceAsync::shared_pointer service;
+        RPCServiceEntry::shared_pointer service;
 
-        RPCServiceMap::const_iterator iter;
         {
             Lock guard(m_mutex);
-            iter = m_services.find(channelName);
-        }
-        if (iter != m_services.end())
-            service = iter->second;
+            RPCServiceMap::const_iterator iter(m_services.find(channelName));
+            if (iter != m_services.end())
+                service = iter->second;
 
-        // check for wild services
-        if (!service)
-            service = findWildService(channelName);
+            // check for wild services
+            if (!service)
+                service = findWildService(channelName);
+        }
 
         if (!service)
         {
@@ -338,7 +624,8 @@ public:
                 shared_from_this(),
                 channelName,
                 channelRequester,
-                service));
+                service,
+                m_pool));
         Channel::shared_pointer rpcChannel = tp;
         channelRequester->channelCreated(Status::Ok, rpcChannel);
         return rpcChannel;
@@ -354,13 +641,16 @@ public:
         throw std::runtime_error("not supported");
     }
 
-    void registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service)
+    void registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service,
+                         size_t maxConcurrent)
     {
+        RPCServiceEntry::shared_pointer entry(new RPCServiceEntry(service, maxConcurrent));
+
         Lock guard(m_mutex);
-        m_services[serviceName] = service;
+        m_services[serviceName] = entry;
 
         if (isWildcardPattern(serviceName))
-            m_wildServices.push_back(std::make_pair(serviceName, service));
+            m_wildServices.push_back(std::make_pair(serviceName, entry));
     }
 
     void unregisterService(std::string const & serviceName)
@@ -381,9 +671,42 @@ public:
         }
     }
 
+    bool getServiceStats(const std::string& serviceName, RPCServer::ServiceStats& stats) const
+    {
+        RPCServiceEntry::shared_pointer entry;
+        {
+            Lock guard(m_mutex);
+            RPCServiceMap::const_iterator iter(m_services.find(serviceName));
+            if (iter == m_services.end())
+                return false;
+            entry = iter->second;
+        }
+
+        if (m_pool) {
+            Lock guard(m_pool->mutex);
+            stats = entry->stats;
+        } else {
+            stats = RPCServer::ServiceStats();
+        }
+        return true;
+    }
+
+    void serviceNames(std::vector<string>& names) const
+    {
+        Lock guard(m_mutex);
+        names.reserve(m_services.size());
+        for (RPCServiceMap::const_iterator iter = m_services.begin();
+                iter != m_services.end();
+                iter++)
+            names.push_back(iter->first);
+    }
+
+    //! NULL if services are called from I/O threads
+    const RPCWorkerPool::shared_pointer& getPool() const { return m_pool; }
+
 private:
     // assumes sync on services
-    RPCServiceAsync::shared_pointer findWildService(string const & wildcard)
+    RPCServiceEntry::shared_pointer findWildService(string const & wildcard)
     {
         if (!m_wildServices.empty())
             for (RPCWildServiceList::iterator iter = m_wildServices.begin();
@@ -392,7 +715,7 @@ private:
                 if (Wildcard::wildcardfit(iter->first.c_str(), wildcard.c_str()))
                     return iter->second;
 
-        return RPCServiceAsync::shared_pointer();
+        return RPCServiceEntry::shared_pointer();
     }
 
     // (too) simple check
@@ -404,13 +727,15 @@ private:
              (pattern.find('[') != string::npos && pattern.find(']') != string::npos));
     }
 
-    typedef std::map<string, RPCServiceAsync::shared_pointer> RPCServiceMap;
+    typedef std::map<string, RPCServiceEntry::shared_pointer> RPCServiceMap;
     RPCServiceMap m_services;
 
-    typedef std::vector<std::pair<string, RPCServiceAsync::shared_pointer> > RPCWildServiceList;
+    typedef std::vector<std::pair<string, RPCServiceEntry::shared_pointer> > RPCWildServiceList;
     RPCWildServiceList m_wildServices;
 
-    epics::pvData::Mutex m_mutex;
+    RPCWorkerPool::shared_pointer m_pool;
+
+    mutable epics::pvData::Mutex m_mutex;
 };
 
 const string RPCChannelProvider::PROVIDER_NAME("rpcService");
@@ -418,7 +743,7 @@ const Status RPCChannelProvider::noSuchChannelStatus(Status::STATUSTYPE_ERROR, "
 
 
 RPCServer::RPCServer(const Configuration::const_shared_pointer &conf)
-    :m_channelProviderImpl(new RPCChannelProvider)
+    :m_channelProviderImpl(new RPCChannelProvider(conf))
 {
     m_serverContext = ServerContext::create(ServerContext::Config()
                                             .config(conf)
@@ -435,6 +760,32 @@ void RPCServer::printInfo()
 {
     std::cout << m_serverContext->getVersion().getVersionString() << std::endl;
     m_serverContext->printInfo();
+
+    if (!m_channelProviderImpl->getPool())
+        return;
+
+    std::cout << "RPC worker threads: " << numWorkers() << std::endl;
+
+    std::vector<string> names;
+    m_channelProviderImpl->serviceNames(names);
+    for (size_t i=0; i<names.size(); i++)
+    {
+        ServiceStats stats;
+        if (!getServiceStats(names[i], stats))
+            continue;
+        // waitTotal includes requests still running
+        const size_t nstarted = stats.ncompleted + stats.nrunning;
+        const double waitAvg = nstarted ? stats.waitTotal/nstarted : 0.0,
+                     execAvg = stats.ncompleted ? stats.execTotal/stats.ncompleted : 0.0;
+        std::cout << "  " << names[i]
+                  << " queued=" << stats.nqueued
+                  << " running=" << stats.nrunning
+                  << " completed=" << stats.ncompleted
+                  << " rejected=" << stats.nrejected
+                  << " wait(avg/max)=" << waitAvg << "/" << stats.waitMax
+                  << " exec(avg/max)=" << execAvg << "/" << stats.execMax
+                  << std::endl;
+    }
 }
 
 void RPCServer::run(int seconds)
@@ -476,11 +827,30 @@ void RPCServer::runInNewThread(int seconds)
 void RPCServer::destroy()
 {
     m_serverContext->shutdown();
+    if (m_channelProviderImpl->getPool())
+        m_channelProviderImpl->getPool()->close();
+}
+
+size_t RPCServer::numWorkers() const
+{
+    const RPCWorkerPool::shared_pointer& pool(m_channelProviderImpl->getPool());
+    return pool ? pool->size() : 0u;
+}
+
+bool RPCServer::getServiceStats(const std::string& serviceName, ServiceStats& stats) const
+{
+    return m_channelProviderImpl->getServiceStats(serviceName, stats);
 }
 
 void RPCServer::registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service)
 {
-    m_channelProviderImpl->registerService(serviceName, service);
+    m_channelProviderImpl->registerService(serviceName, service, 0u);
+}
+
+void RPCServer::registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service,
+                                size_t maxConcurrent)
+{
+    m_channelProviderImpl->registerService(serviceName, service, maxConcurrent);
 }
 
 void RPCServer::unregisterService(std::string const & serviceName)
@@ -135,6 +135,56 @@ public:
 };
 
 
+/**
+ * Collects the positive results for the names of one search request,
+ * which are sent as few CMD_SEARCH_RESPONSE messages, each with many CIDs.
+ * Results of synchronous channelFind() are sent once all names have been dispatched.
+ * Later (asynchronous) results are sent after a short delay, gathering any others
+ * completing in the meantime.
+ *
+ * Responses to a request received through UDP are sent through the broadcast transport.
+ * Responses to a request received through TCP (name server search) are sent through that connection.
+ */
+class ServerSearchResponseBatch :
+    public TransportSender,
+    public epics::pvData::TimerCallback,
+    public std::tr1::enable_shared_from_this<ServerSearchResponseBatch>
+{
+public:
+    POINTER_DEFINITIONS(ServerSearchResponseBatch);
+
+    ServerSearchResponseBatch(ServerContextImpl::shared_pointer const & context,
+                              epics::pvData::int32 searchSequenceId,
+                              osiSockAddr const & sendTo,
+                              Transport::shared_pointer const & tcpTransport = Transport::shared_pointer());
+    virtual ~ServerSearchResponseBatch() {}
+
+    //! Queue a positive response for a CID
+    void add(epics::pvData::int32 cid);
+    //! channelFind() has been called for all names of the request
+    void dispatched();
+
+    virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL;
+
+    virtual void callback() OVERRIDE FINAL;
+    virtual void timerStopped() OVERRIDE FINAL;
+
+private:
+    void flush();
+
+    ServerGUID _guid;
+    const epics::pvData::int32 _searchSequenceId;
+    const osiSockAddr _sendTo;
+    const ServerContextImpl::shared_pointer _context;
+    const Transport::shared_pointer _tcpTransport;
+    const size_t _maxCIDs;
+    mutable epics::pvData::Mutex _mutex;
+    std::vector<epics::pvData::int32> _cids;
+    bool _dispatching; // channelFind() calls in progress
+    bool _scheduled;   // flush timer pending
+    bool _queued;      // send request queued
+};
+
 class ServerChannelFindRequesterImpl:
     public ChannelFindRequester,
     public TransportSender,
@@ -144,7 +194,8 @@ class ServerChannelFindRequesterImpl:
 public:
     ServerChannelFindRequesterImpl(ServerContextImpl::shared_pointer const & context,
                                    const PeerInfo::const_shared_pointer& peer,
-                                   epics::pvData::int32 expectedResponseCount);
+                                   epics::pvData::int32 expectedResponseCount,
+                                   ServerSearchResponseBatch::shared_pointer const & batch = ServerSearchResponseBatch::shared_pointer());
     virtual ~ServerChannelFindRequesterImpl() {}
     void clear();
     ServerChannelFindRequesterImpl* set(std::string _name, epics::pvData::int32 searchSequenceId,
@@ -171,6 +222,8 @@ private:
     const epics::pvData::int32 _expectedResponseCount;
     epics::pvData::int32 _responseCount;
     bool _serverSearch;
+    // when set, positive results are sent through this batch
+    const ServerSearchResponseBatch::shared_pointer _batch;
 };
 
 /****************************************************************************************/
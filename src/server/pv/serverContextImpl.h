@@ -16,6 +16,7 @@
 #include <pv/blockingUDP.h>
 #include <pv/blockingTCP.h>
 #include <pv/beaconEmitter.h>
+#include <pv/transportReactor.h>
 
 #include "serverContext.h"
 
@@ -51,6 +52,7 @@ public:
     Transport::shared_pointer getSearchTransport() OVERRIDE FINAL;
     Configuration::const_shared_pointer getConfiguration() OVERRIDE FINAL;
     TransportRegistry* getTransportRegistry() OVERRIDE FINAL;
+    TransportReactor::shared_pointer getTransportReactor() OVERRIDE FINAL;
 
     virtual void newServerDetected() OVERRIDE FINAL;
 
@@ -76,6 +78,13 @@ public:
      */
     epics::pvData::int32 getReceiveBufferSize();
 
+    /**
+     * Get the maximum number of monitor updates sent for one subscription
+     * each time it is taken from the send queue.
+     * @return monitor batch size, >= 1.
+     */
+    epics::pvData::int32 getMonitorBatchSize();
+
     /**
      * Get server port.
      * @return server port.
@@ -172,6 +181,27 @@ private:
      */
     epics::pvData::int32 _receiveBufferSize;
 
+    /**
+     * Number of shared I/O threads serving all TCP connections.
+     * Zero to start a receive and send thread for each connection.
+     */
+    epics::pvData::int32 _ioThreads;
+
+    /**
+     * Maximum number of monitor updates for one subscription sent per turn in the send queue.
+     */
+    epics::pvData::int32 _monitorBatchSize;
+
+    /**
+     * Acceptor threads, listen backlog, and connection admission rate.
+     */
+    BlockingTCPAcceptor::Config _acceptorConfig;
+
+    /**
+     * Directory for a local (unix) socket, in addition to TCP.  Empty to disable.
+     */
+    std::string _unixDir;
+
     epics::pvData::Timer::shared_pointer _timer;
 
     /**
@@ -191,6 +221,16 @@ private:
      */
     BlockingTCPAcceptor::shared_pointer _acceptor;
 
+    /**
+     * Accepts connections on the local socket, if _unixDir is set.
+     */
+    BlockingTCPAcceptor::shared_pointer _localAcceptor;
+
+    /**
+     * Shared I/O threads, when _ioThreads>0
+     */
+    TransportReactor::shared_pointer _reactor;
+
     /**
      * PVA transport (virtual circuit) registry.
      * This registry contains all active transports - connections to PVA servers.
@@ -126,6 +126,7 @@ private:
     typedef std::map<std::string, std::tr1::shared_ptr<ChannelBuilder> > builders_t;
 public:
     typedef builders_t::const_iterator const_iterator;
+    typedef std::vector<std::pair<std::string, std::tr1::shared_ptr<ChannelBuilder> > > builder_list_t;
 
     //! Build a new, empty, provider.
     //! @param name Provider Name.  Only relevant if registerAsServer() is called, then must be unique in this process.
@@ -140,10 +141,18 @@ public:
     //! Add a PV (eg. SharedPV) to this provider.
     void add(const std::string& name,
              const std::tr1::shared_ptr<ChannelBuilder>& builder);
+    //! Add many PVs.  Faster than add() of each when populating a large provider.
+    //! @throws std::logic_error if any name is already present, or repeated, in which case none are added.
+    //! @since 7.1.9
+    void add(const builder_list_t& pvs);
     //! Remove a PV.  Closes any open Channels to it.
     //! @returns the PV which has been removed.
     //! @note Provider locking rules apply (@see provider_roles_requester_locking).
     std::tr1::shared_ptr<ChannelBuilder> remove(const std::string& name);
+    //! Remove many PVs.  Names not present are ignored.  Closes any open Channels to them.
+    //! @note Provider locking rules apply (@see provider_roles_requester_locking).
+    //! @since 7.1.9
+    void remove(const std::vector<std::string>& names);
 
     //! Fetch the underlying ChannelProvider.  Usually to build a ServerContext around.
     std::tr1::shared_ptr<epics::pvAccess::ChannelProvider> provider() const;
@@ -212,15 +221,54 @@ public:
         virtual void destroy() {}
     };
 
+    /** Optional cache of Handler::hasChannels() results.
+     *
+     * Each name searched for is passed to hasChannels() at most once per TTL.
+     * Only appropriate if the result does not depend on Search::peer().
+     * @since 7.1.9
+     */
+    struct epicsShareClass CacheConfig {
+        //! Maximum number of names remembered.  Least recently searched are forgotten first.  0 disables the cache.
+        size_t maxEntries;
+        //! Seconds to remember a claimed name.
+        double positiveTTL;
+        //! Seconds to remember a name which was not claimed.
+        double negativeTTL;
+        CacheConfig() :maxEntries(0u), positiveTTL(10.0), negativeTTL(10.0) {}
+    };
+
+    //! @since 7.1.9
+    struct CacheStats {
+        //! Searches answered from the cache
+        size_t hits;
+        //! Searches passed to Handler::hasChannels()
+        size_t misses;
+        //! Names currently cached
+        size_t entries;
+        CacheStats() :hits(0u), misses(0u), entries(0u) {}
+    };
+
     //! Build a new provider.
     //! @param name Provider Name.  Only relevant if registerAsServer() is called, then must be unique in this process.
     //! @param handler Our callbacks.  Internally stored a shared_ptr (strong reference).
+    //! @param cache Search result cache.  Disabled by default.  @since 7.1.9
     DynamicProvider(const std::string& name,
-                    const std::tr1::shared_ptr<Handler>& handler);
+                    const std::tr1::shared_ptr<Handler>& handler,
+                    const CacheConfig& cache = CacheConfig());
     ~DynamicProvider();
 
     Handler::shared_pointer getHandler() const;
 
+    //! Forget all cached search results.  eg. when the names Handler would claim have changed.
+    //! @since 7.1.9
+    void invalidate();
+    //! Forget any cached search result for this name.
+    //! @since 7.1.9
+    void invalidate(const std::string& name);
+    //! Search result cache statistics.  All zero if not enabled.
+    //! @since 7.1.9
+    CacheStats cacheStats() const;
+
     //void close();
 
     //! Fetch the underlying ChannelProvider.  Usually to build a ServerContext around.
@@ -5,6 +5,7 @@
  */
 
 #include <sstream>
+#include <algorithm>
 #include <time.h>
 #include <stdlib.h>
 
@@ -343,6 +344,16 @@ void ServerSearchHandler::handleResponse(osiSockAddr* responseFrom,
 
     if (count > 0)
     {
+        ServerSearchResponseBatch::shared_pointer batch;
+        if (allowed)
+        {
+            // a name server search through TCP is answered through the same connection
+            Transport::shared_pointer tcpTransport;
+            if (!dynamic_pointer_cast<BlockingUDPTransport>(transport))
+                tcpTransport = transport;
+            batch.reset(new ServerSearchResponseBatch(_context, searchSequenceId, responseAddress, tcpTransport));
+        }
+
         // regular name search
         for (int32 i = 0; i < count; i++)
         {
@@ -356,13 +367,16 @@ void ServerSearchHandler::handleResponse(osiSockAddr* responseFrom,
                 const std::vector<ChannelProvider::shared_pointer>& _providers = _context->getChannelProviders();
 
                 int providerCount = _providers.size();
-                std::tr1::shared_ptr<ServerChannelFindRequesterImpl> tp(new ServerChannelFindRequesterImpl(_context, info, providerCount));
+                std::tr1::shared_ptr<ServerChannelFindRequesterImpl> tp(new ServerChannelFindRequesterImpl(_context, info, providerCount, batch));
                 tp->set(name, searchSequenceId, cid, responseAddress, responseRequired, false);
 
                 for (int i = 0; i < providerCount; i++)
                     _providers[i]->channelFind(name, tp);
             }
         }
+
+        if (batch)
+            batch->dispatched();
     }
     else
     {
@@ -383,8 +397,127 @@ void ServerSearchHandler::handleResponse(osiSockAddr* responseFrom,
     }
 }
 
+namespace {
+// delay before sending asynchronous search results, to gather others
+const double searchResponseBatchDelay = 0.01;
+// CIDs in one response, keeping the response datagram unfragmented
+const size_t searchResponseMaxCIDs = (MAX_UDP_UNFRAGMENTED_SEND-PVA_MESSAGE_HEADER_SIZE-64)/4;
+// CIDs in one response through TCP.  (client reads count as int16)
+const size_t searchResponseMaxCIDsTCP = 0x7fff;
+}
+
+ServerSearchResponseBatch::ServerSearchResponseBatch(ServerContextImpl::shared_pointer const & context,
+        int32 searchSequenceId, osiSockAddr const & sendTo, Transport::shared_pointer const & tcpTransport) :
+    _guid(context->getGUID()),
+    _searchSequenceId(searchSequenceId),
+    _sendTo(sendTo),
+    _context(context),
+    _tcpTransport(tcpTransport),
+    _maxCIDs(tcpTransport ? searchResponseMaxCIDsTCP : searchResponseMaxCIDs),
+    _dispatching(true),
+    _scheduled(false),
+    _queued(false)
+{}
+
+void ServerSearchResponseBatch::add(int32 cid)
+{
+    {
+        Lock guard(_mutex);
+        _cids.push_back(cid);
+        if (_dispatching || _scheduled)
+            return;
+        _scheduled = true;
+    }
+
+    TimerCallback::shared_pointer tc(shared_from_this());
+    _context->getTimer()->scheduleAfterDelay(tc, searchResponseBatchDelay);
+}
+
+void ServerSearchResponseBatch::dispatched()
+{
+    {
+        Lock guard(_mutex);
+        _dispatching = false;
+    }
+    flush();
+}
+
+void ServerSearchResponseBatch::callback()
+{
+    {
+        Lock guard(_mutex);
+        _scheduled = false;
+    }
+    flush();
+}
+
+void ServerSearchResponseBatch::timerStopped()
+{
+    // noop
+}
+
+void ServerSearchResponseBatch::flush()
+{
+    Transport::shared_pointer transport(_tcpTransport);
+    if (!transport)
+        transport = _context->getBroadcastTransport();
+    TransportSender::shared_pointer thisSender = shared_from_this();
+
+    while (true)
+    {
+        {
+            Lock guard(_mutex);
+            if (_cids.empty() || _queued)
+                return;
+            if (!transport) {
+                _cids.clear();
+                return;
+            }
+            _queued = true;
+        }
+        // UDP sends immediately, and each send() takes up to _maxCIDs.
+        // TCP sends later, from the send thread, which queues again if necessary.
+        transport->enqueueSendRequest(thisSender);
+    }
+}
+
+void ServerSearchResponseBatch::send(ByteBuffer* buffer, TransportSendControl* control)
+{
+    control->startMessage(CMD_SEARCH_RESPONSE, 12+4+16+2);
+
+    Lock guard(_mutex);
+    buffer->put(_guid.value, 0, sizeof(_guid.value));
+    buffer->putInt(_searchSequenceId);
+
+    // NOTE: is it possible (very likely) that address is any local address ::ffff:0.0.0.0
+    encodeAsIPv6Address(buffer, _context->getServerInetAddress());
+    buffer->putShort((int16)_context->getServerPort());
+
+    SerializeHelper::serializeString(ServerSearchHandler::SUPPORTED_PROTOCOL, buffer, control);
+
+    const size_t n = std::min(_cids.size(), _maxCIDs);
+
+    control->ensureBuffer(1+2);
+    buffer->putByte((int8)1);
+
+    buffer->putShort((int16)n);
+    for (size_t i = 0; i < n; i++) {
+        control->ensureBuffer(4);
+        buffer->putInt(_cids[i]);
+    }
+    _cids.erase(_cids.begin(), _cids.begin()+n);
+
+    control->setRecipient(_sendTo);
+
+    _queued = false;
+    if (_tcpTransport && !_cids.empty()) {
+        _queued = true;
+        _tcpTransport->enqueueSendRequest(shared_from_this());
+    }
+}
+
 ServerChannelFindRequesterImpl::ServerChannelFindRequesterImpl(ServerContextImpl::shared_pointer const & context, const PeerInfo::const_shared_pointer &peer,
-        int32 expectedResponseCount) :
+        int32 expectedResponseCount, ServerSearchResponseBatch::shared_pointer const & batch) :
     _guid(context->getGUID()),
     _sendTo(),
     _wasFound(false),
@@ -392,7 +525,8 @@ ServerChannelFindRequesterImpl::ServerChannelFindRequesterImpl(ServerContextImpl
     _peer(peer),
     _expectedResponseCount(expectedResponseCount),
     _responseCount(0),
-    _serverSearch(false)
+    _serverSearch(false),
+    _batch(batch)
 {}
 
 void ServerChannelFindRequesterImpl::clear()
@@ -456,6 +590,12 @@ void ServerChannelFindRequesterImpl::channelFindResult(const Status& /*status*/,
         }
         _wasFound = wasFound;
 
+        if (wasFound && _batch)
+        {
+            _batch->add(_cid);
+            return;
+        }
+
         BlockingUDPTransport::shared_pointer bt = _context->getBroadcastTransport();
         if (bt)
         {
@@ -1993,19 +2133,32 @@ void ServerMonitorRequesterImpl::send(ByteBuffer* buffer, TransportSendControl*
 
         // TODO asCheck ?
 
-        bool busy = false;
-        if(_pipeline) {
-            Lock guard(_mutex);
-            busy = _window_open==0;
-        }
+        // Send up to maxBatch updates in this turn, each as a separate message.
+        // Other subscriptions get their turn when we re-queue, so fairness is kept.
+        const size_t maxBatch = _context->getMonitorBatchSize();
+        size_t nsent = 0u;
 
-        MonitorElement::Ref element;
-        if(!busy) {
-            MonitorElement::Ref E(monitor);
-            E.swap(element);
-        }
-        if (element)
+        while(nsent < maxBatch)
         {
+            bool busy = false;
+            if(_pipeline) {
+                Lock guard(_mutex);
+                busy = _window_open==0;
+            }
+
+            MonitorElement::Ref element;
+            if(!busy) {
+                MonitorElement::Ref E(monitor);
+                E.swap(element);
+            }
+            if (!element)
+                break;
+
+            if(nsent)
+                control->endMessage();
+
+            const size_t startPos = buffer->getPosition();
+
             control->startMessage((int8)CMD_MONITOR, sizeof(int32)/sizeof(int8) + 1);
             buffer->putInt(_ioid);
             buffer->putByte((int8)request);
@@ -2038,8 +2191,17 @@ void ServerMonitorRequesterImpl::send(ByteBuffer* buffer, TransportSendControl*
 
             element.reset(); // calls Monitor::release() if not swap()'d
 
-            // TODO if we try to proces several monitors at once, then fairness suffers
-            // TODO compbine several monitors into one message (reduces payload)
+            nsent++;
+
+            // Stop when the buffer was flushed, or when another update
+            // of the same size would not fit without flushing.
+            const size_t endPos = buffer->getPosition();
+            if(endPos <= startPos || buffer->getRemaining() < endPos - startPos)
+                break;
+        }
+
+        if (nsent)
+        {
             TransportSender::shared_pointer thisSender = shared_from_this();
             _transport->enqueueSendRequest(thisSender);
         }
@@ -3,8 +3,13 @@
  * found in the file LICENSE that is included with the distribution
  */
 
+#include <algorithm>
+#include <list>
+
 #include <epicsMutex.h>
 #include <epicsGuard.h>
+#include <epicsTime.h>
+#include <epicsAssert.h>
 
 #include <pv/sharedPtr.h>
 #include <pv/sharedVector.h>
@@ -37,11 +42,47 @@ struct StaticProvider::Impl : public pva::ChannelProvider
     pva::ChannelFind::shared_pointer finder; // const after ctor
     std::tr1::weak_ptr<Impl> internal_self, external_self; // const after ctor
 
-    mutable epicsMutex mutex;
-
     typedef StaticProvider::builders_t builders_t;
+
+    // guards 'builders', which is the complete (ordered) list for iteration.
+    // Taken before any shard mutex.
+    mutable epicsMutex mutex;
     builders_t builders;
 
+    struct nameLess {
+        bool operator()(const std::string* lhs, const std::string* rhs) const
+        { return *lhs < *rhs; }
+    };
+
+    // Searches and channel creation look up names in one of several shards,
+    // so do not contend with each other, or with add()/remove(), unless they
+    // hit the same shard.  Shards point to the entries of 'builders'.
+    // An entry is removed from its shard before it is erased from 'builders'.
+    enum {numShards = 64};
+    struct Shard {
+        typedef std::map<const std::string*, const builders_t::value_type*, nameLess> index_t;
+        mutable epicsMutex mutex;
+        index_t index;
+    };
+    Shard shards[numShards];
+
+    static size_t shardOf(const std::string& name) {
+        // FNV-1a
+        epicsUInt32 hash = 2166136261u;
+        for(size_t i=0, N=name.size(); i<N; i++) {
+            hash ^= epicsUInt8(name[i]);
+            hash *= 16777619u;
+        }
+        return hash%numShards;
+    }
+
+    builders_t::mapped_type lookup(const std::string& name) const {
+        const Shard& shard = shards[shardOf(name)];
+        Guard G(shard.mutex);
+        Shard::index_t::const_iterator it(shard.index.find(&name));
+        return it!=shard.index.end() ? it->second->second : builders_t::mapped_type();
+    }
+
     Impl(const std::string& name)
         :name(name)
     {
@@ -57,13 +98,7 @@ struct StaticProvider::Impl : public pva::ChannelProvider
     virtual pva::ChannelFind::shared_pointer channelFind(std::string const & name,
                                                          pva::ChannelFindRequester::shared_pointer const & requester) OVERRIDE FINAL
     {
-        bool found;
-
-        {
-            Guard G(mutex);
-
-            found =  builders.find(name)!=builders.end();
-        }
+        bool found = !!lookup(name);
         requester->channelFindResult(pvd::Status(), finder, found);
         return finder;
     }
@@ -87,14 +122,7 @@ struct StaticProvider::Impl : public pva::ChannelProvider
         pva::Channel::shared_pointer ret;
         pvd::Status sts;
 
-        builders_t::mapped_type builder;
-        {
-            Guard G(mutex);
-            builders_t::const_iterator it(builders.find(name));
-            if(it!=builders.end()) {
-                builder = it->second;
-            }
-        }
+        builders_t::mapped_type builder(lookup(name));
         if(builder)
             ret = builder->connect(Impl::shared_pointer(internal_self), name, requester);
 
@@ -130,6 +158,10 @@ void StaticProvider::close(bool destroy)
     {
         Guard G(impl->mutex);
         if(destroy) {
+            for(size_t i=0; i<Impl::numShards; i++) {
+                Guard G2(impl->shards[i].mutex);
+                impl->shards[i].index.clear();
+            }
             pvs.swap(impl->builders); // consume
         } else {
             pvs = impl->builders; // just copy, close() is a relatively rare action
@@ -149,9 +181,67 @@ void StaticProvider::add(const std::string& name,
          const std::tr1::shared_ptr<ChannelBuilder>& builder)
 {
     Guard G(impl->mutex);
-    if(impl->builders.find(name)!=impl->builders.end())
+    std::pair<Impl::builders_t::iterator, bool> ins(impl->builders.insert(std::make_pair(name, builder)));
+    if(!ins.second)
         throw std::logic_error("Duplicate PV name");
-    impl->builders[name] = builder;
+
+    Impl::Shard& shard = impl->shards[Impl::shardOf(name)];
+    Guard G2(shard.mutex);
+    shard.index[&ins.first->first] = &*ins.first;
+}
+
+namespace {
+struct nameLess {
+    bool operator()(const StaticProvider::builder_list_t::value_type& lhs,
+                    const StaticProvider::builder_list_t::value_type& rhs) const
+    { return lhs.first < rhs.first; }
+};
+}
+
+void StaticProvider::add(const builder_list_t& pvs)
+{
+    // sorted, so that each insert is next to the previous
+    builder_list_t sorted(pvs);
+    std::sort(sorted.begin(), sorted.end(), nameLess());
+
+    // indicies into 'added' by shard
+    std::vector<std::vector<size_t> > byShard(Impl::numShards);
+
+    Guard G(impl->mutex);
+
+    std::vector<Impl::builders_t::iterator> added;
+    added.reserve(sorted.size());
+
+    // insert just before the next larger name.  Constant time when appending.
+    Impl::builders_t::iterator hint(sorted.empty() ? impl->builders.end()
+                                                   : impl->builders.lower_bound(sorted.front().first));
+    for(size_t i=0; i<sorted.size(); i++) {
+        const size_t before = impl->builders.size();
+        Impl::builders_t::iterator it(impl->builders.insert(hint, sorted[i]));
+        if(impl->builders.size()==before) {
+            // un-do
+            for(size_t n=0; n<added.size(); n++)
+                impl->builders.erase(added[n]);
+            throw std::logic_error("Duplicate PV name");
+        }
+        added.push_back(it);
+        hint = ++it;
+        byShard[Impl::shardOf(sorted[i].first)].push_back(i);
+    }
+
+    for(size_t s=0; s<Impl::numShards; s++) {
+        const std::vector<size_t>& idx = byShard[s];
+        if(idx.empty())
+            continue;
+        Impl::Shard& shard = impl->shards[s];
+        Guard G2(shard.mutex);
+        Impl::Shard::index_t::iterator shint(shard.index.lower_bound(&added[idx.front()]->first));
+        for(size_t n=0; n<idx.size(); n++) {
+            const Impl::builders_t::value_type& ent = *added[idx[n]];
+            shint = shard.index.insert(shint, std::make_pair(&ent.first, &ent));
+            ++shint;
+        }
+    }
 }
 
 std::tr1::shared_ptr<StaticProvider::ChannelBuilder> StaticProvider::remove(const std::string& name)
@@ -162,6 +252,11 @@ std::tr1::shared_ptr<StaticProvider::ChannelBuilder> StaticProvider::remove(cons
         Impl::builders_t::iterator it(impl->builders.find(name));
         if(it!=impl->builders.end()) {
             ret = it->second;
+            {
+                Impl::Shard& shard = impl->shards[Impl::shardOf(name)];
+                Guard G2(shard.mutex);
+                shard.index.erase(&it->first);
+            }
             impl->builders.erase(it);
         }
     }
@@ -170,6 +265,49 @@ std::tr1::shared_ptr<StaticProvider::ChannelBuilder> StaticProvider::remove(cons
     return ret;
 }
 
+void StaticProvider::remove(const std::vector<std::string>& names)
+{
+    builder_list_t removed;
+    removed.reserve(names.size());
+    {
+        std::vector<std::vector<size_t> > byShard(Impl::numShards);
+        std::vector<Impl::builders_t::iterator> found;
+        found.reserve(names.size());
+        // false for a name repeated in 'names'
+        std::vector<bool> unique;
+
+        Guard G(impl->mutex);
+
+        for(size_t i=0; i<names.size(); i++) {
+            Impl::builders_t::iterator it(impl->builders.find(names[i]));
+            if(it==impl->builders.end())
+                continue;
+            byShard[Impl::shardOf(it->first)].push_back(found.size());
+            found.push_back(it);
+        }
+        unique.resize(found.size(), false);
+
+        for(size_t s=0; s<Impl::numShards; s++) {
+            const std::vector<size_t>& idx = byShard[s];
+            if(idx.empty())
+                continue;
+            Impl::Shard& shard = impl->shards[s];
+            Guard G2(shard.mutex);
+            for(size_t n=0; n<idx.size(); n++)
+                unique[idx[n]] = shard.index.erase(&found[idx[n]]->first)!=0u;
+        }
+
+        for(size_t i=0; i<found.size(); i++) {
+            if(!unique[i])
+                continue;
+            removed.push_back(*found[i]);
+            impl->builders.erase(found[i]);
+        }
+    }
+    for(size_t i=0; i<removed.size(); i++)
+        removed[i].second->disconnect(true, impl.get());
+}
+
 StaticProvider::builders_t::const_iterator StaticProvider::begin() const {
     Guard G(impl->mutex);
     return impl->builders.begin();
@@ -192,12 +330,48 @@ struct DynamicProvider::Impl : public pva::ChannelProvider
     pva::ChannelFind::shared_pointer finder; // const after ctor
     std::tr1::weak_ptr<Impl> internal_self, external_self; // const after ctor
 
+    const CacheConfig cacheConf;
+
+    // guards cache and stats
     mutable epicsMutex mutex;
 
+    // names in order of last search, oldest first
+    typedef std::list<std::string> order_t;
+    struct CacheEntry {
+        epicsTimeStamp expires;
+        bool found;
+        order_t::iterator pos;
+    };
+    typedef std::map<std::string, CacheEntry> cache_t;
+    cache_t cache;
+    order_t order;
+    size_t hits, misses;
+    // A search result is only stored if no invalidate() of all names,
+    // or of the name searched, happened while the Handler was searching.
+    // incremented by invalidate()
+    size_t generation;
+    // names being searched for by the Handler
+    struct Pending {
+        size_t searches;   // concurrent searches of this name
+        size_t generation; // incremented by invalidate(name)
+        Pending() :searches(0u), generation(0u) {}
+    };
+    typedef std::map<std::string, Pending> pending_t;
+    pending_t pending;
+    // taken by cacheLookup() for cacheStore()
+    struct Ticket {
+        size_t generation, pending;
+    };
+
     Impl(const std::string& name,
-         const std::tr1::shared_ptr<Handler>& handler)
+         const std::tr1::shared_ptr<Handler>& handler,
+         const CacheConfig& cacheConf)
         :name(name)
         ,handler(handler)
+        ,cacheConf(cacheConf)
+        ,hits(0u)
+        ,misses(0u)
+        ,generation(0u)
     {
         REFTRACE_INCREMENT(num_instances);
     }
@@ -214,18 +388,87 @@ struct DynamicProvider::Impl : public pva::ChannelProvider
                                                          pva::ChannelFindRequester::shared_pointer const & requester) OVERRIDE FINAL
     {
         bool found = false;
+        Ticket ticket;
+        if(!cacheLookup(name, found, ticket))
         {
             pva::PeerInfo::const_shared_pointer info(requester->getPeerInfo());
             search_type search;
             search.push_back(DynamicProvider::Search(name, info ? info.get() : 0));
 
-            handler->hasChannels(search);
+            try {
+                handler->hasChannels(search);
+            } catch(...) {
+                cacheStore(name, false, ticket, false);
+                throw;
+            }
 
             found = !search.empty() && search[0].name()==name && search[0].claimed();
+
+            cacheStore(name, found, ticket);
         }
         requester->channelFindResult(pvd::Status(), finder, found);
         return finder;
     }
+
+    // @returns true if a cached result was found.  Otherwise cacheStore() must be called with 'ticket'
+    bool cacheLookup(const std::string& name, bool& found, Ticket& ticket)
+    {
+        if(!cacheConf.maxEntries)
+            return false;
+
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
+
+        Guard G(mutex);
+        cache_t::iterator it(cache.find(name));
+        if(it!=cache.end() && epicsTimeLessThan(&now, &it->second.expires)) {
+            found = it->second.found;
+            order.splice(order.end(), order, it->second.pos);
+            hits++;
+            return true;
+        }
+        misses++;
+        Pending& pend = pending[name];
+        pend.searches++;
+        ticket.generation = generation;
+        ticket.pending = pend.generation;
+        return false;
+    }
+
+    // with store=false, only ends the search
+    void cacheStore(const std::string& name, bool found, const Ticket& ticket, bool store = true)
+    {
+        if(!cacheConf.maxEntries)
+            return;
+
+        epicsTimeStamp expires;
+        epicsTimeGetCurrent(&expires);
+        epicsTimeAddSeconds(&expires, found ? cacheConf.positiveTTL : cacheConf.negativeTTL);
+
+        Guard G(mutex);
+        pending_t::iterator pit(pending.find(name));
+        assert(pit!=pending.end());
+        const bool stale = ticket.generation!=generation || ticket.pending!=pit->second.generation;
+        if(--pit->second.searches==0u)
+            pending.erase(pit);
+        if(!store || stale)
+            return; // result may be stale
+
+        cache_t::iterator it(cache.find(name));
+        if(it==cache.end()) {
+            while(cache.size()>=cacheConf.maxEntries) {
+                cache.erase(order.front());
+                order.pop_front();
+            }
+            CacheEntry& ent = cache[name];
+            ent.pos = order.insert(order.end(), name);
+            it = cache.find(name);
+        } else {
+            order.splice(order.end(), order, it->second.pos);
+        }
+        it->second.expires = expires;
+        it->second.found = found;
+    }
     virtual pva::ChannelFind::shared_pointer channelList(pva::ChannelListRequester::shared_pointer const & requester) OVERRIDE FINAL
     {
         epics::pvData::PVStringArray::svector names;
@@ -254,8 +497,9 @@ struct DynamicProvider::Impl : public pva::ChannelProvider
 size_t DynamicProvider::Impl::num_instances;
 
 DynamicProvider::DynamicProvider(const std::string &name,
-                                 const std::tr1::shared_ptr<Handler> &handler)
-    :impl(new Impl(name, handler))
+                                 const std::tr1::shared_ptr<Handler> &handler,
+                                 const CacheConfig& cache)
+    :impl(new Impl(name, handler, cache))
 {
     impl->internal_self = impl;
     impl->finder = pva::ChannelFind::buildDummy(impl);
@@ -271,6 +515,37 @@ DynamicProvider::Handler::shared_pointer DynamicProvider::getHandler() const
     return impl->handler;
 }
 
+void DynamicProvider::invalidate()
+{
+    Guard G(impl->mutex);
+    impl->generation++;
+    impl->cache.clear();
+    impl->order.clear();
+}
+
+void DynamicProvider::invalidate(const std::string& name)
+{
+    Guard G(impl->mutex);
+    Impl::pending_t::iterator pit(impl->pending.find(name));
+    if(pit!=impl->pending.end())
+        pit->second.generation++;
+    Impl::cache_t::iterator it(impl->cache.find(name));
+    if(it!=impl->cache.end()) {
+        impl->order.erase(it->second.pos);
+        impl->cache.erase(it);
+    }
+}
+
+DynamicProvider::CacheStats DynamicProvider::cacheStats() const
+{
+    CacheStats ret;
+    Guard G(impl->mutex);
+    ret.hits = impl->hits;
+    ret.misses = impl->misses;
+    ret.entries = impl->cache.size();
+    return ret;
+}
+
 std::tr1::shared_ptr<epics::pvAccess::ChannelProvider> DynamicProvider::provider() const
 {
     return Impl::shared_pointer(impl->internal_self);
@@ -39,9 +39,12 @@ ServerContextImpl::ServerContextImpl():
     _broadcastPort(PVA_BROADCAST_PORT),
     _serverPort(PVA_SERVER_PORT),
     _receiveBufferSize(MAX_TCP_RECV),
+    _ioThreads(0),
+    _monitorBatchSize(1),
     _timer(new Timer("PVAS timers", lowerPriority)),
     _beaconEmitter(),
     _acceptor(),
+    _localAcceptor(),
     _transportRegistry(),
     _channelProviders(),
     _beaconServerStatusProvider(),
@@ -146,6 +149,36 @@ void ServerContextImpl::loadConfiguration()
     _receiveBufferSize = config->getPropertyAsInteger("EPICS_PVA_MAX_ARRAY_BYTES", _receiveBufferSize);
     _receiveBufferSize = config->getPropertyAsInteger("EPICS_PVAS_MAX_ARRAY_BYTES", _receiveBufferSize);
 
+    _ioThreads = config->getPropertyAsInteger("EPICS_PVA_IO_THREADS", _ioThreads);
+    _ioThreads = config->getPropertyAsInteger("EPICS_PVAS_IO_THREADS", _ioThreads);
+    if(_ioThreads<0)
+        _ioThreads = 0;
+    if(_ioThreads>0 && !TransportReactor::isSupported()) {
+        LOG(logLevelWarn, "EPICS_PVAS_IO_THREADS not supported on this target.  Using thread per connection.");
+        _ioThreads = 0;
+    }
+
+    _monitorBatchSize = config->getPropertyAsInteger("EPICS_PVA_MONITOR_BATCH", _monitorBatchSize);
+    _monitorBatchSize = config->getPropertyAsInteger("EPICS_PVAS_MONITOR_BATCH", _monitorBatchSize);
+    if(_monitorBatchSize<1)
+        _monitorBatchSize = 1;
+
+    {
+        int32 threads = config->getPropertyAsInteger("EPICS_PVAS_ACCEPT_THREADS", _acceptorConfig.threads);
+        _acceptorConfig.threads = threads<1 ? 1u : unsigned(threads);
+    }
+    _acceptorConfig.backlog = config->getPropertyAsInteger("EPICS_PVAS_LISTEN_BACKLOG", _acceptorConfig.backlog);
+    if(_acceptorConfig.backlog<1)
+        _acceptorConfig.backlog = 1;
+    _acceptorConfig.rate = config->getPropertyAsDouble("EPICS_PVAS_ACCEPT_RATE", _acceptorConfig.rate);
+    {
+        int32 burst = config->getPropertyAsInteger("EPICS_PVAS_ACCEPT_BURST", _acceptorConfig.burst);
+        _acceptorConfig.burst = burst<1 ? 1u : unsigned(burst);
+    }
+
+    _unixDir = config->getPropertyAsString("EPICS_PVA_UNIX_DIR", _unixDir);
+    _unixDir = config->getPropertyAsString("EPICS_PVAS_UNIX_DIR", _unixDir);
+
     if(_channelProviders.empty()) {
         std::string providers = config->getPropertyAsString("EPICS_PVAS_PROVIDER_NAMES", PVACCESS_DEFAULT_PROVIDER);
 
@@ -251,6 +284,18 @@ ServerContextImpl::getCurrentConfig()
 
     SET("EPICS_PVAS_PROVIDER_NAMES", providerName.str());
 
+    SET("EPICS_PVAS_IO_THREADS", _ioThreads);
+
+    SET("EPICS_PVAS_MONITOR_BATCH", getMonitorBatchSize());
+
+    SET("EPICS_PVAS_ACCEPT_THREADS", _acceptorConfig.threads);
+    SET("EPICS_PVAS_LISTEN_BACKLOG", _acceptorConfig.backlog);
+    SET("EPICS_PVAS_ACCEPT_RATE", _acceptorConfig.rate);
+    SET("EPICS_PVAS_ACCEPT_BURST", _acceptorConfig.burst);
+
+    SET("EPICS_PVAS_UNIX_DIR", _unixDir);
+    SET("EPICS_PVA_UNIX_DIR", _unixDir);
+
 #undef SET
 
     return B.push_map().build();
@@ -273,9 +318,24 @@ void ServerContextImpl::initialize()
     // we create reference cycles here which are broken by our shutdown() method,
     _responseHandler.reset(new ServerResponseHandler(thisServerContext));
 
-    _acceptor.reset(new BlockingTCPAcceptor(thisServerContext, _responseHandler, _ifaceAddr, _receiveBufferSize));
+    if(_ioThreads>0)
+        _reactor.reset(new TransportReactor(_ioThreads, "PVAS-io"));
+
+    _acceptor.reset(new BlockingTCPAcceptor(thisServerContext, _responseHandler, _ifaceAddr, _receiveBufferSize,
+                                            _acceptorConfig));
     _serverPort = ntohs(_acceptor->getBindAddress()->ia.sin_port);
 
+    if(!_unixDir.empty()) {
+        // clients on this host find the local socket by our TCP address and port
+        try {
+            _localAcceptor.reset(new BlockingTCPAcceptor(thisServerContext, _responseHandler,
+                                                         localSocketPath(_unixDir, *_acceptor->getBindAddress()),
+                                                         _receiveBufferSize, _acceptorConfig));
+        } catch(std::exception& e) {
+            LOG(logLevelWarn, "Not accepting local connections: %s", e.what());
+        }
+    }
+
     // setup broadcast UDP transport
     initializeUDPTransports(true, _udpTransports, _ifaceList, _responseHandler, _broadcastTransport,
                             _broadcastPort, _autoBeaconAddressList, _beaconAddressList, _ignoreAddressList);
@@ -345,6 +405,16 @@ void ServerContextImpl::shutdown()
         LEAK_CHECK(_acceptor, "_acceptor")
         _acceptor.reset();
     }
+    if (_localAcceptor)
+    {
+        _localAcceptor->destroy();
+        LEAK_CHECK(_localAcceptor, "_localAcceptor")
+        _localAcceptor.reset();
+    }
+
+    // join shared I/O threads.  Connections are closed below.
+    if (_reactor)
+        _reactor->close();
 
     // this will also destroy all channels
     _transportRegistry.clear();
@@ -382,6 +452,13 @@ void ServerContextImpl::printInfo(ostream& str, int lvl)
         SHOW(EPICS_PVAS_BROADCAST_PORT)
         SHOW(EPICS_PVAS_SERVER_PORT)
         SHOW(EPICS_PVAS_PROVIDER_NAMES)
+        SHOW(EPICS_PVAS_IO_THREADS)
+        SHOW(EPICS_PVAS_MONITOR_BATCH)
+        SHOW(EPICS_PVAS_ACCEPT_THREADS)
+        SHOW(EPICS_PVAS_LISTEN_BACKLOG)
+        SHOW(EPICS_PVAS_ACCEPT_RATE)
+        SHOW(EPICS_PVAS_ACCEPT_BURST)
+        SHOW(EPICS_PVAS_UNIX_DIR)
 #undef SHOW
 
     } else {
@@ -475,6 +552,11 @@ int32 ServerContextImpl::getReceiveBufferSize()
     return _receiveBufferSize;
 }
 
+int32 ServerContextImpl::getMonitorBatchSize()
+{
+    return _monitorBatchSize;
+}
+
 int32 ServerContextImpl::getServerPort()
 {
     return _serverPort;
@@ -519,6 +601,11 @@ epics::pvAccess::TransportRegistry* ServerContextImpl::getTransportRegistry()
     return &_transportRegistry;
 }
 
+TransportReactor::shared_pointer ServerContextImpl::getTransportReactor()
+{
+    return _reactor;
+}
+
 Channel::shared_pointer ServerContextImpl::getChannel(pvAccessID /*id*/)
 {
     // not used
@@ -342,9 +342,17 @@ void SharedPV::post(const pvd::PVStructure& value,
         else if(*type!=*value.getStructure())
             throw std::logic_error("Type mis-match");
 
+        // With several subscribers, make one light-weight copy (arrays are shared)
+        // of the complete value, which subscribers requesting all fields will reference
+        // instead of each copying from 'value'.
+        pvd::PVStructure::const_shared_pointer snapshot;
+
         if(current) {
             current->copyUnchecked(value, changed);
             valid |= changed;
+
+            if(monitors.size()>1u)
+                snapshot = pvd::getPVDataCreate()->createPVStructure(current);
         }
 
         p_monitor.reserve(monitors.size()); // ick, for lack of a list with thread-safe iteration
@@ -356,7 +364,10 @@ void SharedPV::post(const pvd::PVStructure& value,
             }catch(std::tr1::bad_weak_ptr&) {
                 continue; //racing destruction
             }
-            (*it)->post(value, changed);
+            if(snapshot)
+                (*it)->post(snapshot, changed);
+            else
+                (*it)->post(value, changed);
             p_monitor.push_back(self);
         }
     }
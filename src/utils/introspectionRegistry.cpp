@@ -34,13 +34,23 @@ void IntrospectionRegistry::reset()
 {
     _pointer = 1;
     _registry.clear();
+    _byPointer.clear();
+    _byHash.clear();
 }
 
 int16 IntrospectionRegistry::registerIntrospectionInterface(FieldConstPtr const & field, bool& existing)
 {
+    // fast path.  FieldCreate usually returns the same instance for equal types
+    registryPointerIndex_t::const_iterator it(_byPointer.find(field.get()));
+    if(it != _byPointer.end())
+    {
+        existing = true;
+        return it->second;
+    }
+
     int16 key;
-    // TODO this is slow
-    if(registryContainsValue(field, key))
+    const size_t fieldHash = hash(*field);
+    if(registryContainsValue(field, fieldHash, key))
     {
         existing = true;
     }
@@ -48,25 +58,122 @@ int16 IntrospectionRegistry::registerIntrospectionInterface(FieldConstPtr const
     {
         existing = false;
         key = _pointer++;
+
+        registryMap_t::iterator prev(_registry.find(key));
+        if(prev != _registry.end())
+        {
+            // key wrapped around, forget the old interface
+            _byPointer.erase(prev->second.get());
+            std::pair<registryHashIndex_t::iterator, registryHashIndex_t::iterator> range(_byHash.equal_range(hash(*prev->second)));
+            for(; range.first != range.second; ++range.first)
+            {
+                if(range.first->second == key)
+                {
+                    _byHash.erase(range.first);
+                    break;
+                }
+            }
+        }
+
         _registry[key] = field;
+        // _registry keeps field alive, so its address will not be reused
+        _byPointer[field.get()] = key;
+        _byHash.insert(std::make_pair(fieldHash, key));
     }
     return key;
 }
 
-// TODO slow !!!!
-bool IntrospectionRegistry::registryContainsValue(FieldConstPtr const & field, int16& key)
+bool IntrospectionRegistry::registryContainsValue(FieldConstPtr const & field, size_t fieldHash, int16& key)
 {
-    for(registryMap_t::reverse_iterator registryRIter = _registry.rbegin(); registryRIter != _registry.rend(); registryRIter++)
+    // hash collisions are resolved by full comparison
+    std::pair<registryHashIndex_t::const_iterator, registryHashIndex_t::const_iterator> range(_byHash.equal_range(fieldHash));
+    for(; range.first != range.second; ++range.first)
     {
-        if(*(field.get()) == *(registryRIter->second))
+        registryMap_t::const_iterator registryIter(_registry.find(range.first->second));
+        if(registryIter != _registry.end() && *field == *registryIter->second)
         {
-            key = registryRIter->first;
+            key = registryIter->first;
             return true;
         }
     }
     return false;
 }
 
+namespace {
+// FNV-1a
+struct Hasher {
+    size_t value;
+    Hasher() :value(2166136261u) {}
+    void add(const char *bytes, size_t count)
+    {
+        for(size_t i=0; i<count; i++)
+        {
+            value ^= (unsigned char)bytes[i];
+            value *= 16777619u;
+        }
+    }
+    void add(const std::string& str)
+    {
+        add(str.c_str(), str.size()+1); // include nil as separator
+    }
+    void add(size_t v)
+    {
+        add((const char*)&v, sizeof(v));
+    }
+};
+
+// only mixes in what operator==(Field,Field) compares.
+// eg. not the bound of a string or array.
+void hashField(Hasher& H, const Field& field)
+{
+    H.add(size_t(field.getType()));
+
+    switch(field.getType())
+    {
+    case scalar:
+        H.add(size_t(static_cast<const Scalar&>(field).getScalarType()));
+        break;
+    case scalarArray:
+        H.add(size_t(static_cast<const ScalarArray&>(field).getElementType()));
+        break;
+    case structure:
+    case union_:
+    {
+        H.add(field.getID());
+
+        const StringArray& names = field.getType()==structure ?
+                    static_cast<const Structure&>(field).getFieldNames() :
+                    static_cast<const Union&>(field).getFieldNames();
+        const FieldConstPtrArray& fields = field.getType()==structure ?
+                    static_cast<const Structure&>(field).getFields() :
+                    static_cast<const Union&>(field).getFields();
+        H.add(names.size());
+        for(size_t i=0; i<names.size(); i++)
+        {
+            H.add(names[i]);
+            hashField(H, *fields[i]);
+        }
+    }
+        break;
+    case structureArray:
+        hashField(H, *static_cast<const StructureArray&>(field).getStructure());
+        break;
+    case unionArray:
+        hashField(H, *static_cast<const UnionArray&>(field).getUnion());
+        break;
+    default:
+        break;
+    }
+}
+} // namespace
+
+size_t IntrospectionRegistry::hash(const Field& field)
+{
+    Hasher H;
+    hashField(H, field);
+    return H.value;
+}
+
 void IntrospectionRegistry::serialize(FieldConstPtr const & field, ByteBuffer* buffer, SerializableControl* control)
 {
     if (field.get() == NULL)
@@ -17,6 +17,7 @@
 #include <epicsEvent.h>
 #include <epicsMutex.h>
 #include <epicsGuard.h>
+#include <epicsAtomic.h>
 #include <ellLib.h>
 #include <dbDefs.h>
 
@@ -212,6 +213,243 @@ private:
     mutable epicsEvent wakeup;
 };
 
+/** @brief fair_queue with lock-free push_back()
+ *
+ * Same intrusive, loss-less, un-bounded, round-robin semantics as fair_queue<T>.
+ * The parameterized type 'T' must be a sub-class of @class fair_queue_mpsc<T>::entry
+ *
+ * push_back() does not lock.  An entry being added for the first time is placed
+ * on a lock-free "inbox" stack, which the consumer moves (in order) onto the
+ * round-robin list.  The consumer side (pop_front*() and clear()) is serialized by
+ * a mutex which producers never take, so is only contended by clear().
+ *
+ * The consumer is woken only when it is waiting in pop_front() and
+ * the queue becomes non-empty.
+ *
+ * @warning Only one thread should call pop_front()
+ */
+template<typename T>
+class fair_queue_mpsc
+{
+    typedef epicsGuard<epicsMutex> guard_t;
+public:
+    typedef std::tr1::shared_ptr<T> value_type;
+
+    class entry {
+        // see fair_queue::entry
+        struct enode_t {
+            ELLNODE node;
+            entry *self;
+        } enode;
+        // next in inbox stack.
+        entry *inboxNext;
+        // number of times queued.  Only the 0 -> 1 transition adds to the inbox.
+        int Qcnt;
+        // set by producer on 0 -> 1, cleared by consumer before 1 -> 0
+        value_type holder;
+
+        friend class fair_queue_mpsc;
+
+        entry(const entry&);
+        entry& operator=(const entry&);
+    public:
+        entry() :inboxNext(NULL), Qcnt(0), holder()
+        {
+            enode.node.next = enode.node.previous = NULL;
+            enode.self = this;
+        }
+        ~entry() {
+            // nodes should be removed from the list before deletion
+            assert(!enode.node.next && !enode.node.previous);
+            assert(Qcnt==0 && !holder);
+        }
+    };
+
+    fair_queue_mpsc()
+        :inbox(NULL)
+        ,waiting(0)
+    {
+        ellInit(&list);
+    }
+    ~fair_queue_mpsc()
+    {
+        clear();
+        assert(ellCount(&list)==0);
+    }
+
+    //! Remove all items.
+    //! @post empty()==true, unless concurrent push_back()
+    void clear()
+    {
+        // destroy after unlock
+        std::vector<value_type> garbage;
+        {
+            guard_t G(mutex);
+
+            drain();
+
+            garbage.reserve(unsigned(ellCount(&list)));
+
+            while(ELLNODE *cur = ellGet(&list)) {
+                typedef typename entry::enode_t enode_t;
+                enode_t *PN = CONTAINER(cur, enode_t, node);
+                entry *P = PN->self;
+                PN->node.previous = PN->node.next = NULL;
+
+                value_type ref(P->holder);
+                while(true) {
+                    int cnt = epics::atomic::get(P->Qcnt);
+                    assert(cnt>0);
+                    P->holder.reset();
+                    if(epics::atomic::compareAndSwap(P->Qcnt, cnt, 0)==cnt)
+                        break;
+                    // concurrent push_back(), retry
+                    P->holder = ref;
+                }
+                garbage.push_back(ref);
+            }
+        }
+    }
+
+    bool empty() const {
+        guard_t G(mutex);
+        return ellFirst(&list)==NULL && epics::atomic::get(inbox)==NULL;
+    }
+
+    void push_back(const value_type& ent)
+    {
+        entry *P = ent.get();
+
+        if(epics::atomic::increment(P->Qcnt)==1) {
+            // not queued.  we own P->holder and P->inboxNext until P is in the inbox.
+            P->holder = ent;
+
+            EpicsAtomicPtrT head;
+            do {
+                head = epics::atomic::get(inbox);
+                P->inboxNext = static_cast<entry*>(head);
+            } while(epics::atomic::compareAndSwap(inbox, head, static_cast<EpicsAtomicPtrT>(P))!=head);
+        }
+
+        if(epics::atomic::get(waiting) && epics::atomic::compareAndSwap(waiting, 1, 0)==1)
+            wakeup.signal();
+    }
+
+    bool pop_front_try(value_type& ret)
+    {
+        ret.reset();
+        guard_t G(mutex);
+
+        drain();
+
+        ELLNODE *cur = ellGet(&list); // pop_front
+
+        if(!cur)
+            return false;
+
+        typedef typename entry::enode_t enode_t;
+        enode_t *PN = CONTAINER(cur, enode_t, node);
+        entry *P = PN->self;
+        PN->node.previous = PN->node.next = NULL;
+
+        // P->holder is stable while P->Qcnt>0
+        value_type ref(P->holder);
+        while(true) {
+            int cnt = epics::atomic::get(P->Qcnt);
+            assert(cnt>0);
+            if(cnt==1) {
+                // after 1 -> 0, P->holder belongs to the next push_back()
+                P->holder.reset();
+                if(epics::atomic::compareAndSwap(P->Qcnt, 1, 0)==1)
+                    break;
+                // concurrent push_back(), retry
+                P->holder = ref;
+
+            } else if(epics::atomic::compareAndSwap(P->Qcnt, cnt, cnt-1)==cnt) {
+                ellAdd(&list, &P->enode.node); // push_back
+                break;
+            }
+        }
+
+        ret.swap(ref);
+        return true;
+    }
+
+    void pop_front(value_type& ret)
+    {
+        while(1) {
+            pop_front_try(ret);
+            if(ret)
+                break;
+            if(prepareWait(ret))
+                break;
+            wakeup.wait();
+        }
+    }
+
+    bool pop_front(value_type& ret, double timeout)
+    {
+        while(1) {
+            pop_front_try(ret);
+            if(ret)
+                return true;
+            if(prepareWait(ret))
+                return true;
+            if(!wakeup.wait(timeout)) {
+                epics::atomic::set(waiting, 0);
+                return false;
+            }
+        }
+    }
+
+private:
+    // move inbox to tail of list, oldest first.
+    // call with mutex locked
+    void drain()
+    {
+        EpicsAtomicPtrT head;
+        do {
+            head = epics::atomic::get(inbox);
+        } while(head && epics::atomic::compareAndSwap(inbox, head, EpicsAtomicPtrT(NULL))!=head);
+
+        // inbox is a stack, newest first.  reverse.
+        entry *rev = NULL;
+        for(entry *P = static_cast<entry*>(head); P; ) {
+            entry *next = P->inboxNext;
+            P->inboxNext = rev;
+            rev = P;
+            P = next;
+        }
+
+        for(entry *P = rev; P; ) {
+            entry *next = P->inboxNext;
+            P->inboxNext = NULL;
+            ellAdd(&list, &P->enode.node); // push_back
+            P = next;
+        }
+    }
+
+    // announce that the consumer will wait, and check once more.
+    // returns true (and clears the announcement) if an entry was popped.
+    bool prepareWait(value_type& ret)
+    {
+        epics::atomic::set(waiting, 1);
+        pop_front_try(ret);
+        if(!ret)
+            return false;
+        // if a push_back() already took 'waiting', wakeup is left signaled.
+        // Harmless, next wait() returns immediately.
+        epics::atomic::set(waiting, 0);
+        return true;
+    }
+
+    ELLLIST list;
+    EpicsAtomicPtrT inbox;
+    int waiting;
+    mutable epicsMutex mutex;
+    mutable epicsEvent wakeup;
+};
+
 }
 } // namespace
 
@@ -35,6 +35,8 @@ namespace epics {
 namespace pvAccess {
 
 typedef std::map<const short,epics::pvData::FieldConstPtr> registryMap_t;
+typedef std::map<const epics::pvData::Field*,epics::pvData::int16> registryPointerIndex_t;
+typedef std::multimap<std::size_t,epics::pvData::int16> registryHashIndex_t;
 
 
 /**
@@ -58,7 +60,8 @@ private:
      * Registers introspection interface and get it's ID. Always OUTGOING.
      * If it is already registered only preassigned ID is returned.
      *
-     * TODO !!!!!!this can get very slow in large maps. We need to change this !!!!!!
+     * Lookup is first by pointer, then by structural hash, so the cost does not
+     * grow with the number of registered interfaces.
      *
      * @param field introspection interface to register
      *
@@ -87,6 +90,16 @@ public:
      */
     epics::pvData::FieldConstPtr deserialize(epics::pvData::ByteBuffer* buffer, epics::pvData::DeserializableControl* control);
 
+    //! Number of registered/received introspection interfaces
+    size_t size() const { return _registry.size(); }
+
+    /**
+     * Structural hash of an introspection interface.
+     * Fields which compare equal (Field::operator==) have equal hash.
+     * So only structure/union IDs, field names, and types are included.
+     */
+    static std::size_t hash(epics::pvData::Field const & field);
+
     /**
      * Null type.
      */
@@ -104,6 +117,9 @@ public:
 
 private:
     registryMap_t _registry;
+    // indices of OUTGOING interfaces in _registry
+    registryPointerIndex_t _byPointer;
+    registryHashIndex_t _byHash;
     epics::pvData::int16 _pointer;
 
     /**
@@ -111,7 +127,7 @@ private:
      */
     static epics::pvData::FieldCreatePtr _fieldCreate;
 
-    bool registryContainsValue(epics::pvData::FieldConstPtr const & field, epics::pvData::int16& key);
+    bool registryContainsValue(epics::pvData::FieldConstPtr const & field, std::size_t fieldHash, epics::pvData::int16& key);
 };
 
 }
@@ -0,0 +1,284 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef SLOTTABLE_H
+#define SLOTTABLE_H
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef epicsExportSharedSymbols
+#   define slotTableExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsAtomic.h>
+
+#include <pv/pvType.h>
+
+#ifdef slotTableExportSharedSymbols
+#   define epicsExportSharedSymbols
+#   undef slotTableExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+
+/** @brief A table of values indexed by generated 32-bit keys (eg. CID, IOID, SID)
+ *
+ * Keys are a slot index (low bits) and a generation number (high bits).
+ * The generation is incremented each time a slot is re-used, so a stale key
+ * is not mistaken for the current occupant of its slot.
+ *
+ * @li allocate(), find() and remove() are O(1).
+ *
+ * @li Slots are kept in fixed size chunks which are never moved or freed
+ *     before the table is destroyed.  So find() does not take the table lock,
+ *     only one of several stripe locks which also guard the slot values.
+ *
+ * @li Freed slots are re-used in FIFO order to delay generation wrap around.
+ *
+ * @li Key 0 is never returned.
+ *
+ * The parameterized type 'V' is the value type stored, eg. a shared_ptr or weak_ptr.
+ */
+template<typename V>
+class slot_table
+{
+public:
+    typedef epics::pvData::uint32 key_type;
+    typedef V value_type;
+
+    enum {
+        indexBits = 20,
+        maxSlots = (1u<<indexBits)-1u, // excluding 0xffffffff
+        chunkBits = 10,
+        chunkSize = 1u<<chunkBits,
+        numChunks = (1u<<indexBits)>>chunkBits,
+        numStripes = 16,
+    };
+    static const key_type indexMask = (key_type(1u)<<indexBits)-1u;
+    static const key_type generationMask = ~key_type(0u)>>indexBits;
+
+private:
+    typedef epicsGuard<epicsMutex> Guard;
+
+    struct slot_t {
+        V value;
+        key_type generation;
+        key_type nextFree;
+        bool used;
+        slot_t() :generation(0u), nextFree(0u), used(false) {}
+    };
+
+    // chunk pointers are set once, under 'lock', and read without
+    EpicsAtomicPtrT chunks[numChunks];
+
+    // guards free list, count, and allocation of chunks
+    mutable epicsMutex lock;
+    key_type freeHead, freeTail; // indicies, or maxSlots when free list is empty
+    key_type nextUnused;
+    size_t count;
+
+    mutable epicsMutex stripes[numStripes];
+
+    epicsMutex& stripe(key_type idx) const { return stripes[idx%numStripes]; }
+
+    slot_t* lookup(key_type idx) const {
+        slot_t *chunk = static_cast<slot_t*>(epics::atomic::get(chunks[idx>>chunkBits]));
+        return chunk ? &chunk[idx&(chunkSize-1u)] : 0;
+    }
+
+    // slot for this key, or NULL if the key was never allocated.  Caller must check generation
+    slot_t* lookupKey(key_type key) const {
+        const key_type idx = key&indexMask;
+        return idx<maxSlots ? lookup(idx) : 0;
+    }
+
+    slot_table(const slot_table&);
+    slot_table& operator=(const slot_table&);
+public:
+    slot_table()
+        :freeHead(maxSlots)
+        ,freeTail(maxSlots)
+        ,nextUnused(0u)
+        ,count(0u)
+    {
+        for(size_t i=0; i<numChunks; i++)
+            chunks[i] = 0;
+    }
+
+    ~slot_table()
+    {
+        for(size_t i=0; i<numChunks; i++)
+            delete[] static_cast<slot_t*>(chunks[i]);
+    }
+
+    //! Number of allocated keys
+    size_t size() const {
+        Guard G(lock);
+        return count;
+    }
+
+    /** Reserve a new key, with a default constructed value.
+     * @throws std::runtime_error if all slots are in use.
+     */
+    key_type allocate()
+    {
+        key_type idx;
+        {
+            Guard G(lock);
+            if(freeHead!=maxSlots) {
+                idx = freeHead;
+                freeHead = lookup(idx)->nextFree;
+                if(freeHead==maxSlots)
+                    freeTail = maxSlots;
+
+            } else if(nextUnused<maxSlots) {
+                idx = nextUnused;
+                if((idx&(chunkSize-1u))==0u) {
+                    slot_t *chunk = new slot_t[chunkSize];
+                    epics::atomic::set(chunks[idx>>chunkBits], static_cast<EpicsAtomicPtrT>(chunk));
+                }
+                nextUnused++;
+
+            } else {
+                throw std::runtime_error("slot_table full");
+            }
+            count++;
+        }
+
+        slot_t& S = *lookup(idx);
+        Guard G(stripe(idx));
+        // skip generation zero so that no key is 0
+        S.generation = (S.generation+1u)&generationMask;
+        if(S.generation==0u)
+            S.generation = 1u;
+        S.used = true;
+        return (S.generation<<indexBits) | idx;
+    }
+
+    //! Allocate a key and store a value
+    key_type insert(const V& value)
+    {
+        key_type key = allocate();
+        set(key, value);
+        return key;
+    }
+
+    //! Replace the value of an allocated key.  @returns false if key is not allocated.
+    bool set(key_type key, const V& value)
+    {
+        slot_t *S = lookupKey(key);
+        if(!S)
+            return false;
+        Guard G(stripe(key&indexMask));
+        if(!S->used || S->generation!=key>>indexBits)
+            return false;
+        S->value = value;
+        return true;
+    }
+
+    //! Copy out the value of an allocated key.  @returns false if key is not allocated.
+    bool find(key_type key, V& value) const
+    {
+        slot_t *S = lookupKey(key);
+        if(!S)
+            return false;
+        Guard G(stripe(key&indexMask));
+        if(!S->used || S->generation!=key>>indexBits)
+            return false;
+        value = S->value;
+        return true;
+    }
+
+    //! Free a key, moving out its value.  @returns false if key is not allocated.
+    bool remove(key_type key, V& value)
+    {
+        const key_type idx = key&indexMask;
+        slot_t *S = lookupKey(key);
+        if(!S)
+            return false;
+        V old; // destroy any previous 'value' after unlock
+        {
+            Guard G(stripe(idx));
+            if(!S->used || S->generation!=key>>indexBits)
+                return false;
+            S->used = false;
+            std::swap(old, S->value);
+        }
+        std::swap(value, old);
+        {
+            Guard G(lock);
+            S->nextFree = maxSlots;
+            if(freeTail==maxSlots)
+                freeHead = idx;
+            else
+                lookup(freeTail)->nextFree = idx;
+            freeTail = idx;
+            count--;
+        }
+        return true;
+    }
+
+    //! Free a key.  @returns false if key is not allocated.
+    bool remove(key_type key)
+    {
+        V temp;
+        return remove(key, temp);
+    }
+
+    //! Free all keys, appending their values to 'values'
+    void clear(std::vector<V>& values)
+    {
+        Guard G(lock);
+        values.reserve(values.size()+count);
+        for(key_type idx=0u; idx<nextUnused; idx++) {
+            slot_t& S = *lookup(idx);
+            {
+                Guard G2(stripe(idx));
+                if(!S.used)
+                    continue;
+                S.used = false;
+                values.push_back(V());
+                std::swap(values.back(), S.value);
+            }
+            S.nextFree = maxSlots;
+            if(freeTail==maxSlots)
+                freeHead = idx;
+            else
+                lookup(freeTail)->nextFree = idx;
+            freeTail = idx;
+            count--;
+        }
+    }
+
+    //! Append copies of all values to 'values'
+    void values(std::vector<V>& values) const
+    {
+        key_type n;
+        {
+            Guard G(lock);
+            n = nextUnused;
+            values.reserve(values.size()+count);
+        }
+        for(key_type idx=0u; idx<n; idx++) {
+            const slot_t& S = *lookup(idx);
+            Guard G(stripe(idx));
+            if(S.used)
+                values.push_back(S.value);
+        }
+    }
+};
+
+}} // namespace epics::pvAccess
+
+#endif // SLOTTABLE_H
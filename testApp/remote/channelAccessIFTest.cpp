@@ -25,6 +25,7 @@
 #include <pv/current_function.h>
 
 #include "channelAccessIFTest.h"
+#include "testLoopback.h"
 
 //#define ENABLE_STRESS_TESTS
 #define TESTSERVERNOMAIN
@@ -64,13 +65,8 @@ int ChannelAccessIFTest::runAllTest() {
 
     testPlan(152+EXTRA_STRESS_TESTS);
 
-    epics::pvAccess::Configuration::shared_pointer base_config(ConfigurationBuilder()
+    epics::pvAccess::Configuration::shared_pointer base_config(testLoopbackConfig()
             //.add("EPICS_PVA_DEBUG", "3")
-            .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
-            .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
-            .add("EPICS_PVA_AUTO_ADDR_LIST","0")
-            .add("EPICS_PVA_SERVER_PORT", "0")
-            .add("EPICS_PVA_BROADCAST_PORT", "0")
             .push_map()
             .build());
 
@@ -0,0 +1,105 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Many clients connecting at once to a server with
+ * several acceptor threads, and with admission rate limiting.
+ */
+
+#include <vector>
+
+#include <epicsTime.h>
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/current_function.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->createStructure());
+
+// returns seconds for 'nclients' separate client contexts to connect and get()
+double connectMany(unsigned threads, double rate, unsigned burst, size_t nclients)
+{
+    testDiag("==== %s threads=%u rate=%g burst=%u ====", CURRENT_FUNCTION, threads, rate, burst);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+    pv->open(type);
+    prov->add("pv:name", pv);
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .add("EPICS_PVAS_ACCEPT_THREADS", threads)
+                                                          .add("EPICS_PVAS_ACCEPT_RATE", rate)
+                                                          .add("EPICS_PVAS_ACCEPT_BURST", burst)
+                                                          .push_map()
+                                                          .build())));
+
+    testEqual(server->getCurrentConfig()->getPropertyAsInteger("EPICS_PVAS_ACCEPT_THREADS", 0), int(threads));
+
+    std::vector<pvac::ClientProvider> clients;
+    std::vector<pvac::ClientChannel> chans;
+    for(size_t i=0; i<nclients; i++) {
+        // each a separate context, so a separate TCP connection
+        clients.push_back(pvac::ClientProvider("pva", pva::ConfigurationBuilder()
+                                               .push_config(server->getCurrentConfig())
+                                               .push_map()
+                                               .build()));
+    }
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+
+    for(size_t i=0; i<nclients; i++)
+        chans.push_back(clients[i].connect("pv:name"));
+
+    size_t ngot = 0u;
+    for(size_t i=0; i<nclients; i++) {
+        try {
+            chans[i].get(10.0);
+            ngot++;
+        } catch(std::exception& e) {
+            testDiag("client %u error: %s", unsigned(i), e.what());
+        }
+    }
+
+    epicsTimeGetCurrent(&end);
+
+    const double elapsed = epicsTimeDiffInSeconds(&end, &start);
+    testOk(ngot==nclients, "%u of %u clients connected", unsigned(ngot), unsigned(nclients));
+    testDiag("  %.3f sec.", elapsed);
+    return elapsed;
+}
+
+} // namespace
+
+MAIN(testAcceptor)
+{
+    testPlan(7);
+    try {
+        connectMany(1u, 0.0, 1u, 20u);
+        connectMany(4u, 0.0, 1u, 100u);
+        // 20 connections at 50 per second, after an initial burst of 5, take at least 0.3 seconds
+        double elapsed = connectMany(2u, 50.0, 5u, 20u);
+        testOk(elapsed>=0.25, "rate limited %.3f >= 0.25", elapsed);
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/channelAddressCache.h>
+#include <pv/inetAddressUtil.h>
+#include <pv/current_function.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const char cacheFile[] = "testAddressCache.tmp";
+
+pva::ServerGUID makeGUID(char fill)
+{
+    pva::ServerGUID guid;
+    memset(guid.value, fill, sizeof(guid.value));
+    return guid;
+}
+
+osiSockAddr makeAddr(const char* str)
+{
+    osiSockAddr addr;
+    memset(&addr, 0, sizeof(addr));
+    if(aToIPAddr(str, 0, &addr.ia))
+        testAbort("Invalid address %s", str);
+    return addr;
+}
+
+void testCache()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    ::remove(cacheFile);
+
+    {
+        pva::ChannelAddressCache cache(cacheFile, 3600.0);
+        testOk1(!cache.load());
+
+        cache.update("pv:one", makeAddr("127.0.0.1:5075"), makeGUID('\x01'));
+        cache.update("pv:two", makeAddr("127.0.0.1:5076"), makeGUID('\x02'));
+        cache.update("pv with space", makeAddr("127.0.0.1:5075"), makeGUID('\x01'));
+        testEqual(cache.size(), 3u);
+        testOk1(cache.save());
+    }
+
+    {
+        pva::ChannelAddressCache cache(cacheFile, 3600.0);
+        testOk1(cache.load());
+        testEqual(cache.size(), 3u);
+
+        pva::ChannelAddressCache::Entry ent;
+        testOk1(cache.lookup("pv:two", ent));
+        testEqual(inetAddressToString(ent.address), "127.0.0.1:5076");
+        testOk1(memcmp(ent.guid.value, makeGUID('\x02').value, sizeof(ent.guid.value))==0);
+        testOk1(cache.lookup("pv with space", ent));
+        testOk1(!cache.lookup("pv:three", ent));
+
+        testEqual(cache.invalidate(makeGUID('\x01')), 2u);
+        testEqual(cache.size(), 1u);
+        testOk1(!cache.lookup("pv:one", ent));
+
+        cache.remove("pv:two");
+        testEqual(cache.size(), 0u);
+    }
+
+    ::remove(cacheFile);
+}
+
+// A second client finds the channel through the cache, without any search address.
+void testReconnect()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    ::remove(cacheFile);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+    pv->open(pvd::getFieldCreate()->createFieldBuilder()
+             ->add("value", pvd::pvInt)
+             ->createStructure());
+    prov->add("pv:name", pv);
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .push_map()
+                                                          .build())));
+
+    {
+        pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                                 .push_config(server->getCurrentConfig())
+                                 .add("EPICS_PVA_ADDR_CACHE", cacheFile)
+                                 .push_map()
+                                 .build());
+        testOk1(!!cli.connect("pv:name").get(5.0));
+    }
+
+    {
+        pva::ChannelAddressCache cache(cacheFile, 3600.0);
+        testOk1(cache.load());
+        testEqual(cache.size(), 1u);
+    }
+
+    {
+        pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                                 .add("EPICS_PVA_ADDR_LIST", "")
+                                 .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                 .add("EPICS_PVA_ADDR_CACHE", cacheFile)
+                                 .push_map()
+                                 .build());
+        testOk1(!!cli.connect("pv:name").get(5.0));
+    }
+
+    ::remove(cacheFile);
+}
+
+} // namespace
+
+MAIN(testAddressCache)
+{
+    testPlan(18);
+    try {
+        testCache();
+        testReconnect();
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
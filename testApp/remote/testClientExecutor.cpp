@@ -0,0 +1,168 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Client callbacks made from a worker pool, so that a slow
+ * callback doesn't delay other channels of the same connection.
+ */
+
+#include <string.h>
+
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/current_function.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->createStructure());
+
+// blocks in the first monitorEvent() until released
+struct SlowMonitor : public pvac::ClientChannel::MonitorCallback
+{
+    epicsEvent entered, release;
+    bool first;
+    std::string thread;
+    SlowMonitor() :first(true) {}
+    virtual ~SlowMonitor() {}
+    virtual void monitorEvent(const pvac::MonitorEvent& evt) OVERRIDE FINAL
+    {
+        if(evt.event!=pvac::MonitorEvent::Data || !first)
+            return;
+        first = false;
+        thread = epicsThreadGetNameSelf();
+        entered.signal();
+        release.wait();
+    }
+};
+
+struct TestServer {
+    std::tr1::shared_ptr<pvas::StaticProvider> prov;
+    pva::ServerContext::shared_pointer server;
+
+    TestServer()
+        :prov(new pvas::StaticProvider("test"))
+    {
+        for(unsigned i=0; i<2; i++) {
+            std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildMailbox());
+            pv->open(type);
+            prov->add(i==0 ? "pv:a" : "pv:b", pv);
+        }
+
+        server = pva::ServerContext::create(pva::ServerContext::Config()
+                                            .provider(prov->provider())
+                                            .config(testLoopbackConfig()
+                                                    .push_map()
+                                                    .build()));
+    }
+};
+
+void testConfig()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    TestServer S;
+    pvac::ClientProvider::ExecutorStats stats;
+
+    {
+        pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                                 .push_config(S.server->getCurrentConfig())
+                                 .push_map()
+                                 .build());
+        testOk1(!cli.executorStats(stats));
+        testEqual(stats.nthreads, 0u);
+    }
+    {
+        pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                                 .push_config(S.server->getCurrentConfig())
+                                 .add("EPICS_PVA_CALLBACK_THREADS", 3)
+                                 .push_map()
+                                 .build());
+        testOk1(cli.executorStats(stats));
+        testEqual(stats.nthreads, 3u);
+
+        testOk1(!!cli.connect("pv:a").get(5.0));
+        cli.executorStats(stats);
+        testOk(stats.ncompleted>0u, "ncompleted %u", unsigned(stats.ncompleted));
+    }
+}
+
+void testSlowCallback(pvac::ClientProvider::Dispatch mode)
+{
+    testDiag("==== %s mode=%d ====", CURRENT_FUNCTION, int(mode));
+
+    TestServer S;
+    pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                             .push_config(S.server->getCurrentConfig())
+                             .push_map()
+                             .build());
+    cli.setExecutor(mode, 2u);
+
+    pvac::ClientChannel A(cli.connect("pv:a")),
+                        B(cli.connect("pv:b"));
+
+    SlowMonitor slow;
+    pvac::Monitor mon(A.monitor(&slow));
+
+    testOk1(slow.entered.wait(5.0));
+    testOk(strncmp(slow.thread.c_str(), "pvac-cb", 7)==0, "callback from '%s'", slow.thread.c_str());
+
+    // same server, so same connection, while the monitor callback of A blocks
+    try {
+        B.put().set("value", 5).exec(2.0);
+        testEqual(B.get(2.0)->getSubFieldT<pvd::PVInt>("value")->get(), 5);
+    }catch(std::exception& e){
+        testFail("B blocked: %s", e.what());
+    }
+
+    if(mode==pvac::ClientProvider::Pool) {
+        // other operations of A proceed as well
+        try {
+            testOk1(!!A.get(2.0));
+        }catch(std::exception& e){
+            testFail("A blocked: %s", e.what());
+        }
+    } else {
+        testSkip(1, "Serial");
+    }
+
+    pvac::ClientProvider::ExecutorStats stats;
+    testOk1(cli.executorStats(stats));
+    testDiag("  queued %u (max %u) completed %u stolen %u wait avg %.6f max %.6f sec.",
+             unsigned(stats.nqueued), unsigned(stats.maxQueued), unsigned(stats.ncompleted),
+             unsigned(stats.nstolen), stats.ncompleted ? stats.waitTotal/stats.ncompleted : 0.0,
+             stats.waitMax);
+
+    slow.release.signal();
+    mon.cancel();
+}
+
+} // namespace
+
+MAIN(testClientExecutor)
+{
+    testPlan(16);
+    try {
+        testConfig();
+        testSlowCallback(pvac::ClientProvider::Serial);
+        testSlowCallback(pvac::ClientProvider::Pool);
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Get and put of many PVs with one ClientProvider::getMany()/putMany() call.
+ */
+
+#include <sstream>
+
+#include <epicsEvent.h>
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/current_function.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const size_t npvs = 50u;
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->createStructure());
+
+struct TestServer {
+    std::tr1::shared_ptr<pvas::StaticProvider> prov;
+    pva::ServerContext::shared_pointer server;
+    std::vector<std::string> names;
+
+    TestServer()
+        :prov(new pvas::StaticProvider("test"))
+    {
+        for(size_t i=0; i<npvs; i++) {
+            std::ostringstream name;
+            name<<"pv:"<<i;
+            names.push_back(name.str());
+
+            std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildMailbox());
+            pv->open(type);
+            prov->add(names.back(), pv);
+        }
+
+        server = pva::ServerContext::create(pva::ServerContext::Config()
+                                            .provider(prov->provider())
+                                            .config(testLoopbackConfig()
+                                                    .push_map()
+                                                    .build()));
+    }
+
+    pvac::ClientProvider client() const
+    {
+        return pvac::ClientProvider("pva", pva::ConfigurationBuilder()
+                                    .push_config(server->getCurrentConfig())
+                                    .push_map()
+                                    .build());
+    }
+};
+
+struct ManyDone : public pvac::ClientProvider::GetManyCallback
+{
+    epicsEvent event;
+    std::vector<pvac::GetEvent> results;
+    virtual ~ManyDone() {}
+    virtual void getManyDone(const std::vector<pvac::GetEvent>& evts) OVERRIDE FINAL
+    {
+        results = evts;
+        event.signal();
+    }
+};
+
+void testPutGet()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    TestServer S;
+    pvac::ClientProvider cli(S.client());
+
+    std::vector<pvd::AnyScalar> values;
+    for(size_t i=0; i<npvs; i++)
+        values.push_back(pvd::AnyScalar(pvd::int32(i+10)));
+
+    std::vector<pvac::PutEvent> presults;
+    testEqual(cli.putMany(S.names, values, presults, 5.0), npvs);
+    testEqual(presults.size(), npvs);
+
+    std::vector<pvac::GetEvent> gresults;
+    testEqual(cli.getMany(S.names, gresults, 5.0), npvs);
+    testEqual(gresults.size(), npvs);
+
+    bool match = true;
+    for(size_t i=0; i<gresults.size(); i++) {
+        pvd::int32 val = gresults[i].value ? gresults[i].value->getSubFieldT<pvd::PVInt>("value")->get() : -1;
+        if(val!=pvd::int32(i+10)) {
+            testDiag("%s = %d", S.names[i].c_str(), val);
+            match = false;
+        }
+    }
+    testOk(match, "All values match");
+
+    values.pop_back();
+    testThrows(std::invalid_argument, cli.putMany(S.names, values, presults));
+
+    std::vector<std::string> none;
+    testEqual(cli.getMany(none, gresults), 0u);
+    testEqual(gresults.size(), 0u);
+}
+
+void testMissing()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    TestServer S;
+    pvac::ClientProvider cli(S.client());
+
+    std::vector<std::string> names(S.names);
+    names.push_back("pv:nonexistent");
+
+    std::vector<pvac::GetEvent> results;
+    testEqual(cli.getMany(names, results, 1.0), npvs);
+    testEqual(results.size(), npvs+1u);
+    testEqual(results.back().event, pvac::GetEvent::Cancel);
+}
+
+void testCallback()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    TestServer S;
+    pvac::ClientProvider cli(S.client());
+
+    ManyDone done;
+    pvac::Operation op(cli.getMany(&done, S.names));
+
+    testOk1(done.event.wait(5.0));
+    testEqual(done.results.size(), npvs);
+
+    size_t nok = 0u;
+    for(size_t i=0; i<done.results.size(); i++) {
+        if(done.results[i].event==pvac::GetEvent::Success)
+            nok++;
+    }
+    testEqual(nok, npvs);
+
+    // cancel after completion doesn't repeat the callback
+    op.cancel();
+    testOk1(!done.event.tryWait());
+}
+
+} // namespace
+
+MAIN(testClientMany)
+{
+    testPlan(15);
+    try {
+        testPutGet();
+        testMissing();
+        testCallback();
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
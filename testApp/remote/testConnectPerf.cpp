@@ -0,0 +1,126 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Time to connect N channels through UDP search of a local server
+ */
+
+#include <vector>
+#include <sstream>
+
+#include <epicsTime.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+typedef epicsGuard<epicsMutex> Guard;
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->createStructure());
+
+struct ConnectCounter : public pvac::ClientChannel::ConnectCallback
+{
+    epicsMutex mutex;
+    epicsEvent done;
+    size_t expect, connected;
+
+    explicit ConnectCounter(size_t expect) :expect(expect), connected(0u) {}
+    virtual ~ConnectCounter() {}
+
+    virtual void connectEvent(const pvac::ConnectEvent& evt) OVERRIDE FINAL
+    {
+        if(!evt.connected)
+            return;
+        Guard G(mutex);
+        if(++connected==expect)
+            done.signal();
+    }
+};
+
+void benchmark(size_t npvs)
+{
+    testDiag("==== benchmark %u channels ====", unsigned(npvs));
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+    pv->open(type);
+
+    std::vector<std::string> names(npvs);
+    for(size_t i=0; i<npvs; i++) {
+        std::ostringstream strm;
+        strm<<"connect:perf:"<<i;
+        names[i] = strm.str();
+        prov->add(names[i], pv);
+    }
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .push_map()
+                                                          .build())));
+
+    pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                             .push_config(server->getCurrentConfig())
+                             .push_map()
+                             .build());
+
+    ConnectCounter counter(npvs);
+    std::vector<pvac::ClientChannel> chans(npvs);
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+
+    for(size_t i=0; i<npvs; i++) {
+        chans[i] = cli.connect(names[i]);
+        chans[i].addConnectListener(&counter);
+    }
+
+    bool ok = counter.done.wait(60.0);
+
+    epicsTimeGetCurrent(&end);
+
+    size_t nconn;
+    {
+        Guard G(counter.mutex);
+        nconn = counter.connected;
+    }
+
+    testOk(ok, "connected %u of %u", unsigned(nconn), unsigned(npvs));
+    testDiag("  %.3f sec. to connect %u channels", epicsTimeDiffInSeconds(&end, &start), unsigned(npvs));
+
+    for(size_t i=0; i<npvs; i++)
+        chans[i].removeConnectListener(&counter);
+}
+
+} // namespace
+
+MAIN(testConnectPerf)
+{
+    testPlan(3);
+    try {
+        benchmark(100u);
+        benchmark(1000u);
+        benchmark(10000u);
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
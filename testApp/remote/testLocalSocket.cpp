@@ -0,0 +1,162 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Client and server on the same host, connected through TCP
+ * and through a local (unix) socket.  Compare latency and throughput.
+ */
+
+#include <sys/stat.h>
+#include <string.h>
+
+#include <epicsTime.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/security.h>
+#include <pv/blockingTCP.h>
+#include <pv/current_function.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+typedef epicsGuard<epicsMutex> Guard;
+
+// remembers the peer of the last Put
+struct PeerHandler : public pvas::SharedPV::Handler
+{
+    epicsMutex lock;
+    std::string peer;
+
+    virtual ~PeerHandler() {}
+    virtual void onPut(const pvas::SharedPV::shared_pointer& pv, pvas::Operation& op) OVERRIDE FINAL
+    {
+        {
+            Guard G(lock);
+            peer = op.peer() ? op.peer()->peer : std::string();
+        }
+        pv->post(op.value(), op.changed());
+        op.complete();
+    }
+};
+
+bool exists(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info)==0;
+}
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->addArray("array", pvd::pvDouble)
+                                  ->createStructure());
+
+void testConnect(bool local)
+{
+    testDiag("==== %s %s ====", CURRENT_FUNCTION, local ? "local" : "TCP");
+
+    std::tr1::shared_ptr<PeerHandler> handler(new PeerHandler);
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::build(handler));
+    pv->open(type);
+    prov->add("pv:name", pv);
+
+    std::string path;
+    {
+        pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                      pva::ServerContext::Config()
+                                                      .provider(prov->provider())
+                                                      .config(testLoopbackConfig()
+                                                              .add("EPICS_PVAS_UNIX_DIR", ".")
+                                                              .push_map()
+                                                              .build())));
+
+        osiSockAddr bound;
+        memset(&bound, 0, sizeof(bound));
+        bound.ia.sin_family = AF_INET;
+        bound.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bound.ia.sin_port = htons(server->getServerPort());
+
+        path = pva::localSocketPath(".", bound);
+        testOk(exists(path), "%s exists", path.c_str());
+
+        // named for the bound address, so other servers may use the same port on other addresses
+        bound.ia.sin_addr.s_addr = htonl(INADDR_ANY);
+        testOk(!exists(pva::localSocketPath(".", bound)), "no socket for all interfaces");
+
+        pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                                 .push_config(server->getCurrentConfig())
+                                 .add("EPICS_PVA_UNIX_DIR", local ? "." : "")
+                                 .push_map()
+                                 .build());
+        pvac::ClientChannel chan(cli.connect("pv:name"));
+
+        chan.put().set("value", 42).exec(5.0);
+        {
+            Guard G(handler->lock);
+            testOk(local == (handler->peer.compare(0, 5, "unix:")==0), "peer '%s'", handler->peer.c_str());
+        }
+
+        // latency
+        {
+            const unsigned N = 1000u;
+            epicsTimeStamp start, end;
+            epicsTimeGetCurrent(&start);
+            for(unsigned i=0; i<N; i++)
+                chan.get(5.0);
+            epicsTimeGetCurrent(&end);
+            testDiag("  get() round trip %.1f us", epicsTimeDiffInSeconds(&end, &start)/N*1e6);
+        }
+
+        // throughput
+        {
+            pvd::shared_vector<double> arr(1024u*1024u);
+            for(size_t i=0; i<arr.size(); i++)
+                arr[i] = double(i);
+            pvd::shared_vector<const double> expect(pvd::freeze(arr));
+            chan.put().set("array", expect).exec(5.0);
+
+            const unsigned N = 20u;
+            size_t nbytes = 0u;
+            epicsTimeStamp start, end;
+            epicsTimeGetCurrent(&start);
+            for(unsigned i=0; i<N; i++)
+                nbytes += chan.get(5.0)->getSubFieldT<pvd::PVDoubleArray>("array")->view().size()*sizeof(double);
+            epicsTimeGetCurrent(&end);
+            testOk(nbytes==N*expect.size()*sizeof(double), "received %u bytes", unsigned(nbytes));
+            testDiag("  get() %.1f MB/s", nbytes/epicsTimeDiffInSeconds(&end, &start)/1e6);
+        }
+    }
+
+    testOk(!exists(path), "%s removed", path.c_str());
+}
+
+} // namespace
+
+MAIN(testLocalSocket)
+{
+    testPlan(10);
+#ifdef PVA_UNIX_SOCKET
+    try {
+        testConnect(false);
+        testConnect(true);
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+#else
+    testSkip(8, "No local sockets");
+#endif
+    return testDone();
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef TESTLOOPBACK_H
+#define TESTLOOPBACK_H
+
+#include <pv/configuration.h>
+
+/* Configuration for a client and server which talk to each other only,
+ * through the loopback interface, with ports chosen by the OS.
+ * Add test specific settings, then push_map().build().
+ */
+inline
+epics::pvAccess::ConfigurationBuilder testLoopbackConfig()
+{
+    epics::pvAccess::ConfigurationBuilder builder;
+    builder.add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+           .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+           .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+           .add("EPICS_PVA_SERVER_PORT", "0")
+           .add("EPICS_PVA_BROADCAST_PORT", "0");
+    return builder;
+}
+
+#endif // TESTLOOPBACK_H
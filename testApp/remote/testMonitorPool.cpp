@@ -0,0 +1,197 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Client monitor queue storage shared through a MonitorElementPool,
+ * and partial updates copied into re-used queue elements.
+ */
+
+#include <epicsThread.h>
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/current_function.h>
+#include <pv/monitorElementPool.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+pvd::StructureConstPtr buildType()
+{
+    return pvd::getFieldCreate()->createFieldBuilder()
+            ->add("a", pvd::pvInt)
+            ->add("b", pvd::pvInt)
+            ->add("c", pvd::pvInt)
+            ->createStructure();
+}
+
+void testPool()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    pva::MonitorElementPool pool(1u, 2u);
+    pva::MonitorElementPool::Stats stats;
+
+    // equal, but distinct, instances
+    pvd::StructureConstPtr A(buildType()), B(buildType()),
+                           C(pvd::getFieldCreate()->createFieldBuilder()
+                             ->add("value", pvd::pvDouble)
+                             ->createStructure());
+
+    testOk1(pool.canonical(A)==A);
+    testOk1(pool.canonical(B)==A);
+    testOk1(pool.canonical(C)==C);
+    pool.stats(stats);
+    testEqual(stats.ntypes, 2u);
+
+    pvd::PVStructurePtr first(pool.get(A));
+    testOk1(first->getStructure()==A);
+    pool.stats(stats);
+    testEqual(stats.ncreated, 1u);
+
+    {
+        pvd::PVStructurePtr other(first);
+        pool.put(first); // still referenced
+    }
+    pool.stats(stats);
+    testEqual(stats.npooled, 0u);
+
+    pvd::PVStructurePtr second(pool.get(A));
+    first->getSubFieldT<pvd::PVInt>("a")->put(5);
+    pool.put(first);
+    pool.put(second); // full
+    pool.stats(stats);
+    testEqual(stats.npooled, 1u);
+
+    pool.put(pvd::getPVDataCreate()->createPVStructure(B)); // not canonical
+    pool.stats(stats);
+    testEqual(stats.npooled, 1u);
+
+    pvd::PVStructurePtr third(pool.get(A));
+    pool.stats(stats);
+    testEqual(stats.nreused, 1u);
+    testEqual(stats.npooled, 0u);
+    // previous value not kept
+    testEqual(third->getSubFieldT<pvd::PVInt>("a")->get(), 0);
+
+    // limit for all types
+    {
+        pva::MonitorElementPool small(2u, 2u);
+        small.canonical(A);
+        small.canonical(C);
+        pvd::PVStructurePtr a1(small.get(A)), a2(small.get(A)), c1(small.get(C));
+        small.put(a1);
+        small.put(a2);
+        small.put(c1);
+        small.stats(stats);
+        testEqual(stats.npooled, 2u);
+    }
+
+    // types are forgotten once unused
+    {
+        pva::MonitorElementPool temp(1u, 1u);
+        {
+            pvd::StructureConstPtr D(buildType());
+            temp.put(temp.get(temp.canonical(D)));
+        }
+        // D is still referenced by the pooled structure
+        temp.stats(stats);
+        testEqual(stats.npooled, 1u);
+        testOk1(!!temp.get(temp.canonical(buildType())));
+        temp.canonical(C);
+        temp.stats(stats);
+        testEqual(stats.ntypes, 1u);
+    }
+}
+
+// each update changes one field.  Elements must still hold all current values.
+void testPartialUpdates()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    const pvd::StructureConstPtr type(buildType());
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+    prov->add("pv:name", pv);
+
+    pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(type));
+    pvd::BitSet changed;
+    pvd::PVIntPtr fields[3] = {
+        inst->getSubFieldT<pvd::PVInt>("a"),
+        inst->getSubFieldT<pvd::PVInt>("b"),
+        inst->getSubFieldT<pvd::PVInt>("c"),
+    };
+
+    pv->open(*inst);
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .push_map()
+                                                          .build())));
+
+    pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                             .push_config(server->getCurrentConfig())
+                             .push_map()
+                             .build());
+
+    pvac::ClientChannel chan(cli.connect("pv:name"));
+
+    pvac::MonitorSync mon(chan.monitor(pvd::createRequest("record[queueSize=3]field()")));
+
+    testOk1(mon.wait(5.0) && mon.poll());
+
+    bool match = true;
+    unsigned count = 0;
+    for(pvd::int32 i=1; i<=40; i++) {
+        pvd::PVIntPtr& fld = fields[i%3];
+        fld->put(i);
+        changed.clear();
+        changed.set(fld->getFieldOffset());
+        pv->post(*inst, changed);
+
+        if(!mon.wait(5.0))
+            break;
+
+        while(mon.poll()) {
+            count++;
+            for(size_t f=0; f<3; f++) {
+                pvd::int32 actual = mon.root->getSubFieldT<pvd::PVInt>(fields[f]->getFieldName())->get(),
+                           expect = fields[f]->get();
+                if(actual!=expect) {
+                    testDiag("update %d field %s %d != %d", i, fields[f]->getFieldName().c_str(),
+                             actual, expect);
+                    match = false;
+                }
+            }
+        }
+    }
+    testEqual(count, 40u);
+    testOk1(match);
+}
+
+} // namespace
+
+MAIN(testMonitorPool)
+{
+    testPlan(20);
+    try {
+        testPool();
+        testPartialUpdates();
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
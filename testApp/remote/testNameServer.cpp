@@ -0,0 +1,116 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Search through a TCP connection to a name server, with UDP search disabled.
+ */
+
+#include <sstream>
+
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/current_function.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->createStructure());
+
+const size_t npvs = 1000u;
+
+std::string pvName(size_t i)
+{
+    std::ostringstream strm;
+    strm<<"pv:"<<i;
+    return strm.str();
+}
+
+void testSearch()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::vector<std::tr1::shared_ptr<pvas::SharedPV> > pvs(npvs);
+
+    for(size_t i=0; i<npvs; i++) {
+        pvs[i] = pvas::SharedPV::buildReadOnly();
+        pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(type));
+        inst->getSubFieldT<pvd::PVScalar>("value")->putFrom<pvd::int32>(pvd::int32(i));
+        pvs[i]->open(*inst);
+        prov->add(pvName(i), pvs[i]);
+    }
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .push_map()
+                                                          .build())));
+
+    std::ostringstream nameServer;
+    nameServer<<"127.0.0.1:"<<server->getServerPort();
+    testDiag("Name server %s", nameServer.str().c_str());
+
+    // no UDP search
+    pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                             .add("EPICS_PVA_NAME_SERVERS", nameServer.str())
+                             .add("EPICS_PVA_ADDR_LIST", "")
+                             .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                             .add("EPICS_PVA_BROADCAST_PORT", "0")
+                             .push_map()
+                             .build());
+
+    {
+        pvac::ClientChannel chan(cli.connect(pvName(42)));
+        pvd::PVStructure::const_shared_pointer R(chan.get(5.0));
+        testEqual(R->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>(), 42);
+    }
+
+    // all searched together
+    std::vector<pvac::ClientChannel> chans(npvs);
+    for(size_t i=0; i<npvs; i++)
+        chans[i] = cli.connect(pvName(i));
+
+    bool ok = true;
+    for(size_t i=0; i<npvs && ok; i++) {
+        try {
+            pvd::PVStructure::const_shared_pointer R(chans[i].get(5.0));
+            ok &= R->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>()==pvd::int32(i);
+        } catch(std::exception& e) {
+            testDiag("%s : %s", pvName(i).c_str(), e.what());
+            ok = false;
+        }
+    }
+    testOk(ok, "Get %u PVs found through name server", unsigned(npvs));
+
+    {
+        pvac::ClientChannel chan(cli.connect("pv:nonexistent"));
+        testThrows(pvac::Timeout, chan.get(1.0));
+    }
+}
+
+} // namespace
+
+MAIN(testNameServer)
+{
+    testPlan(3);
+    try {
+        testSearch();
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
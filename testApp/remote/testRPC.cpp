@@ -7,9 +7,14 @@
 #include <pv/rpcServer.h>
 #include <pv/rpcService.h>
 
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
 #include <epicsUnitTest.h>
 #include <testMain.h>
 
+#include "testLoopback.h"
+
 namespace pvd = epics::pvData;
 namespace pva = epics::pvAccess;
 
@@ -106,49 +111,112 @@ void testRPCFail(const pva::ChannelProvider::shared_pointer& cli_prov)
     }
 }
 
-} // namespace
-
-MAIN(testRPC)
+// blocks until released
+struct SlowService : public pva::RPCService
 {
-    testPlan(3);
-    try {
-        pva::Configuration::shared_pointer conf(pva::ConfigurationBuilder()
-                                                //.push_env()
-                                                //.add("EPICS_PVA_DEBUG", "3")
-                                                .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
-                                                .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
-                                                .add("EPICS_PVA_AUTO_ADDR_LIST","0")
-                                                .add("EPICS_PVA_SERVER_PORT", "0")
-                                                .add("EPICS_PVA_BROADCAST_PORT", "0")
-                                                .push_map()
-                                                .build());
-
-        testDiag("Server Setup");
-        pva::RPCServer serv(conf);
-        testDiag("TestServer on ports TCP=%u UDP=%u",
-                 serv.getServer()->getServerPort(),
-                 serv.getServer()->getBroadcastPort());
-
-        {
-            std::tr1::shared_ptr<pva::RPCService> service(new SumService);
-            serv.registerService("sum", service);
-        }
+    epicsEvent release;
+    // request() runs in an RPC worker
+    mutable epicsMutex mutex;
+    bool done;
+    SlowService() :done(false) {}
+    virtual epics::pvData::PVStructure::shared_pointer request(
+        epics::pvData::PVStructure::shared_pointer const & args
+    ) OVERRIDE FINAL
+    {
+        testDiag("slow()");
+        release.wait(5.0);
         {
-            std::tr1::shared_ptr<pva::RPCService> service(new FailService);
-            serv.registerService("fail", service);
+            epicsGuard<epicsMutex> G(mutex);
+            done = true;
         }
+        return pvd::getPVDataCreate()->createPVStructure(reply_type);
+    }
+    bool isDone() const
+    {
+        epicsGuard<epicsMutex> G(mutex);
+        return done;
+    }
+};
+
+void testPool(const pva::RPCServer& serv, const pva::ChannelProvider::shared_pointer& cli_prov, SlowService& slow)
+{
+    testDiag("Pool");
+
+    testEqual(serv.numWorkers(), 2u);
 
-        testDiag("Client Setup");
-        pva::ClientFactory::start();
-        pva::ChannelProvider::shared_pointer cli_prov(pva::ChannelProviderRegistry::clients()->createProvider("pva",
-                                                                                                              serv.getServer()->getCurrentConfig()));
-        if(!cli_prov)
-            testAbort("No pva provider");
-        testDiag("Client Ready");
+    pva::RPCClient client("slow", pvd::createRequest("field()"), cli_prov);
+    testOk1(client.waitConnect());
+
+    pvd::ValueBuilder args("epics:nt/NTURI:1.0");
+    args.add<pvd::pvString>("scheme", "pva")
+        .add<pvd::pvString>("path", "slow");
+    client.issueRequest(args.buildPVStructure());
+
+    // not blocked by "slow" on the same connection
+    testSum(cli_prov);
+    testOk1(!slow.isDone());
+
+    slow.release.signal();
+    testOk1(!!client.waitResponse(5.0));
+
+    pva::RPCServer::ServiceStats stats;
+    testOk1(serv.getServiceStats("slow", stats));
+    testOk(stats.ncompleted==1u && stats.nrunning==0u && stats.nqueued==0u,
+           "completed=%u running=%u queued=%u exec=%f",
+           unsigned(stats.ncompleted), unsigned(stats.nrunning), unsigned(stats.nqueued), stats.execMax);
+    testOk1(!serv.getServiceStats("nonexistent", stats));
+}
 
-        testSum(cli_prov);
-        testRPCFail(cli_prov);
+void testServer(int nworkers)
+{
+    testDiag("==== RPC workers=%d ====", nworkers);
+
+    pva::Configuration::shared_pointer conf(testLoopbackConfig()
+                                            //.push_env()
+                                            //.add("EPICS_PVA_DEBUG", "3")
+                                            .add("EPICS_PVAS_RPC_THREADS", nworkers)
+                                            .push_map()
+                                            .build());
+
+    testDiag("Server Setup");
+    pva::RPCServer serv(conf);
+    testDiag("TestServer on ports TCP=%u UDP=%u",
+             serv.getServer()->getServerPort(),
+             serv.getServer()->getBroadcastPort());
 
+    {
+        std::tr1::shared_ptr<pva::RPCService> service(new SumService);
+        serv.registerService("sum", service);
+    }
+    {
+        std::tr1::shared_ptr<pva::RPCService> service(new FailService);
+        serv.registerService("fail", service);
+    }
+    std::tr1::shared_ptr<SlowService> slow(new SlowService);
+    serv.registerService("slow", slow, 1u);
+
+    testDiag("Client Setup");
+    pva::ClientFactory::start();
+    pva::ChannelProvider::shared_pointer cli_prov(pva::ChannelProviderRegistry::clients()->createProvider("pva",
+                                                                                                          serv.getServer()->getCurrentConfig()));
+    if(!cli_prov)
+        testAbort("No pva provider");
+    testDiag("Client Ready");
+
+    testSum(cli_prov);
+    testRPCFail(cli_prov);
+    if(nworkers)
+        testPool(serv, cli_prov, *slow);
+}
+
+} // namespace
+
+MAIN(testRPC)
+{
+    testPlan(3+3+9);
+    try {
+        testServer(0);
+        testServer(2);
     }catch(std::exception& e){
         PRINT_EXCEPTION(e);
         testAbort("Unexpected exception: %s", e.what());
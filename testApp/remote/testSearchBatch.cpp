@@ -0,0 +1,331 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Search results for the names of one request are sent in one response.
+ */
+
+#include <string.h>
+#include <set>
+#include <vector>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsThread.h>
+#include <epicsStdio.h>
+#include <osiSock.h>
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/remote.h>
+#include <pv/current_function.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+typedef epicsGuard<epicsMutex> Guard;
+
+const size_t nnames = 5u;
+
+// answers channelFind() only when told to
+struct DeferredProvider : public pva::ChannelProvider
+{
+    POINTER_DEFINITIONS(DeferredProvider);
+
+    epicsMutex mutex;
+    std::vector<pva::ChannelFindRequester::shared_pointer> pending;
+    std::tr1::weak_ptr<DeferredProvider> internal_self;
+
+    virtual ~DeferredProvider() {}
+
+    virtual std::string getProviderName() OVERRIDE FINAL { return "deferred"; }
+
+    virtual pva::ChannelFind::shared_pointer channelFind(std::string const & name,
+                                                         pva::ChannelFindRequester::shared_pointer const & requester) OVERRIDE FINAL
+    {
+        if(name.compare(0, 4, "pv:a")==0) {
+            Guard G(mutex);
+            pending.push_back(requester);
+        }
+        return pva::ChannelFind::buildDummy(shared_pointer(internal_self));
+    }
+
+    virtual pva::Channel::shared_pointer createChannel(std::string const &, pva::ChannelRequester::shared_pointer const & requester,
+                                                       short, std::string const &) OVERRIDE FINAL
+    {
+        pva::Channel::shared_pointer ret;
+        requester->channelCreated(pvd::Status::error("No channels here"), ret);
+        return ret;
+    }
+
+    virtual void destroy() OVERRIDE FINAL {}
+
+    size_t npending()
+    {
+        Guard G(mutex);
+        return pending.size();
+    }
+
+    void answerAll()
+    {
+        std::vector<pva::ChannelFindRequester::shared_pointer> todo;
+        {
+            Guard G(mutex);
+            todo.swap(pending);
+        }
+        pva::ChannelFind::shared_pointer find(pva::ChannelFind::buildDummy(shared_pointer(internal_self)));
+        for(size_t i=0; i<todo.size(); i++)
+            todo[i]->channelFindResult(pvd::Status::Ok, find, true);
+    }
+};
+
+void put8(std::vector<char>& buf, pvd::int8 v) { buf.push_back(char(v)); }
+
+void put16(std::vector<char>& buf, pvd::int16 v)
+{
+    put8(buf, v>>8);
+    put8(buf, v);
+}
+
+void put32(std::vector<char>& buf, pvd::int32 v)
+{
+    put16(buf, v>>16);
+    put16(buf, v);
+}
+
+void putString(std::vector<char>& buf, const std::string& s)
+{
+    put8(buf, s.size());
+    buf.insert(buf.end(), s.begin(), s.end());
+}
+
+pvd::int32 get32(const char* p, bool big)
+{
+    const unsigned char* u = (const unsigned char*)p;
+    if(big)
+        return pvd::int32((pvd::uint32(u[0])<<24) | (pvd::uint32(u[1])<<16) | (pvd::uint32(u[2])<<8) | u[3]);
+    else
+        return pvd::int32((pvd::uint32(u[3])<<24) | (pvd::uint32(u[2])<<16) | (pvd::uint32(u[1])<<8) | u[0]);
+}
+
+pvd::int16 get16(const char* p, bool big)
+{
+    const unsigned char* u = (const unsigned char*)p;
+    return big ? pvd::int16((u[0]<<8) | u[1]) : pvd::int16((u[1]<<8) | u[0]);
+}
+
+struct Searcher
+{
+    SOCKET sock;
+    unsigned short port;
+
+    Searcher()
+        :sock(epicsSocketCreate(AF_INET, SOCK_DGRAM, IPPROTO_UDP))
+        ,port(0)
+    {
+        if(sock==INVALID_SOCKET)
+            testAbort("Unable to create socket");
+
+        osiSockAddr addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.ia.sin_family = AF_INET;
+        addr.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.ia.sin_port = 0;
+        if(::bind(sock, &addr.sa, sizeof(addr.ia)))
+            testAbort("Unable to bind socket");
+
+        osiSocklen_t alen = sizeof(addr.ia);
+        if(getsockname(sock, &addr.sa, &alen))
+            testAbort("Unable to get socket name");
+        port = ntohs(addr.ia.sin_port);
+
+        // receive() waits for this long after the last response
+        timeval timo;
+        timo.tv_sec = 0;
+        timo.tv_usec = 200000;
+        (void)setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&timo, sizeof(timo));
+    }
+    ~Searcher() { epicsSocketDestroy(sock); }
+
+    // one search request for all names, with CIDs 100, 101, ...
+    void search(unsigned short serverPort, pvd::int32 seq, const std::vector<std::string>& names)
+    {
+        std::vector<char> msg;
+        put8(msg, pva::PVA_MAGIC);
+        put8(msg, pva::PVA_CLIENT_PROTOCOL_REVISION);
+        put8(msg, char(0x80)); // big endian, application message from client
+        put8(msg, pva::CMD_SEARCH);
+        put32(msg, 0); // payload size, filled in below
+
+        put32(msg, seq);
+        put8(msg, 0); // no reply for names not found, and not unicast (no local re-broadcast)
+        put8(msg, 0); // reserved
+        put16(msg, 0);
+        // response address ::ffff:0.0.0.0 is replaced by the sender address
+        for(unsigned i=0; i<10; i++)
+            put8(msg, 0);
+        put16(msg, -1);
+        put32(msg, 0);
+        put16(msg, port);
+        put8(msg, 1);
+        putString(msg, "tcp");
+        put16(msg, names.size());
+        for(size_t i=0; i<names.size(); i++) {
+            put32(msg, 100+i);
+            putString(msg, names[i]);
+        }
+
+        pvd::int32 psize = msg.size()-pva::PVA_MESSAGE_HEADER_SIZE;
+        for(unsigned i=0; i<4; i++)
+            msg[4+i] = char(psize>>(8*(3-i)));
+
+        osiSockAddr dest;
+        memset(&dest, 0, sizeof(dest));
+        dest.ia.sin_family = AF_INET;
+        dest.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        dest.ia.sin_port = htons(serverPort);
+
+        if(::sendto(sock, &msg[0], msg.size(), 0, &dest.sa, sizeof(dest.ia))!=int(msg.size()))
+            testAbort("Unable to send search");
+    }
+
+    // collect search responses for sequence number 'seq' until none arrive for the receive timeout
+    size_t receive(pvd::int32 seq, std::set<pvd::int32>& cids)
+    {
+        size_t nresponses = 0;
+        char buf[2048];
+        int ret;
+        while((ret=::recv(sock, buf, sizeof(buf), 0)) > 0) {
+            const char *pos = buf, *end = buf+ret;
+            while(end-pos >= pva::PVA_MESSAGE_HEADER_SIZE) {
+                const bool big = (pos[2]&0x80)!=0;
+                const pvd::int8 cmd = pos[3];
+                const pvd::int32 psize = get32(pos+4, big);
+                const char *body = pos+pva::PVA_MESSAGE_HEADER_SIZE;
+                if(psize<0 || end-body < psize)
+                    break;
+                pos = body+psize;
+
+                // GUID, sequence, address, port, "tcp", found, count
+                if(cmd!=pva::CMD_SEARCH_RESPONSE || psize < 12+4+16+2+4+1+2)
+                    continue;
+                if(get32(body+12, big)!=seq)
+                    continue;
+                const char *p = body+12+4+16+2;
+                p += 1+(unsigned char)p[0];
+                const bool found = p[0]!=0;
+                const pvd::int16 count = get16(p+1, big);
+                p += 3;
+                nresponses++;
+
+                testDiag("response found=%d with %d CIDs", found, count);
+                for(pvd::int16 i=0; i<count && end-p>=4; i++, p+=4) {
+                    if(found)
+                        cids.insert(get32(p, big));
+                }
+            }
+        }
+        return nresponses;
+    }
+};
+
+std::vector<std::string> searchNames(const char* prefix)
+{
+    std::vector<std::string> names;
+    for(size_t i=0; i<nnames; i++) {
+        char name[16];
+        epicsSnprintf(name, sizeof(name), "%s%u", prefix, unsigned(i));
+        names.push_back(name);
+    }
+    names.push_back("pv:nonexistent");
+    return names;
+}
+
+pva::ServerContext::shared_pointer startServer(const pva::ChannelProvider::shared_pointer& prov)
+{
+    return pva::ServerContext::create(pva::ServerContext::Config()
+                                      .provider(prov)
+                                      .config(testLoopbackConfig()
+                                              .push_map()
+                                              .build()));
+}
+
+void testSync()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+
+    pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(
+                                 pvd::getFieldCreate()->createFieldBuilder()
+                                 ->add("value", pvd::pvInt)
+                                 ->createStructure()));
+
+    std::vector<std::string> names(searchNames("pv:s"));
+    for(size_t i=0; i<nnames; i++) {
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+        pv->open(*inst);
+        prov->add(names[i], pv);
+    }
+
+    pva::ServerContext::shared_pointer server(startServer(prov->provider()));
+
+    Searcher searcher;
+    searcher.search(server->getBroadcastPort(), 42, names);
+
+    std::set<pvd::int32> cids;
+    testEqual(searcher.receive(42, cids), 1u);
+    testEqual(cids.size(), nnames);
+    testOk1(cids.size()==nnames && *cids.begin()==100 && *cids.rbegin()==pvd::int32(100+nnames-1));
+}
+
+void testAsync()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    DeferredProvider::shared_pointer prov(new DeferredProvider);
+    prov->internal_self = prov;
+
+    pva::ServerContext::shared_pointer server(startServer(prov));
+
+    std::vector<std::string> names(searchNames("pv:a"));
+
+    Searcher searcher;
+    searcher.search(server->getBroadcastPort(), 43, names);
+
+    // wait for the server to ask about every name
+    for(unsigned i=0; i<100 && prov->npending()<nnames; i++)
+        epicsThreadSleep(0.01);
+    testEqual(prov->npending(), nnames);
+
+    // answers arriving within the batch delay go in one response
+    prov->answerAll();
+
+    std::set<pvd::int32> cids;
+    testEqual(searcher.receive(43, cids), 1u);
+    testEqual(cids.size(), nnames);
+    testOk1(cids.size()==nnames && *cids.begin()==100 && *cids.rbegin()==pvd::int32(100+nnames-1));
+}
+
+} // namespace
+
+MAIN(testSearchBatch)
+{
+    testPlan(7);
+    try {
+        testSync();
+        testAsync();
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Client and server on the same host, with and without shared memory.
+ */
+
+#include <string.h>
+#include <vector>
+
+#include <epicsTime.h>
+#include <osiSock.h>
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/shmRing.h>
+#include <pv/remote.h>
+#include <pv/current_function.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+void testRing()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    if(!pva::ShmRing::supported()) {
+        testSkip(8, "No shared memory");
+        return;
+    }
+
+    pva::ShmRing::shared_pointer A(pva::ShmRing::create(1000u));
+    testOk1(!!A);
+    if(!A) {
+        testSkip(7, "create() fails");
+        return;
+    }
+    pva::ShmRing::shared_pointer B(pva::ShmRing::open(A->token()));
+    testOk1(!!B);
+    testOk1(!pva::ShmRing::open(A->token()+1u));
+    if(!B) {
+        testSkip(5, "open() fails");
+        return;
+    }
+
+    const size_t cap = A->capacity();
+    std::vector<char> out(cap+10u), in(cap+10u);
+    for(size_t i=0; i<out.size(); i++)
+        out[i] = char(i*7u);
+
+    // only fills
+    testEqual(A->write(pva::ShmRing::ClientToServer, &out[0], out.size()), cap);
+    testEqual(B->readable(pva::ShmRing::ClientToServer), cap);
+
+    testEqual(B->read(pva::ShmRing::ClientToServer, &in[0], cap/2u), cap/2u);
+
+    // wraps around the end
+    A->write(pva::ShmRing::ClientToServer, &out[cap], 10u);
+    size_t n = B->read(pva::ShmRing::ClientToServer, &in[cap/2u], in.size());
+    testOk(n==cap-cap/2u+10u && memcmp(&in[0], &out[0], out.size())==0, "read back %u", unsigned(n));
+
+    A->unlink();
+    testOk1(!pva::ShmRing::open(A->token()));
+}
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->addArray("value", pvd::pvDouble)
+                                  ->createStructure());
+
+void testTransport(size_t shmSize)
+{
+    testDiag("==== %s shmSize=%u ====", CURRENT_FUNCTION, unsigned(shmSize));
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildMailbox());
+    pv->open(type);
+    prov->add("pv:name", pv);
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .push_map()
+                                                          .build())));
+
+    pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                             .push_config(server->getCurrentConfig())
+                             .add("EPICS_PVA_SHM_SIZE", unsigned(shmSize))
+                             .push_map()
+                             .build());
+    pvac::ClientChannel chan(cli.connect("pv:name"));
+
+    testOk1(!!chan.get(5.0));
+
+    // larger than the ring
+    pvd::shared_vector<double> arr(1024u*1024u);
+    for(size_t i=0; i<arr.size(); i++)
+        arr[i] = double(i);
+    pvd::shared_vector<const double> expect(pvd::freeze(arr));
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+
+    bool ok = true;
+    for(unsigned i=0; i<10u; i++) {
+        chan.put().set("value", expect).exec(10.0);
+        pvd::shared_vector<const double> actual(chan.get(10.0)->getSubFieldT<pvd::PVDoubleArray>("value")->view());
+        ok &= actual.size()==expect.size() && memcmp(actual.data(), expect.data(), expect.size()*sizeof(double))==0;
+    }
+
+    epicsTimeGetCurrent(&end);
+
+    testOk(ok, "array round trip");
+    testDiag("  %.3f sec. for 10 put+get of %u bytes", epicsTimeDiffInSeconds(&end, &start),
+             unsigned(expect.size()*sizeof(double)));
+}
+
+// the server disconnects a peer which offers a segment that doesn't exist
+void testBadOffer()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .push_map()
+                                                          .build())));
+
+    SOCKET sock = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(sock==INVALID_SOCKET)
+        testAbort("Unable to create socket");
+
+    osiSockAddr addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.ia.sin_port = htons(server->getServerPort());
+
+    // don't hang if the server never closes
+    timeval timo;
+    timo.tv_sec = 10;
+    timo.tv_usec = 0;
+    (void)setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&timo, sizeof(timo));
+
+    testOk1(::connect(sock, &addr.sa, sizeof(addr.ia))==0);
+
+    // control message, little endian, from client.  Token (payload size field) 0x00000001
+    const char offer[8] = {char(0xca), 2, 0x01, char(pva::CMD_SHM_OFFER), 1, 0, 0, 0};
+    (void)::send(sock, offer, sizeof(offer), 0);
+
+    // discard connection validation request until closed (0) or timeout (<0)
+    char buf[256];
+    int ret;
+    while((ret=::recv(sock, buf, sizeof(buf), 0)) > 0) {}
+
+    testOk(ret==0, "Closed by server");
+
+    epicsSocketDestroy(sock);
+}
+
+} // namespace
+
+MAIN(testShmTransport)
+{
+    testPlan(14);
+    try {
+        testRing();
+        testTransport(0u);
+        testTransport(1024u*1024u);
+        if(pva::ShmRing::supported())
+            testBadOffer();
+        else
+            testSkip(2, "No shared memory");
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <cstring>
+
+#include <osiSock.h>
+#include <epicsTime.h>
+
+#include <pv/pvUnitTest.h>
+#include <pv/epicsException.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/transportReactor.h>
+#include <pv/current_function.h>
+
+#include "testLoopback.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->addArray("wave", pvd::pvDouble)
+                                  ->createStructure());
+
+// large enough to be segmented, and to need several reads
+const size_t waveLen = 1024u*1024u;
+
+void testLoopback(unsigned serverThreads, unsigned clientThreads)
+{
+    testDiag("==== %s server=%u client=%u ====", CURRENT_FUNCTION, serverThreads, clientThreads);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildMailbox());
+
+    prov->add("pv:name", pv);
+
+    {
+        pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(type));
+        pvd::PVDoubleArray::svector wave(waveLen);
+        for(size_t i=0; i<wave.size(); i++)
+            wave[i] = double(i);
+        inst->getSubFieldT<pvd::PVDoubleArray>("wave")->replace(pvd::freeze(wave));
+        inst->getSubFieldT<pvd::PVScalar>("value")->putFrom<pvd::int32>(42);
+        pv->open(*inst);
+    }
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .add("EPICS_PVAS_IO_THREADS", serverThreads)
+                                                          .push_map()
+                                                          .build())));
+
+    pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                             .push_config(server->getCurrentConfig())
+                             .add("EPICS_PVA_IO_THREADS", clientThreads)
+                             .push_map()
+                             .build());
+
+    pvac::ClientChannel chan(cli.connect("pv:name"));
+
+    {
+        pvd::PVStructure::const_shared_pointer R(chan.get());
+
+        testEqual(R->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>(), 42);
+        pvd::PVDoubleArray::const_svector wave(R->getSubFieldT<pvd::PVDoubleArray>("wave")->view());
+        testEqual(wave.size(), waveLen);
+        bool match = wave.size()==waveLen;
+        for(size_t i=0; match && i<wave.size(); i++)
+            match = wave[i]==double(i);
+        testOk(match, "wave content");
+    }
+
+    pvac::MonitorSync mon(chan.monitor());
+
+    testOk1(mon.wait(5.0));
+    testOk1(mon.poll());
+
+    chan.put()
+        .set<pvd::int32>("value", 43)
+        .exec();
+
+    testOk1(mon.wait(5.0));
+    {
+        bool poll = mon.poll();
+        testOk1(poll);
+        if(poll)
+            testEqual(mon.root->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>(), 43);
+        else
+            testSkip(1, "No data");
+    }
+
+    {
+        pvd::PVStructure::const_shared_pointer R(chan.get());
+        testEqual(R->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>(), 43);
+    }
+}
+
+// a peer which connects, but never sends anything, is disconnected after $EPICS_PVA_CONN_TMO*4/3
+void testIdleTimeout()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .add("EPICS_PVA_CONN_TMO", "1.0")
+                                                          .add("EPICS_PVAS_IO_THREADS", "1")
+                                                          .push_map()
+                                                          .build())));
+
+    SOCKET sock = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(sock==INVALID_SOCKET)
+        testAbort("Unable to create socket");
+
+    osiSockAddr addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.ia.sin_port = htons(server->getServerPort());
+
+    // don't hang if the server never closes
+    timeval timo;
+    timo.tv_sec = 10;
+    timo.tv_usec = 0;
+    (void)setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&timo, sizeof(timo));
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+
+    testOk1(::connect(sock, &addr.sa, sizeof(addr.ia))==0);
+
+    // discard connection validation request until closed (0) or timeout (<0)
+    char buf[256];
+    int ret;
+    while((ret=::recv(sock, buf, sizeof(buf), 0)) > 0) {}
+
+    epicsTimeGetCurrent(&end);
+    double elapsed = epicsTimeDiffInSeconds(&end, &start);
+
+    testOk(ret==0, "Closed by server after %.1f sec", elapsed);
+    testOk(elapsed < 8.0, "Closed after %.1f sec", elapsed);
+
+    epicsSocketDestroy(sock);
+}
+
+} // namespace
+
+MAIN(testTransportReactor)
+{
+    testPlan(9*4+3);
+    try {
+        testLoopback(0u, 0u);
+        if(pva::TransportReactor::isSupported()) {
+            testLoopback(2u, 0u);
+            testLoopback(0u, 1u);
+            testLoopback(1u, 2u);
+            testIdleTimeout();
+        } else {
+            testSkip(9*3+3, "TransportReactor not supported");
+        }
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
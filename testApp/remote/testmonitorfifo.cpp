@@ -9,6 +9,7 @@
 #include <testMain.h>
 #include <epicsMutex.h>
 #include <epicsGuard.h>
+#include <epicsThread.h>
 
 #include <pv/pvAccess.h>
 #include <pv/current_function.h>
@@ -793,11 +794,218 @@ void checkBadRequest()
     tester.testTimeline({});
 }
 
+// changes smaller than the deadband are not queued
+void checkDeadband()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+    Tester tester(pvd::createRequest("field(value[deadband=abs:2])"), 0);
+
+    tester.connect(pvd::pvInt);
+    tester.mon->notify();
+    tester.testTimeline({Tester::Connect});
+
+    tester.mon->start();
+
+    tester.post(0);
+    tester.post(1); // ignored
+    tester.post(3);
+    tester.post(4); // ignored
+    tester.mon->notify();
+    tester.testTimeline({Tester::Event});
+
+    testPop(*tester.mon, 0);
+    testPop(*tester.mon, 3);
+    testEmpty(*tester.mon);
+
+    tester.mon->stop();
+    tester.close();
+    tester.mon->notify();
+    tester.testTimeline({Tester::Close});
+}
+
+// an update which tryPost() could not queue does not move the deadband
+void checkDeadbandFull()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+    pva::MonitorFIFO::Config conf;
+    conf.maxCount=2;
+    conf.defCount=2;
+    Tester tester(pvd::createRequest("field(value[deadband=abs:2])"), &conf);
+
+    tester.connect(pvd::pvInt);
+    tester.mon->notify();
+    tester.testTimeline({Tester::Connect});
+
+    tester.mon->start();
+
+    tester.tryPost(0, true);
+    tester.tryPost(10, false); // now full
+    tester.tryPost(20, false); // not queued
+    tester.mon->notify();
+    tester.testTimeline({Tester::Event});
+
+    testPop(*tester.mon, 0);
+    testPop(*tester.mon, 10);
+    testEmpty(*tester.mon);
+    tester.reset();
+
+    tester.post(19); // compared with 10, not 20
+    testPop(*tester.mon, 19);
+    testEmpty(*tester.mon);
+
+    tester.mon->stop();
+    tester.close();
+    tester.mon->notify();
+    tester.reset();
+}
+
+// updates squashed while waiting for the rate limit to expire
+void checkRateLimit()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+    Tester tester(pvd::createRequest("record[rateLimit=0.2]field()"), 0);
+
+    tester.connect(pvd::pvInt);
+    tester.mon->notify();
+    tester.testTimeline({Tester::Connect});
+
+    tester.mon->start();
+
+    tester.post(1);
+    tester.mon->notify();
+    tester.testTimeline({Tester::Event});
+
+    testPop(*tester.mon, 1);
+
+    tester.post(2);
+    tester.post(3);
+    tester.mon->notify();
+    tester.testTimeline({Tester::Event});
+
+    testEmpty(*tester.mon); // too soon
+
+    epicsThreadSleep(0.5);
+    {
+        Guard G(tester.requester->mutex);
+        tester.testTimeline({Tester::Event}); // from timer
+    }
+
+    testPop(*tester.mon, 3, true);
+    testEmpty(*tester.mon);
+
+    tester.mon->stop();
+    tester.close();
+    tester.mon->notify();
+    tester.testTimeline({Tester::Close});
+}
+
+// tryPost() also squashes updates while waiting for the rate limit to expire
+void checkRateLimitTryPost()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+    Tester tester(pvd::createRequest("record[rateLimit=0.2]field()"), 0);
+
+    tester.connect(pvd::pvInt);
+    tester.mon->notify();
+    tester.testTimeline({Tester::Connect});
+
+    tester.mon->start();
+
+    tester.tryPost(1, true);
+    tester.mon->notify();
+    tester.testTimeline({Tester::Event});
+
+    testPop(*tester.mon, 1);
+
+    tester.tryPost(2, true);
+    tester.tryPost(3, true);
+    tester.mon->notify();
+    tester.testTimeline({Tester::Event});
+
+    testEmpty(*tester.mon); // too soon
+
+    epicsThreadSleep(0.5);
+    {
+        Guard G(tester.requester->mutex);
+        tester.testTimeline({Tester::Event}); // from timer
+    }
+
+    testPop(*tester.mon, 3, true);
+    testEmpty(*tester.mon);
+
+    tester.mon->stop();
+    tester.close();
+    tester.mon->notify();
+    tester.testTimeline({Tester::Close});
+}
+
+// post(snapshot) shares the snapshot with subscribers which request all fields
+void checkShared()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                ->add("value", pvd::pvInt)
+                                ->addArray("wave", pvd::pvDouble)
+                                ->createStructure());
+
+    Tester A(pvReqEmpty, 0), B(pvReqEmpty, 0), C(pvd::createRequest("field(value)"), 0);
+    Tester* testers[] = {&A, &B, &C};
+
+    for(size_t i=0; i<3; i++) {
+        testers[i]->type = type;
+        testers[i]->mon->open(type);
+        testers[i]->mon->notify();
+        testers[i]->mon->start();
+    }
+    Tester::timeline.clear();
+
+    pvd::PVStructurePtr snapshot(pvd::getPVDataCreate()->createPVStructure(type));
+    pvd::PVScalarPtr value(snapshot->getSubFieldT<pvd::PVScalar>("value"));
+    pvd::PVDoubleArrayPtr wave(snapshot->getSubFieldT<pvd::PVDoubleArray>("wave"));
+    {
+        pvd::PVDoubleArray::svector W(3, 1.0);
+        wave->replace(pvd::freeze(W));
+    }
+    value->putFrom<pvd::int32>(5);
+    pvd::BitSet changed;
+    changed.set(value->getFieldOffset());
+    changed.set(wave->getFieldOffset());
+
+    for(size_t i=0; i<3; i++)
+        testers[i]->mon->post(pvd::PVStructure::const_shared_pointer(snapshot), changed);
+
+    {
+        pva::MonitorElement::Ref a(*A.mon), b(*B.mon), c(*C.mon);
+
+        if(!a || !b || !c) {
+            testFail("Queue unexpected empty");
+            testSkip(4, "No data");
+        } else {
+            testOk1(a->pvStructurePtr==snapshot);
+            testOk1(b->pvStructurePtr==snapshot);
+            testOk1(c->pvStructurePtr!=snapshot);
+            testEqual(c->pvStructurePtr->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>(), 5);
+            testOk1(!c->changedBitSet->get(wave->getFieldOffset()));
+        }
+    }
+
+    // re-use of an element which references the snapshot must not modify it
+    A.post(6);
+    testPop(*A.mon, 6);
+    testEqual(value->getAs<pvd::int32>(), 5);
+
+    for(size_t i=0; i<3; i++) {
+        testers[i]->close();
+        testers[i]->mon->notify();
+    }
+}
+
 } // namespace
 
 MAIN(testmonitorfifo)
 {
-    testPlan(189);
+    testPlan(233);
     checkPlain();
     checkAfterClose();
     checkReOpenLost();
@@ -808,6 +1016,11 @@ MAIN(testmonitorfifo)
     checkSpam();
     checkCountdown();
     checkBadRequest();
+    checkShared();
+    checkDeadband();
+    checkDeadbandFull();
+    checkRateLimit();
+    checkRateLimitTryPost();
     return testDone();
 }
 
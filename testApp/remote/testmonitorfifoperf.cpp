@@ -0,0 +1,110 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Throughput of MonitorFIFO post()/poll()/release()
+ */
+
+#include <vector>
+#include <sstream>
+
+#include <epicsTime.h>
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pv/pvAccess.h>
+#include <pv/createRequest.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvDouble)
+                                  ->add("counter", pvd::pvUInt)
+                                  ->createStructure());
+
+struct Requester : public pva::MonitorRequester {
+    POINTER_DEFINITIONS(Requester);
+    virtual ~Requester() {}
+    virtual std::string getRequesterName() OVERRIDE FINAL {return "Requester";}
+    virtual void channelDisconnect(bool destroy) OVERRIDE FINAL {}
+    virtual void monitorConnect(pvd::Status const & status,
+                                pva::MonitorPtr const & monitor, pvd::StructureConstPtr const & structure) OVERRIDE FINAL {}
+    virtual void monitorEvent(pva::MonitorPtr const & monitor) OVERRIDE FINAL {}
+    virtual void unlisten(pva::MonitorPtr const & monitor) OVERRIDE FINAL {}
+};
+
+// post 'batch' updates, then poll()/release() all.  Repeat.
+void benchmark(size_t queueSize, size_t batch, bool pipeline)
+{
+    const size_t niter = 200000u/batch;
+
+    std::ostringstream req;
+    req<<"record[queueSize="<<queueSize<<",pipeline="<<(pipeline?"true":"false")<<"]field()";
+
+    Requester::shared_pointer requester(new Requester);
+    pva::MonitorFIFO::Config conf;
+    conf.maxCount = queueSize;
+    pva::MonitorFIFO::shared_pointer mon(new pva::MonitorFIFO(requester, pvd::createRequest(req.str()),
+                                                             pva::MonitorFIFO::Source::shared_pointer(),
+                                                             &conf));
+    mon->open(type);
+    mon->notify();
+    mon->start();
+    if(pipeline)
+        mon->reportRemoteQueueStatus(pvd::int32(queueSize));
+
+    pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(type));
+    pvd::PVScalarPtr counter(value->getSubFieldT<pvd::PVScalar>("counter"));
+    pvd::BitSet changed;
+    changed.set(counter->getFieldOffset());
+
+    size_t nposted = 0u, npolled = 0u;
+    pvd::uint32 expect = 0u;
+    bool ordered = true;
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+
+    for(size_t i=0; i<niter; i++) {
+        for(size_t n=0; n<batch; n++) {
+            counter->putFrom<pvd::uint32>(pvd::uint32(nposted++));
+            mon->post(*value, changed);
+        }
+        mon->notify();
+
+        while(pva::MonitorElementPtr elem = mon->poll()) {
+            ordered &= elem->pvStructurePtr->getSubFieldT<pvd::PVScalar>("counter")->getAs<pvd::uint32>()==expect++;
+            npolled++;
+            mon->release(elem);
+        }
+        if(pipeline)
+            mon->reportRemoteQueueStatus(pvd::int32(batch));
+    }
+
+    epicsTimeGetCurrent(&end);
+
+    testOk(ordered && nposted==npolled, "queueSize=%u batch=%u pipeline=%c posted=%u polled=%u",
+           unsigned(queueSize), unsigned(batch), pipeline?'Y':'N', unsigned(nposted), unsigned(npolled));
+    testDiag("  %.3f us per update", epicsTimeDiffInSeconds(&end, &start)*1e6/nposted);
+
+    mon->close();
+    mon->notify();
+}
+
+} // namespace
+
+MAIN(testmonitorfifoperf)
+{
+    testPlan(6);
+    // batch < queueSize so no updates are squashed
+    benchmark(4u, 1u, false);
+    benchmark(64u, 32u, false);
+    benchmark(1024u, 512u, false);
+    benchmark(4u, 1u, true);
+    benchmark(64u, 32u, true);
+    benchmark(1024u, 512u, true);
+    return testDone();
+}
@@ -3,14 +3,23 @@
  * found in the file LICENSE that is included with the distribution
  */
 
+#include <iterator>
+#include <sstream>
+
+#include <epicsTime.h>
+#include <epicsThread.h>
 #include <pv/pvUnitTest.h>
 #include <testMain.h>
 
 #include <pva/client.h>
+#include <pva/server.h>
 #include <pva/sharedstate.h>
+#include <pv/serverContext.h>
 #include <pv/current_function.h>
 //#include <pv/pvAccess.h>
 
+#include "testLoopback.h"
+
 namespace pvd = epics::pvData;
 namespace pva = epics::pvAccess;
 
@@ -186,16 +195,263 @@ void testPutRPC()
     testEqual(reply->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::uint32>(), 100u);
 }
 
+// several updates queued for one subscription, sent in batches over TCP
+void testMonitorBatch()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+
+    prov->add("pv:name", pv);
+
+    pv->open(type);
+
+    pva::ServerContext::shared_pointer server(pva::ServerContext::create(
+                                                  pva::ServerContext::Config()
+                                                  .provider(prov->provider())
+                                                  .config(testLoopbackConfig()
+                                                          .add("EPICS_PVAS_MONITOR_BATCH", "4")
+                                                          .push_map()
+                                                          .build())));
+
+    testEqual(server->getCurrentConfig()->getPropertyAsInteger("EPICS_PVAS_MONITOR_BATCH", 0), 4);
+
+    pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                             .push_config(server->getCurrentConfig())
+                             .push_map()
+                             .build());
+
+    pvac::ClientChannel chan(cli.connect("pv:name"));
+
+    pvac::MonitorSync mon(chan.monitor(pvd::createRequest("record[queueSize=20]field()")));
+
+    testOk1(mon.wait(5.0) && mon.poll());
+
+    pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(type));
+    pvd::BitSet changed;
+    pvd::PVScalarPtr value(inst->getSubFieldT<pvd::PVScalar>("value"));
+    changed.set(value->getFieldOffset());
+
+    for(pvd::uint32 i=1; i<=10; i++) {
+        value->putFrom(i);
+        pv->post(*inst, changed);
+    }
+
+    pvd::uint32 last = 0;
+    bool ordered = true;
+    unsigned count = 0;
+    while(last<10u && mon.wait(5.0)) {
+        while(mon.poll()) {
+            pvd::uint32 cur = mon.root->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::uint32>();
+            ordered &= cur>last;
+            last = cur;
+            count++;
+        }
+    }
+    testDiag("Received %u updates", count);
+    testOk1(ordered);
+    testEqual(last, 10u);
+}
+
+struct FindRequester : public pva::ChannelFindRequester
+{
+    bool found;
+    FindRequester() :found(false) {}
+    virtual ~FindRequester() {}
+    virtual void channelFindResult(const pvd::Status& status,
+                                   const pva::ChannelFind::shared_pointer& channelFind,
+                                   bool wasFound) OVERRIDE FINAL
+    {
+        found = wasFound;
+    }
+};
+
+bool isFound(const pvas::StaticProvider& prov, const std::string& name)
+{
+    std::tr1::shared_ptr<FindRequester> req(new FindRequester);
+    prov.provider()->channelFind(name, req);
+    return req->found;
+}
+
+void testBulkAddRemove()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    const size_t npvs = 100000u;
+
+    pvas::StaticProvider prov("test");
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+    pv->open(type);
+
+    pvas::StaticProvider::builder_list_t pvs;
+    std::vector<std::string> names;
+    // reverse order
+    for(size_t i=npvs; i>0u; i--) {
+        std::ostringstream strm;
+        strm<<"bulk:"<<(i-1u);
+        pvs.push_back(std::make_pair(strm.str(), pv));
+        if((i-1u)%2u)
+            names.push_back(strm.str()); // odd
+    }
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+    prov.add(pvs);
+    epicsTimeGetCurrent(&end);
+    testDiag("add() %u PVs in %.3f sec.", unsigned(npvs), epicsTimeDiffInSeconds(&end, &start));
+
+    testEqual(size_t(std::distance(prov.begin(), prov.end())), npvs);
+    testOk1(isFound(prov, "bulk:0"));
+    testOk1(isFound(prov, "bulk:99999"));
+    testOk1(!isFound(prov, "bulk:100000"));
+
+    {
+        pvas::StaticProvider::builder_list_t more;
+        more.push_back(std::make_pair("bulk:new", pv));
+        more.push_back(std::make_pair("bulk:42", pv));
+        testThrows(std::logic_error, prov.add(more));
+        testOk1(!isFound(prov, "bulk:new"));
+
+        more.pop_back();
+        more.push_back(std::make_pair("bulk:new", pv));
+        testThrows(std::logic_error, prov.add(more));
+        testOk1(!isFound(prov, "bulk:new"));
+    }
+
+    epicsTimeGetCurrent(&start);
+    for(size_t i=0; i<npvs; i++)
+        isFound(prov, pvs[i].first);
+    epicsTimeGetCurrent(&end);
+    testDiag("channelFind() %.3f us per name", epicsTimeDiffInSeconds(&end, &start)*1e6/npvs);
+
+    prov.remove(names);
+    testEqual(size_t(std::distance(prov.begin(), prov.end())), npvs/2u);
+    testOk1(isFound(prov, "bulk:0"));
+    testOk1(!isFound(prov, "bulk:1"));
+
+    pvac::ClientProvider cli(prov.provider());
+    testEqual(cli.connect("bulk:42").get()->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>(), 0);
+    testThrows(std::runtime_error, cli.connect("bulk:43").get(0.5));
+}
+
+struct CountingHandler : public pvas::DynamicProvider::Handler
+{
+    size_t count;
+    // when set, invalidate() during each search.  Only invalidateName if not empty.
+    pvas::DynamicProvider *invalidating;
+    std::string invalidateName;
+    CountingHandler() :count(0u), invalidating(0) {}
+    virtual ~CountingHandler() {}
+    virtual void hasChannels(pvas::DynamicProvider::search_type& names) OVERRIDE FINAL
+    {
+        if(invalidating && invalidateName.empty())
+            invalidating->invalidate();
+        else if(invalidating)
+            invalidating->invalidate(invalidateName);
+        for(size_t i=0; i<names.size(); i++) {
+            count++;
+            if(names[i].name().compare(0, 4, "yes:")==0)
+                names[i].claim();
+        }
+    }
+    virtual std::tr1::shared_ptr<epics::pvAccess::Channel> createChannel(const std::tr1::shared_ptr<epics::pvAccess::ChannelProvider>& provider,
+                                                                         const std::string& name,
+                                                                         const std::tr1::shared_ptr<epics::pvAccess::ChannelRequester>& requester) OVERRIDE FINAL
+    {
+        return std::tr1::shared_ptr<epics::pvAccess::Channel>();
+    }
+};
+
+bool isFound(const pvas::DynamicProvider& prov, const std::string& name)
+{
+    std::tr1::shared_ptr<FindRequester> req(new FindRequester);
+    prov.provider()->channelFind(name, req);
+    return req->found;
+}
+
+void testDynamicCache()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<CountingHandler> handler(new CountingHandler);
+    pvas::DynamicProvider::CacheConfig conf;
+    conf.maxEntries = 2u;
+    conf.positiveTTL = 1000.0;
+    conf.negativeTTL = 0.1;
+    pvas::DynamicProvider prov("test", handler, conf);
+
+    testOk1(isFound(prov, "yes:one"));
+    testOk1(!isFound(prov, "no:one"));
+    testEqual(handler->count, 2u);
+
+    // cached
+    testOk1(isFound(prov, "yes:one"));
+    testOk1(!isFound(prov, "no:one"));
+    testEqual(handler->count, 2u);
+
+    {
+        pvas::DynamicProvider::CacheStats stats(prov.cacheStats());
+        testEqual(stats.hits, 2u);
+        testEqual(stats.misses, 2u);
+        testEqual(stats.entries, 2u);
+    }
+
+    // negative result expires
+    epicsThreadSleep(0.2);
+    testOk1(!isFound(prov, "no:one"));
+    testOk1(isFound(prov, "yes:one"));
+    testEqual(handler->count, 3u);
+
+    // "no:one" was used least recently, so is forgotten
+    testOk1(isFound(prov, "yes:two"));
+    testEqual(prov.cacheStats().entries, 2u);
+    testOk1(isFound(prov, "yes:one"));
+    testOk1(!isFound(prov, "no:one"));
+    testEqual(handler->count, 5u);
+
+    prov.invalidate("yes:one");
+    testOk1(isFound(prov, "yes:one"));
+    testEqual(handler->count, 6u);
+
+    prov.invalidate();
+    testEqual(prov.cacheStats().entries, 0u);
+    testOk1(isFound(prov, "yes:one"));
+    testEqual(handler->count, 7u);
+
+    // result of a search which raced with invalidate() is not cached
+    handler->invalidating = &prov;
+    testOk1(isFound(prov, "yes:three"));
+    handler->invalidating = 0;
+    testEqual(prov.cacheStats().entries, 0u);
+    testOk1(isFound(prov, "yes:three"));
+    testEqual(handler->count, 9u);
+
+    // invalidate(name) only affects a search for that name
+    prov.invalidate();
+    handler->invalidating = &prov;
+    handler->invalidateName = "yes:three";
+    testOk1(isFound(prov, "yes:four"));
+    testOk1(isFound(prov, "yes:three"));
+    handler->invalidating = 0;
+    testEqual(prov.cacheStats().entries, 1u);
+    testOk1(isFound(prov, "yes:four"));
+    testEqual(handler->count, 11u);
+}
+
 } // namespace
 
 MAIN(testsharedstate)
 {
-    testPlan(19);
+    testPlan(67);
     try {
         testNoClient();
         testGetMon();
         testPutRPCCancel();
         testPutRPC();
+        testMonitorBatch();
+        testBulkAddRemove();
+        testDynamicCache();
     }catch(std::exception& e){
         testAbort("Unexpected exception: %s", e.what());
     }
@@ -8,9 +8,13 @@
 
 #include <pv/fairQueue.h>
 
+#include <epicsAtomic.h>
+#include <epicsTime.h>
 #include <epicsUnitTest.h>
 #include <testMain.h>
 
+#include <pv/thread.h>
+
 namespace {
 
 struct Qnode : public epics::pvAccess::fair_queue<Qnode>::entry {
@@ -18,22 +22,28 @@ struct Qnode : public epics::pvAccess::fair_queue<Qnode>::entry {
     Qnode(unsigned i):i(i) {}
 };
 
+struct QnodeMPSC : public epics::pvAccess::fair_queue_mpsc<QnodeMPSC>::entry {
+    unsigned i;
+    QnodeMPSC(unsigned i):i(i) {}
+};
+
 } // namespace
 
 static unsigned Ninput[]  = {0,0,0,1,0,2,1,0,1,0,0};
 static unsigned Nexpect[] = {0,1,2,0,1,0,1,0,0,0,0};
 
+template<typename Queue, typename Node>
 static
 void testOrder()
 {
-    epics::pvAccess::fair_queue<Qnode> Q;
-    typedef epics::pvAccess::fair_queue<Qnode>::value_type value_type;
+    Queue Q;
+    typedef typename Queue::value_type value_type;
 
     std::vector<value_type> unique, inputs, outputs;
     unique.resize(3);
-    unique[0].reset(new Qnode(0));
-    unique[1].reset(new Qnode(1));
-    unique[2].reset(new Qnode(2));
+    unique[0].reset(new Node(0));
+    unique[1].reset(new Node(1));
+    unique[2].reset(new Node(2));
 
     testDiag("Queueing");
 
@@ -67,9 +77,100 @@ void testOrder()
     }
 }
 
+namespace {
+
+static const unsigned nproducers = 4;
+static const unsigned nsenders = 16; // per producer
+static const unsigned npushes = 20000; // per producer
+
+template<typename Queue>
+struct Contention {
+    typedef typename Queue::value_type value_type;
+
+    Queue Q;
+    std::vector<value_type> nodes;
+    int ndone;
+
+    struct Producer {
+        Contention *self;
+        unsigned index;
+        void run()
+        {
+            for(unsigned n=0; n<npushes; n++)
+                self->Q.push_back(self->nodes[index*nsenders + n%nsenders]);
+            epics::atomic::increment(self->ndone);
+        }
+    };
+
+    Contention() :ndone(0) {}
+
+    // returns number popped
+    size_t run(double *elapsed)
+    {
+        nodes.resize(nproducers*nsenders);
+        for(size_t i=0; i<nodes.size(); i++)
+            nodes[i].reset(new typename value_type::element_type(i));
+
+        std::vector<Producer> producers(nproducers);
+        std::vector<std::tr1::shared_ptr<epics::pvData::Thread> > threads(nproducers);
+
+        epicsTimeStamp start, end;
+        epicsTimeGetCurrent(&start);
+
+        for(unsigned p=0; p<nproducers; p++) {
+            producers[p].self = this;
+            producers[p].index = p;
+            threads[p].reset(new epics::pvData::Thread(epics::pvData::Thread::Config(&producers[p], &Producer::run)
+                                                       .name("producer")));
+        }
+
+        // pop until all producers are done, then drain
+        size_t npopped = 0;
+        value_type E;
+        while(true) {
+            if(Q.pop_front(E, 0.1))
+                npopped++;
+            else if(epics::atomic::get(ndone)==int(nproducers))
+                break;
+        }
+
+        for(unsigned p=0; p<nproducers; p++)
+            threads[p]->exitWait();
+
+        while(Q.pop_front_try(E))
+            npopped++;
+
+        epicsTimeGetCurrent(&end);
+        *elapsed = epicsTimeDiffInSeconds(&end, &start);
+
+        nodes.clear();
+        return npopped;
+    }
+};
+
+template<typename Queue>
+void testContention(const char *name)
+{
+    testDiag("Contention %s: %u producers", name, nproducers);
+
+    Contention<Queue> C;
+    double elapsed = 0.0;
+    size_t npopped = C.run(&elapsed);
+
+    // loss-less, one pop for each push
+    testOk(npopped==size_t(nproducers*npushes) && C.Q.empty(),
+           "%s popped %u of %u pushes, and empty", name, unsigned(npopped), nproducers*npushes);
+    testDiag("%s: %.3f us per push", name, elapsed*1e6/(nproducers*npushes));
+}
+
+} // namespace
+
 MAIN(testFairQueue)
 {
-    testPlan(12);
-    testOrder();
+    testPlan(26);
+    testOrder<epics::pvAccess::fair_queue<Qnode>, Qnode>();
+    testOrder<epics::pvAccess::fair_queue_mpsc<QnodeMPSC>, QnodeMPSC>();
+    testContention<epics::pvAccess::fair_queue<Qnode> >("fair_queue");
+    testContention<epics::pvAccess::fair_queue_mpsc<QnodeMPSC> >("fair_queue_mpsc");
     return testDone();
 }
@@ -0,0 +1,190 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+#include <sstream>
+
+#include <dbDefs.h>
+#include <epicsTime.h>
+#include <testMain.h>
+
+#include <pv/pvUnitTest.h>
+#include <pv/pvData.h>
+#include <pv/byteBuffer.h>
+#include <pv/serialize.h>
+#include <pv/introspectionRegistry.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+// in-memory stand-in for a codec
+struct TestControl : public pvd::SerializableControl,
+                     public pvd::DeserializableControl
+{
+    pva::IntrospectionRegistry outgoing, incoming;
+
+    virtual ~TestControl() {}
+
+    virtual void flushSerializeBuffer() {}
+    virtual void ensureBuffer(std::size_t) {}
+    virtual bool directSerialize(pvd::ByteBuffer*, const char*, std::size_t, std::size_t) { return false; }
+    virtual void cachedSerialize(const std::tr1::shared_ptr<const pvd::Field>& field, pvd::ByteBuffer* buffer)
+    {
+        outgoing.serialize(field, buffer, this);
+    }
+
+    virtual void ensureData(std::size_t) {}
+    virtual bool directDeserialize(pvd::ByteBuffer*, char*, std::size_t, std::size_t) { return false; }
+    virtual std::tr1::shared_ptr<const pvd::Field> cachedDeserialize(pvd::ByteBuffer* buffer)
+    {
+        return incoming.deserialize(buffer, this);
+    }
+};
+
+pvd::StructureConstPtr makeType(size_t i)
+{
+    std::ostringstream name;
+    name<<"field"<<i;
+    return pvd::getFieldCreate()->createFieldBuilder()
+            ->setId("test_t")
+            ->add("value", pvd::pvDouble)
+            ->addNestedStructure("sub")
+                ->add(name.str(), pvd::pvInt)
+                ->addArray("arr", pvd::pvString)
+            ->endNested()
+            ->createStructure();
+}
+
+// returns type code
+pvd::int8 serializeOne(TestControl& ctrl, pvd::ByteBuffer& buf, const pvd::FieldConstPtr& type, pvd::int16* key=0)
+{
+    buf.clear();
+    ctrl.cachedSerialize(type, &buf);
+    buf.flip();
+    pvd::int8 code = buf.getByte();
+    if(key)
+        *key = buf.getShort();
+    return code;
+}
+
+void testHash()
+{
+    testDiag("==== testHash ====");
+
+    testOk1(pva::IntrospectionRegistry::hash(*makeType(1))==pva::IntrospectionRegistry::hash(*makeType(1)));
+    testOk1(pva::IntrospectionRegistry::hash(*makeType(1))!=pva::IntrospectionRegistry::hash(*makeType(2)));
+    testOk1(pva::IntrospectionRegistry::hash(*pvd::getFieldCreate()->createScalar(pvd::pvInt))
+            !=pva::IntrospectionRegistry::hash(*pvd::getFieldCreate()->createScalar(pvd::pvUInt)));
+
+    // hash must agree with Field::operator==
+    pvd::FieldCreatePtr create(pvd::getFieldCreate());
+    std::vector<pvd::FieldConstPtr> fields;
+    fields.push_back(create->createScalar(pvd::pvString));
+    fields.push_back(create->createBoundedString(8));
+    fields.push_back(create->createBoundedString(16));
+    fields.push_back(create->createScalarArray(pvd::pvInt));
+    fields.push_back(create->createFixedScalarArray(pvd::pvInt, 4));
+    fields.push_back(create->createBoundedScalarArray(pvd::pvInt, 4));
+    fields.push_back(makeType(1));
+    fields.push_back(makeType(1));
+    fields.push_back(create->createStructureArray(makeType(1)));
+    fields.push_back(create->createVariantUnion());
+    fields.push_back(create->createVariantUnionArray());
+
+    size_t nequal = 0u, nbad = 0u;
+    for(size_t i=0; i<fields.size(); i++) {
+        for(size_t j=0; j<fields.size(); j++) {
+            if(!(*fields[i]==*fields[j]))
+                continue;
+            nequal++;
+            if(pva::IntrospectionRegistry::hash(*fields[i])!=pva::IntrospectionRegistry::hash(*fields[j])) {
+                testDiag("%s == %s, but hash differs", fields[i]->getID().c_str(), fields[j]->getID().c_str());
+                nbad++;
+            }
+        }
+    }
+    testOk(nbad==0u, "%u of %u equal pairs hash differently", unsigned(nbad), unsigned(nequal));
+
+    // structure ID is compared
+    testOk1(pva::IntrospectionRegistry::hash(*makeType(1))
+            !=pva::IntrospectionRegistry::hash(*create->createFieldBuilder(makeType(1))->setId("other_t")->createStructure()));
+}
+
+void testRoundTrip()
+{
+    testDiag("==== testRoundTrip ====");
+
+    TestControl ctrl;
+    pvd::ByteBuffer buf(1024);
+    pvd::StructureConstPtr A(makeType(1)), B(makeType(2));
+    pvd::int16 keyA=0, keyB=0, key=0;
+
+    testEqual(serializeOne(ctrl, buf, A, &keyA), pva::IntrospectionRegistry::FULL_WITH_ID_TYPE_CODE);
+    buf.setPosition(0);
+    testOk1(*ctrl.cachedDeserialize(&buf)==*A);
+
+    testEqual(serializeOne(ctrl, buf, B, &keyB), pva::IntrospectionRegistry::FULL_WITH_ID_TYPE_CODE);
+    testOk1(keyA!=keyB);
+
+    testEqual(serializeOne(ctrl, buf, makeType(1), &key), pva::IntrospectionRegistry::ONLY_ID_TYPE_CODE);
+    testEqual(key, keyA);
+    buf.setPosition(0);
+    testOk1(*ctrl.cachedDeserialize(&buf)==*A);
+
+    testEqual(ctrl.outgoing.size(), 2u);
+    testEqual(ctrl.incoming.size(), 1u);
+
+    ctrl.outgoing.reset();
+    testEqual(serializeOne(ctrl, buf, A), pva::IntrospectionRegistry::FULL_WITH_ID_TYPE_CODE);
+}
+
+// time to lookup an already registered type, as the number of registered types grows
+void benchmarkLookup()
+{
+    testDiag("==== benchmarkLookup ====");
+
+    static const size_t counts[] = {10, 100, 1000, 4000};
+    const size_t nlookups = 20000;
+
+    std::vector<pvd::FieldConstPtr> types;
+    types.reserve(counts[NELEMENTS(counts)-1]);
+    for(size_t i=0; i<counts[NELEMENTS(counts)-1]; i++)
+        types.push_back(makeType(i));
+
+    pvd::ByteBuffer buf(1024);
+
+    for(size_t c=0; c<NELEMENTS(counts); c++) {
+        const size_t ntypes = counts[c];
+        TestControl ctrl;
+
+        for(size_t i=0; i<ntypes; i++)
+            serializeOne(ctrl, buf, types[i]);
+
+        bool ok = true;
+        epicsTimeStamp start, end;
+        epicsTimeGetCurrent(&start);
+        for(size_t i=0; i<nlookups; i++)
+            ok &= serializeOne(ctrl, buf, types[i%ntypes])==pva::IntrospectionRegistry::ONLY_ID_TYPE_CODE;
+        epicsTimeGetCurrent(&end);
+
+        testOk(ok, "%u types registered, all cache hits", unsigned(ntypes));
+        testDiag("%u types: %.3f us per lookup", unsigned(ntypes),
+                 epicsTimeDiffInSeconds(&end, &start)*1e6/nlookups);
+    }
+}
+
+} // namespace
+
+MAIN(testIntrospectionRegistry)
+{
+    testPlan(19);
+    testHash();
+    testRoundTrip();
+    benchmarkLookup();
+    return testDone();
+}
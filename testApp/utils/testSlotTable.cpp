@@ -0,0 +1,189 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+#include <map>
+#include <set>
+
+#include <epicsTime.h>
+#include <testMain.h>
+
+#include <pv/pvUnitTest.h>
+#include <pv/sharedPtr.h>
+#include <pv/slotTable.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+typedef pva::slot_table<int> table_t;
+
+void testBasic()
+{
+    testDiag("==== testBasic ====");
+
+    table_t table;
+    testEqual(table.size(), 0u);
+
+    table_t::key_type A = table.insert(1),
+                      B = table.insert(2);
+    testOk1(A!=0u && B!=0u && A!=B);
+    testEqual(table.size(), 2u);
+
+    int val = 0;
+    testOk1(table.find(A, val) && val==1);
+    testOk1(table.find(B, val) && val==2);
+    testOk1(!table.find(0u, val));
+    testOk1(!table.find(0xffffffffu, val));
+
+    testOk1(table.set(A, 3));
+    testOk1(table.find(A, val) && val==3);
+
+    testOk1(table.remove(A, val) && val==3);
+    testOk1(!table.find(A, val));
+    testOk1(!table.remove(A));
+    testOk1(!table.set(A, 4));
+    testEqual(table.size(), 1u);
+
+    // reserved key has a default value until set()
+    table_t::key_type C = table.allocate();
+    testOk1(table.find(C, val) && val==0);
+
+    std::vector<int> vals;
+    table.values(vals);
+    testEqual(vals.size(), 2u);
+
+    vals.clear();
+    table.clear(vals);
+    testEqual(vals.size(), 2u);
+    testEqual(table.size(), 0u);
+    testOk1(!table.find(B, val));
+    testOk1(table.find(table.insert(5), val) && val==5);
+}
+
+// a freed slot is re-used with a different key
+void testStale()
+{
+    testDiag("==== testStale ====");
+
+    table_t table;
+    table_t::key_type A = table.insert(1);
+    table.remove(A);
+
+    table_t::key_type B = table.insert(2);
+    testEqual(B&table_t::indexMask, A&table_t::indexMask);
+    testOk1(A!=B);
+
+    int val = 0;
+    testOk1(!table.find(A, val));
+    testOk1(!table.remove(A));
+    testOk1(table.find(B, val) && val==2);
+}
+
+// weak_ptr values, as used by client context
+void testWeak()
+{
+    testDiag("==== testWeak ====");
+
+    pva::slot_table<std::tr1::weak_ptr<int> > table;
+    std::tr1::shared_ptr<int> P(new int(42));
+
+    pva::slot_table<std::tr1::weak_ptr<int> >::key_type K = table.insert(P);
+
+    std::tr1::weak_ptr<int> W;
+    testOk1(table.find(K, W) && W.lock()==P);
+    P.reset();
+    testOk1(table.find(K, W) && !W.lock());
+}
+
+void testMany()
+{
+    testDiag("==== testMany ====");
+
+    table_t table;
+    std::set<table_t::key_type> keys;
+    std::vector<table_t::key_type> order;
+
+    const size_t N = 5000u;
+    for(size_t i=0; i<N; i++) {
+        table_t::key_type K = table.insert(int(i));
+        keys.insert(K);
+        order.push_back(K);
+    }
+    testEqual(keys.size(), N);
+    testEqual(table.size(), N);
+
+    bool ok = true;
+    for(size_t i=0; i<N; i++) {
+        int val = -1;
+        ok &= table.find(order[i], val) && val==int(i);
+    }
+    testOk(ok, "all found");
+
+    for(size_t i=0; i<N; i+=2)
+        ok &= table.remove(order[i]);
+    testOk(ok, "half removed");
+    testEqual(table.size(), N/2u);
+
+    for(size_t i=0; i<N; i++) {
+        int val = -1;
+        ok &= table.find(order[i], val)==((i&1u)!=0u);
+    }
+    testOk(ok, "remaining found");
+}
+
+// lookup time vs. the std::map previously used for CID/IOID
+void benchmarkLookup()
+{
+    testDiag("==== benchmarkLookup ====");
+
+    const size_t N = 200000u, nlookups = 1000000u;
+
+    table_t table;
+    std::map<table_t::key_type, int> map;
+    std::vector<table_t::key_type> keys;
+    keys.reserve(N);
+    for(size_t i=0; i<N; i++) {
+        table_t::key_type K = table.insert(int(i));
+        map[K] = int(i);
+        keys.push_back(K);
+    }
+
+    epicsTimeStamp start, mid, end;
+    size_t sumT = 0u, sumM = 0u;
+
+    epicsTimeGetCurrent(&start);
+    for(size_t i=0; i<nlookups; i++) {
+        int val = 0;
+        table.find(keys[(i*7919u)%N], val);
+        sumT += size_t(val);
+    }
+    epicsTimeGetCurrent(&mid);
+    for(size_t i=0; i<nlookups; i++) {
+        std::map<table_t::key_type, int>::const_iterator it(map.find(keys[(i*7919u)%N]));
+        sumM += size_t(it->second);
+    }
+    epicsTimeGetCurrent(&end);
+
+    testEqual(sumT, sumM);
+    testDiag("%u entries: slot_table %.3f us, std::map %.3f us per lookup", unsigned(N),
+             epicsTimeDiffInSeconds(&mid, &start)*1e6/nlookups,
+             epicsTimeDiffInSeconds(&end, &mid)*1e6/nlookups);
+}
+
+} // namespace
+
+MAIN(testSlotTable)
+{
+    testPlan(33);
+    testBasic();
+    testStale();
+    testWeak();
+    testMany();
+    benchmarkLookup();
+    return testDone();
+}